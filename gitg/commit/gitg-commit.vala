@@ -29,6 +29,9 @@ namespace GitgCommit
 		private ulong d_externally_changed_id;
 		private bool d_ignore_external_changes;
 		private Gitg.WhenMapped? d_reload_when_mapped;
+		private Gitg.StageStatusCache? d_status_cache;
+		private Cancellable? d_diff_cancellable;
+		private string? d_sidebar_state;
 
 		private enum UiType
 		{
@@ -189,18 +192,36 @@ namespace GitgCommit
 			};
 		}
 
+		/* Cancels the diff being computed, if any, for a new one. */
+		private Cancellable next_diff_cancellable()
+		{
+			if (d_diff_cancellable != null)
+			{
+				d_diff_cancellable.cancel();
+			}
+
+			d_diff_cancellable = new Cancellable();
+			return d_diff_cancellable;
+		}
+
 		private void show_unstaged_diff_intern(Gitg.Repository         repository,
 		                                       Gitg.DiffView           view,
 		                                       Gitg.StageStatusItem[]? items,
 		                                       bool                    patchable)
 		{
 			var stage = repository.stage;
+			var cancellable = next_diff_cancellable();
 
-			stage.diff_workdir_all.begin(items, view.options, (obj, res) => {
+			stage.diff_workdir_all.begin(items, view.options, cancellable, (obj, res) => {
 				try
 				{
 					var d = stage.diff_workdir_all.end(res);
 
+					if (cancellable.is_cancelled())
+					{
+						return;
+					}
+
 					view.unstaged = patchable;
 					view.staged = false;
 
@@ -223,11 +244,13 @@ namespace GitgCommit
 
 		private void stage_submodule_at(Gitg.Commit commit)
 		{
+			var path = d_current_submodule.path;
+
 			stage_submodule.begin(d_current_submodule, commit, (obj, res) => {
 				stage_submodule.end(res);
 
 				d_ignore_external_changes = true;
-				reload();
+				reload_paths(new string[] {path});
 			});
 		}
 
@@ -360,7 +383,7 @@ namespace GitgCommit
 				}
 			}
 
-			reload();
+			reload_paths(item_paths(items));
 		}
 
 		private void show_ui(UiType type)
@@ -587,12 +610,18 @@ namespace GitgCommit
 		                                     bool                    patchable)
 		{
 			var stage = repository.stage;
+			var cancellable = next_diff_cancellable();
 
-			stage.diff_index_all.begin(items, view.options, (obj, res) => {
+			stage.diff_index_all.begin(items, view.options, cancellable, (obj, res) => {
 				try
 				{
 					var d = stage.diff_index_all.end(res);
 
+					if (cancellable.is_cancelled())
+					{
+						return;
+					}
+
 					view.unstaged = false;
 					view.staged = patchable;
 
@@ -686,9 +715,11 @@ namespace GitgCommit
 			else
 			{
 				d_ignore_external_changes = true;
+				var path = d_current_submodule.path;
+
 				unstage_submodule.begin(d_current_submodule, (obj, res) => {
 					unstage_submodule.end(res);
-					reload();
+					reload_paths(new string[] {path});
 				});
 			}
 		}
@@ -720,7 +751,7 @@ namespace GitgCommit
 				}
 			}
 
-			reload();
+			reload_paths(item_paths(items));
 		}
 
 		private void on_staged_activated(Gitg.StageStatusItem[] items)
@@ -767,35 +798,95 @@ namespace GitgCommit
 			return ret;
 		}
 
-		private void reload()
+		private Gitg.StageStatusCache status_cache(Gitg.Repository repository)
 		{
-			d_reload_when_mapped = null;
+			if (d_status_cache == null || d_status_cache.repository != repository)
+			{
+				var opts = Ggit.StatusOption.INCLUDE_UNTRACKED |
+				           Ggit.StatusOption.RECURSE_UNTRACKED_DIRS |
+				           Ggit.StatusOption.SORT_CASE_INSENSITIVELY |
+				           Ggit.StatusOption.EXCLUDE_SUBMODULES |
+				           Ggit.StatusOption.DISABLE_PATHSPEC_MATCH;
+
+				var show = Ggit.StatusShow.INDEX_AND_WORKDIR;
+
+				d_status_cache = new Gitg.StageStatusCache(repository, opts, show);
+			}
+
+			return d_status_cache;
+		}
+
+		/* Describes what the sidebar shows for @items, to skip rebuilding it
+		 * when nothing changed.
+		 */
+		private string sidebar_state(Gitg.StageStatusItem[] items)
+		{
+			var states = new Gee.ArrayList<string>();
+
+			foreach (var item in items)
+			{
+				var sub = item as Gitg.StageStatusSubmodule;
+
+				states.add("%s:%d%d%d%d:%s".printf(item.path,
+				                                   (int)item.is_staged,
+				                                   (int)item.is_unstaged,
+				                                   (int)item.is_untracked,
+				                                   sub != null ? (sub.is_dirty ? 2 : 1) : 0,
+				                                   item.icon_name ?? ""));
+			}
 
+			states.sort();
+
+			var ret = new StringBuilder(d_main.commit_files_search_entry.text);
+
+			foreach (var state in states)
+			{
+				ret.append_c('\n');
+				ret.append(state);
+			}
+
+			return ret.str;
+		}
+
+		/* Reloads the status of all files. */
+		private void reload()
+		{
 			var repository = application.repository;
 
-			if (repository == null || d_reloading)
+			if (repository != null)
 			{
-				return;
+				status_cache(repository).invalidate();
 			}
 
-			d_reloading = true;
+			update_status();
+		}
 
-			var sb = d_main.sidebar;
-			var model = sb.model;
+		/* Reloads the status of @paths only, for changes made by gitg itself. */
+		private void reload_paths(string[] paths)
+		{
+			var repository = application.repository;
 
-			Sidebar.Item.Type selected_type;
-			Gitg.StageStatusItem[] selected_items;
+			if (repository != null)
+			{
+				status_cache(repository).invalidate_paths(paths);
+			}
 
-			selected_items = items_for_items(sb.get_selected_items<Gitg.SidebarItem>(),
-			                                 out selected_type);
+			update_status();
+		}
 
-			var selected_paths = new Gee.HashSet<string>();
+		private void update_status()
+		{
+			d_reload_when_mapped = null;
 
-			foreach (var item in selected_items)
+			var repository = application.repository;
+
+			if (repository == null || d_reloading)
 			{
-				selected_paths.add(item.path);
+				return;
 			}
 
+			d_reloading = true;
+
 			if (d_main.diff_view.use_gravatar)
 			{
 				// Preload author avatar
@@ -810,267 +901,299 @@ namespace GitgCommit
 				} catch {}
 			}
 
-			var stage = repository.stage;
+			var cache = status_cache(repository);
+			var shown = false;
 
-			var opts = Ggit.StatusOption.INCLUDE_UNTRACKED |
-			           Ggit.StatusOption.RECURSE_UNTRACKED_DIRS |
-			           Ggit.StatusOption.SORT_CASE_INSENSITIVELY |
-			           Ggit.StatusOption.EXCLUDE_SUBMODULES |
-			           Ggit.StatusOption.DISABLE_PATHSPEC_MATCH;
+			cache.update.begin((items) => {
+				shown = show_status(items);
+			}, (obj, res) => {
+				var items = cache.update.end(res);
 
-			var show = Ggit.StatusShow.INDEX_AND_WORKDIR;
+				d_reloading = false;
 
-			var options = new Ggit.StatusOptions(opts, show, null);
-			var enumerator = stage.file_status(options);
+				if (!show_status(items) && !shown)
+				{
+					// Same files in the same state, only the diff of the
+					// selected files may have changed
+					sidebar_selection_changed(d_main.sidebar.get_selected_items<Gitg.SidebarItem>());
+				}
+			});
+		}
 
-			enumerator.next_items.begin(-1, (obj, res) => {
-				var items = enumerator.next_items.end(res);
+		/* Shows @items in the sidebar, returns false if it already showed
+		 * them.
+		 */
+		private bool show_status(Gitg.StageStatusItem[] items)
+		{
+			var state = sidebar_state(items);
 
-				var staged = new Gitg.StageStatusItem[items.length];
-				staged.length = 0;
+			if (state == d_sidebar_state)
+			{
+				return false;
+			}
 
-				var unstaged = new Gitg.StageStatusItem[items.length];
-				unstaged.length = 0;
+			d_sidebar_state = state;
 
-				var untracked = new Gitg.StageStatusItem[items.length];
-				untracked.length = 0;
+			var sb = d_main.sidebar;
+			var model = sb.model;
 
-				var dirty = new Gitg.StageStatusItem[items.length];
-				dirty.length = 0;
+			Sidebar.Item.Type selected_type;
+			Gitg.StageStatusItem[] selected_items;
 
-				bool hassub = false;
+			selected_items = items_for_items(sb.get_selected_items<Gitg.SidebarItem>(),
+			                                 out selected_type);
 
-				foreach (var item in items)
+			var selected_paths = new Gee.HashSet<string>();
+
+			foreach (var item in selected_items)
+			{
+				selected_paths.add(item.path);
+			}
+
+			var staged = new Gitg.StageStatusItem[items.length];
+			staged.length = 0;
+
+			var unstaged = new Gitg.StageStatusItem[items.length];
+			unstaged.length = 0;
+
+			var untracked = new Gitg.StageStatusItem[items.length];
+			untracked.length = 0;
+
+			var dirty = new Gitg.StageStatusItem[items.length];
+			dirty.length = 0;
+
+			bool hassub = false;
+
+			foreach (var item in items)
+			{
+				if (item.is_staged)
 				{
-					if (item.is_staged)
+					staged += item;
+				}
+
+				if (item.is_unstaged)
+				{
+					unstaged += item;
+				}
+
+				if (item.is_untracked)
+				{
+					untracked += item;
+				}
+
+				var sub = item as Gitg.StageStatusSubmodule;
+
+				if (sub != null)
+				{
+					hassub = true;
+
+					if (sub.is_dirty)
 					{
-						staged += item;
+						dirty += item;
 					}
+				}
+			}
 
-					if (item.is_unstaged)
+			model.clear();
+			d_main.diff_view.diff = null;
+
+			var current_staged = new Sidebar.Item[0];
+			var current_unstaged = new Sidebar.Item[0];
+			var current_untracked = new Sidebar.Item[0];
+			var current_submodules = new Sidebar.Item[0];
+
+			// Populate staged items
+			var staged_header = model.begin_header(_("Staged"), (uint)Sidebar.Item.Type.STAGED);
+
+			staged_header.activated.connect((numclick) => {
+				on_unstage_selected_items();
+			});
+
+			if (staged.length == 0)
+			{
+				model.append_dummy(_("No staged files"));
+			}
+			else
+			{
+				current_staged = append_items(model,
+				                              staged,
+				                              Sidebar.Item.Type.STAGED,
+				                              selected_paths,
+				                              (item) => {
+					if (d_main.sidebar.is_selected(item))
 					{
-						unstaged += item;
+						on_unstage_selected_items();
 					}
-
-					if (item.is_untracked)
+					else
 					{
-						untracked += item;
+						on_staged_activated(new Gitg.StageStatusItem[] {item.item});
 					}
+				});
+			}
 
-					var sub = item as Gitg.StageStatusSubmodule;
+			model.end_header();
 
-					if (sub != null)
-					{
-						hassub = true;
+			// Populate unstaged items
+			var unstaged_header = model.begin_header(_("Unstaged"), (uint)Sidebar.Item.Type.UNSTAGED);
 
-						if (sub.is_dirty)
-						{
-							dirty += item;
-						}
-					}
-				}
+			unstaged_header.activated.connect((numclick) => {
+				on_stage_selected_items();
+			});
 
-				model.clear();
-				d_main.diff_view.diff = null;
+			if (unstaged.length == 0)
+			{
+				model.append_dummy(_("No unstaged files"));
+			}
+			else
+			{
+				current_unstaged = append_items(model,
+				                                unstaged,
+				                                Sidebar.Item.Type.UNSTAGED,
+				                                selected_paths,
+				                                (item) => {
+					if (d_main.sidebar.is_selected(item))
+					{
+						on_stage_selected_items();
+					}
+					else
+					{
+						on_unstaged_activated(new Gitg.StageStatusItem[] {item.item});
+					}
+				});
+			}
 
-				var current_staged = new Sidebar.Item[0];
-				var current_unstaged = new Sidebar.Item[0];
-				var current_untracked = new Sidebar.Item[0];
-				var current_submodules = new Sidebar.Item[0];
+			model.end_header();
 
-				// Populate staged items
-				var staged_header = model.begin_header(_("Staged"), (uint)Sidebar.Item.Type.STAGED);
+			// Populate untracked items
+			model.begin_header(_("Untracked"), (uint)Sidebar.Item.Type.UNTRACKED);
 
-				staged_header.activated.connect((numclick) => {
-					on_unstage_selected_items();
+			if (untracked.length == 0)
+			{
+				model.append_dummy(_("No untracked files"));
+			}
+			else
+			{
+				current_untracked = append_items(model,
+				                                 untracked,
+				                                 Sidebar.Item.Type.UNTRACKED,
+				                                 selected_paths,
+				                                 (item) => {
+					if (d_main.sidebar.is_selected(item))
+					{
+						on_stage_selected_items();
+					}
+					else
+					{
+						on_unstaged_activated(new Gitg.StageStatusItem[] {item.item});
+					}
 				});
+			}
+
+			model.end_header();
+
+			// Populate submodule items
+			if (hassub)
+			{
+				model.begin_header(_("Submodule"), (uint)Sidebar.Item.Type.SUBMODULE);
 
-				if (staged.length == 0)
+				if (dirty.length == 0)
 				{
-					model.append_dummy(_("No staged files"));
+					model.append_dummy(_("No dirty submodules"));
 				}
 				else
 				{
-					current_staged = append_items(model,
-					                              staged,
-					                              Sidebar.Item.Type.STAGED,
-					                              selected_paths,
-					                              (item) => {
-						if (d_main.sidebar.is_selected(item))
-						{
-							on_unstage_selected_items();
-						}
-						else
-						{
-							on_staged_activated(new Gitg.StageStatusItem[] {item.item});
+					current_submodules = append_items(model,
+					                                  dirty,
+					                                  Sidebar.Item.Type.SUBMODULE,
+					                                  selected_paths,
+					                                  (item) => {
+					    if (d_main.sidebar.is_selected(item))
+					    {
+					    	on_stage_selected_items();
+					    }
+					    else
+					    {
+							on_unstaged_activated(new Gitg.StageStatusItem[] {item.item});
 						}
 					});
 				}
 
 				model.end_header();
+			}
 
-				// Populate unstaged items
-				var unstaged_header = model.begin_header(_("Unstaged"), (uint)Sidebar.Item.Type.UNSTAGED);
+			d_main.sidebar.expand_all();
+			d_has_staged = staged.length != 0;
 
-				unstaged_header.activated.connect((numclick) => {
-					on_stage_selected_items();
-				});
+			if (selected_paths.size != 0)
+			{
+				Sidebar.Item[] sel = null;
 
-				if (unstaged.length == 0)
+				switch (selected_type)
 				{
-					model.append_dummy(_("No unstaged files"));
+				case Sidebar.Item.Type.STAGED:
+					sel = current_staged;
+					break;
+				case Sidebar.Item.Type.UNSTAGED:
+					sel = current_unstaged;
+					break;
+				case Sidebar.Item.Type.UNTRACKED:
+					sel = current_untracked;
+					break;
+				case Sidebar.Item.Type.SUBMODULE:
+					sel = current_submodules;
+					break;
 				}
-				else
+
+				if (sel == null || sel.length == 0)
 				{
-					current_unstaged = append_items(model,
-					                                unstaged,
-					                                Sidebar.Item.Type.UNSTAGED,
-					                                selected_paths,
-					                                (item) => {
-						if (d_main.sidebar.is_selected(item))
-						{
-							on_stage_selected_items();
-						}
-						else
-						{
-							on_unstaged_activated(new Gitg.StageStatusItem[] {item.item});
-						}
-					});
+					sel = current_staged;
 				}
 
-				model.end_header();
-
-				// Populate untracked items
-				model.begin_header(_("Untracked"), (uint)Sidebar.Item.Type.UNTRACKED);
-
-				if (untracked.length == 0)
+				if (sel == null || sel.length == 0)
 				{
-					model.append_dummy(_("No untracked files"));
+					sel = current_unstaged;
 				}
-				else
+
+				if (sel == null || sel.length == 0)
 				{
-					current_untracked = append_items(model,
-					                                 untracked,
-					                                 Sidebar.Item.Type.UNTRACKED,
-					                                 selected_paths,
-					                                 (item) => {
-						if (d_main.sidebar.is_selected(item))
-						{
-							on_stage_selected_items();
-						}
-						else
-						{
-							on_unstaged_activated(new Gitg.StageStatusItem[] {item.item});
-						}
-					});
+					sel = current_untracked;
 				}
 
-				model.end_header();
-
-				// Populate submodule items
-				if (hassub)
+				if (sel == null || sel.length == 0)
 				{
-					model.begin_header(_("Submodule"), (uint)Sidebar.Item.Type.SUBMODULE);
-
-					if (dirty.length == 0)
-					{
-						model.append_dummy(_("No dirty submodules"));
-					}
-					else
-					{
-						current_submodules = append_items(model,
-						                                  dirty,
-						                                  Sidebar.Item.Type.SUBMODULE,
-						                                  selected_paths,
-						                                  (item) => {
-						    if (d_main.sidebar.is_selected(item))
-						    {
-						    	on_stage_selected_items();
-						    }
-						    else
-						    {
-								on_unstaged_activated(new Gitg.StageStatusItem[] {item.item});
-							}
-						});
-					}
-
-					model.end_header();
+					sel = current_submodules;
 				}
 
-				d_main.sidebar.expand_all();
-				d_has_staged = staged.length != 0;
-
-				d_reloading = false;
-
-				if (selected_paths.size != 0)
+				if (sel != null && sel.length != 0)
 				{
-					Sidebar.Item[] sel = null;
-
-					switch (selected_type)
-					{
-					case Sidebar.Item.Type.STAGED:
-						sel = current_staged;
-						break;
-					case Sidebar.Item.Type.UNSTAGED:
-						sel = current_unstaged;
-						break;
-					case Sidebar.Item.Type.UNTRACKED:
-						sel = current_untracked;
-						break;
-					case Sidebar.Item.Type.SUBMODULE:
-						sel = current_submodules;
-						break;
-					}
-
-					if (sel == null || sel.length == 0)
-					{
-						sel = current_staged;
-					}
-
-					if (sel == null || sel.length == 0)
-					{
-						sel = current_unstaged;
-					}
-
-					if (sel == null || sel.length == 0)
+					foreach (var item in sel)
 					{
-						sel = current_untracked;
-					}
-
-					if (sel == null || sel.length == 0)
-					{
-						sel = current_submodules;
-					}
-
-					if (sel != null && sel.length != 0)
-					{
-						foreach (var item in sel)
-						{
-							d_main.sidebar.select(item);
-						}
-					}
-					else if (selected_type == Sidebar.Item.Type.STAGED)
-					{
-						d_main.sidebar.select(staged_header);
-					}
-					else
-					{
-						d_main.sidebar.select(unstaged_header);
+						d_main.sidebar.select(item);
 					}
 				}
+				else if (selected_type == Sidebar.Item.Type.STAGED)
+				{
+					d_main.sidebar.select(staged_header);
+				}
 				else
 				{
-					// Select staged/unstaged header
-					if (unstaged.length == 0)
-					{
-						d_main.sidebar.select(staged_header);
-					}
-					else
-					{
-						d_main.sidebar.select(unstaged_header);
-					}
+					d_main.sidebar.select(unstaged_header);
 				}
-			});
+			}
+			else
+			{
+				// Select staged/unstaged header
+				if (unstaged.length == 0)
+				{
+					d_main.sidebar.select(staged_header);
+				}
+				else
+				{
+					d_main.sidebar.select(unstaged_header);
+				}
+			}
+
+			return true;
 		}
 
 		public void activate()
@@ -1278,24 +1401,44 @@ namespace GitgCommit
 			}
 		}
 
+		private string[] item_paths(Gitg.StageStatusItem[] items)
+		{
+			var ret = new string[items.length];
+
+			for (var i = 0; i < items.length; i++)
+			{
+				ret[i] = items[i].path;
+			}
+
+			return ret;
+		}
+
+		private string[] selection_paths()
+		{
+			var ret = new string[0];
+
+			foreach (var pset in d_main.diff_view.get_selection())
+			{
+				ret += pset.filename;
+			}
+
+			return ret;
+		}
+
 		private async void stage_unstage_selection(bool staging) throws Error
 		{
 			var selection = d_main.diff_view.get_selection();
 			var stage = application.repository.stage;
 
-			foreach (var pset in selection)
+			if (staging)
 			{
-				if (pset.patches.length == 0)
-					continue;
-				if (staging)
-				{
-					yield stage.stage_patch(pset);
-				}
-				else
-				{
-					yield stage.unstage_patch(pset);
-				}
+				yield stage.stage_patches(selection);
 			}
+			else
+			{
+				yield stage.unstage_patches(selection);
+			}
+
 			d_main.diff_view.clear_selection();
 		}
 
@@ -1304,10 +1447,7 @@ namespace GitgCommit
 			var selection = d_main.diff_view.get_selection();
 			var stage = application.repository.stage;
 
-			foreach (var pset in selection)
-			{
-				yield stage.revert_patch(pset);
-			}
+			yield stage.revert_patches(selection);
 		}
 
 		private void on_discard_clicked()
@@ -1344,6 +1484,8 @@ namespace GitgCommit
 		{
 			application.busy = true;
 
+			var paths = selection_paths();
+
 			d_ignore_external_changes = true;
 			discard_selection.begin((obj, res) => {
 				try
@@ -1360,7 +1502,7 @@ namespace GitgCommit
 				q.quit();
 				application.busy = false;
 
-				reload();
+				reload_paths(paths);
 			});
 
 			return false;
@@ -1370,6 +1512,8 @@ namespace GitgCommit
 		{
 			var staging = d_main.diff_view.unstaged;
 
+			var paths = selection_paths();
+
 			d_ignore_external_changes = true;
 			stage_unstage_selection.begin(staging, (obj, res) => {
 				try
@@ -1393,7 +1537,7 @@ namespace GitgCommit
 					return;
 				}
 
-				reload();
+				reload_paths(paths);
 			});
 		}
 
@@ -1454,7 +1598,7 @@ namespace GitgCommit
 				application.busy = false;
 				q.quit();
 
-				reload();
+				reload_paths(paths);
 			});
 
 			return false;
@@ -1569,7 +1713,7 @@ namespace GitgCommit
 				application.busy = false;
 				q.quit();
 
-				reload();
+				reload_paths(item_paths(items));
 			});
 
 			return false;
@@ -1768,6 +1912,8 @@ namespace GitgCommit
 
 			if (sitems.length == 0)
 			{
+				next_diff_cancellable();
+
 				show_ui(UiType.DIFF);
 				d_main.diff_view.diff = null;
 				return;
@@ -1890,7 +2036,7 @@ namespace GitgCommit
 
 			d_main.commit_files_search_bar.connect_entry(d_main.commit_files_search_entry);
 			d_main.commit_files_search_entry.search_changed.connect((entry) => {
-				reload();
+				update_status();
 			});
 			d_main.commit_files_search_entry.stop_search.connect((entry) => {
 				d_main.commit_files_search_bar.search_mode_enabled = true;
@@ -33,6 +33,7 @@ public class Application : Gtk.Application
 	private static bool standalone = false;
 	private static ApplicationCommandLine app_command_line;
 	private static bool init = false;
+	private static string? trace_file = null;
 
 	private const OptionEntry[] entries = {
 		{"version", 'v', OptionFlags.NO_ARG, OptionArg.CALLBACK,
@@ -47,6 +48,8 @@ public class Application : Gtk.Application
 		 ref standalone, N_("Run gitg in standalone mode"), null},
 		{"init", 0, 0, OptionArg.NONE,
 		 ref init, N_("Put paths under git if needed"), null},
+		{"trace", 0, 0, OptionArg.FILENAME,
+		 ref trace_file, N_("Write a trace of where time is spent to FILE, for chrome://tracing or Perfetto"), N_("FILE")},
 		{null}
 	};
 
@@ -160,6 +163,13 @@ public class Application : Gtk.Application
 			return true;
 		}
 
+		var trace = trace_file != null ? trace_file : Environment.get_variable("GITG_TRACE");
+
+		if (trace != null && trace != "")
+		{
+			Gitg.Trace.start(trace);
+		}
+
 		return base.local_command_line(ref arguments, out exit_status);
 	}
 
@@ -382,6 +392,8 @@ public class Application : Gtk.Application
 	protected override void startup()
 	{
 		base.startup();
+		Gitg.Trace.mark("startup");
+
 		Hdy.init ();
 		var style_manager = Hdy.StyleManager.get_default();
 		style_manager.color_scheme = PREFER_LIGHT;
@@ -468,6 +480,8 @@ public class Application : Gtk.Application
 	{
 		d_state_settings.apply();
 		base.shutdown();
+
+		Gitg.Trace.stop();
 	}
 
 	private void activate_command_line(GitgExt.CommandLines command_lines)
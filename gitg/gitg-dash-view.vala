@@ -28,6 +28,7 @@ class DashView : Gtk.Grid, GitgExt.UIElement, GitgExt.Activity, GitgExt.Selectab
 	public GitgExt.Application? application { owned get; construct set; }
 
 	private bool d_setting_mode;
+	private Gtk.MessageDialog? d_scan_dialog;
 
 	[GtkChild( name = "introduction" )]
 	private unowned Gtk.Grid d_introduction;
@@ -509,42 +510,27 @@ class DashView : Gtk.Grid, GitgExt.UIElement, GitgExt.Activity, GitgExt.Selectab
 		       location.get_child("refs").query_exists();
 	}
 
-	private async bool file_exists_async(File file, Cancellable? cancellable)
+	protected bool scan_visit_directory(File file, Gee.Set<string> names)
 	{
-		try
-		{
-			return (yield file.query_info_async(FileAttribute.STANDARD_TYPE, FileQueryInfoFlags.NONE, Priority.DEFAULT, cancellable)) != null;
-		}
-		catch
+		// Check for .git, or for a bare repository
+		if (names.contains(".git") ||
+		    (names.contains("objects") && names.contains("HEAD") && names.contains("refs")))
 		{
+			do_add_repository(file, false);
 			return false;
 		}
+
+		return true;
 	}
 
-	protected async bool scan_visit_directory(File file, Cancellable? cancellable)
+	protected void scan_progress(uint n_scanned)
 	{
-		if (cancellable != null && cancellable.is_cancelled())
-		{
-			return false;
-		}
-
-		// Check for .git
-		if ((yield file_exists_async(file.get_child(".git"), cancellable)))
-		{
-			do_add_repository(file, false);
-			return false;
-		}
-
-		// Check for bare
-		if ((yield file_exists_async(file.get_child("objects"), cancellable)) &&
-		    (yield file_exists_async(file.get_child("HEAD"), cancellable)) &&
-		    (yield file_exists_async(file.get_child("refs"), cancellable)))
+		if (d_scan_dialog != null)
 		{
-			do_add_repository(file, false);
-			return false;
+			d_scan_dialog.secondary_text = ngettext("%u folder scanned",
+			                                        "%u folders scanned",
+			                                        n_scanned).printf(n_scanned);
 		}
-
-		return scan_visit_directory_default(file);
 	}
 
 	private void add_repositories_scan(File location)
@@ -576,7 +562,14 @@ class DashView : Gtk.Grid, GitgExt.UIElement, GitgExt.Activity, GitgExt.Selectab
 			return false;
 		});
 
+		d_scan_dialog = dlg;
+
 		scan.begin(location, cancellable, () => {
+			if (d_scan_dialog == dlg)
+			{
+				d_scan_dialog = null;
+			}
+
 			if (timeout_id != 0)
 			{
 				timeout_id = 0;
@@ -20,10 +20,17 @@
 namespace Gitg
 {
 
+/* Only the builtin plugins providing command line options are loaded right
+ * away, they are needed to parse the command line. The others are loaded by
+ * load_deferred, which windows call once they have painted their content,
+ * so that plugins do not delay the first paint at startup.
+ */
 public class PluginsEngine : Peas.Engine
 {
 	private static PluginsEngine s_instance;
 
+	private Peas.PluginInfo[] d_deferred;
+
 	construct
 	{
 		enable_loader("python");
@@ -58,10 +65,45 @@ public class PluginsEngine : Peas.Engine
 			}
 		}
 
+		d_deferred = new Peas.PluginInfo[0];
+
 		foreach (var info in builtins)
+		{
+			if (info.get_external_data("CommandLine") != null)
+			{
+				load_plugin(info);
+			}
+			else
+			{
+				d_deferred += info;
+			}
+		}
+	}
+
+	/**
+	 * Load the builtin plugins which were not loaded at startup.
+	 *
+	 * Extension sets already created get the extensions of these plugins
+	 * added to them.
+	 */
+	public void load_deferred()
+	{
+		if (d_deferred.length == 0)
+		{
+			return;
+		}
+
+		var span = Trace.begin();
+		var deferred = (owned)d_deferred;
+
+		d_deferred = new Peas.PluginInfo[0];
+
+		foreach (var info in deferred)
 		{
 			load_plugin(info);
 		}
+
+		Trace.end_detail(span, "PluginsEngine.load_deferred", "%d plugins", deferred.length);
 	}
 
 	public new static PluginsEngine get_default()
@@ -19,6 +19,12 @@
 namespace Gitg
 {
 
+/* Monitors a directory and its subdirectories. Changes are classified as
+ * soon as they are reported, and collected into a set of changed files
+ * which is emitted once changes stop coming in for a moment. Directories
+ * which are classified as GitgExt.ExternalChangeHint.NONE are not
+ * monitored.
+ */
 class RecursiveMonitor : Object
 {
 	class Monitor : Object
@@ -33,21 +39,54 @@ class RecursiveMonitor : Object
 		}
 	}
 
-	public delegate bool FilterFunc(File file);
+	// Emit once there were no changes for this long
+	private const int QUIET_MS = 200;
+
+	// ... but do not delay changes longer than this when they keep coming in
+	private const int MAX_DELAY_MS = 2000;
+
+	// Maximum number of changed files kept, the hints are always complete
+	public const int MAX_CHANGED_FILES = 1000;
+
+	public delegate GitgExt.ExternalChangeHint ClassifyFunc(File file);
 
 	private FileMonitor? d_monitor;
 	private Gee.List<Monitor> d_sub_monitors;
 	private uint d_monitor_changed_timeout_id;
-	private FilterFunc? d_filter_func;
+	private ClassifyFunc? d_classify_func;
 	private Cancellable d_cancellable;
-	private File[] d_changed_files;
-
-	public signal void changed(File[] files);
+	private weak RecursiveMonitor? d_root;
+
+	private Gee.HashSet<File> d_changed_files;
+	private GitgExt.ExternalChangeHint d_changed_hint;
+	private int64 d_first_change;
+	private int64 d_last_change;
+
+	/**
+	 * Emitted when files changed.
+	 *
+	 * @param files the changed files, which may be incomplete when many
+	 *              files changed at once.
+	 * @param hint the classification of all changed files.
+	 */
+	public signal void changed(File[] files, GitgExt.ExternalChangeHint hint);
+
+	public RecursiveMonitor(File location, owned ClassifyFunc? classify_func = null)
+	{
+		this.with_root(location, null, (owned)classify_func);
+	}
 
-	public RecursiveMonitor(File location, owned FilterFunc? filter_func = null)
+	private RecursiveMonitor.with_root(File location, RecursiveMonitor? root, owned ClassifyFunc? classify_func)
 	{
-		d_filter_func = (owned)filter_func;
+		d_classify_func = (owned)classify_func;
 		d_sub_monitors = new Gee.LinkedList<Monitor>();
+		d_root = root;
+
+		if (root == null)
+		{
+			d_changed_files = new Gee.HashSet<File>((Gee.HashDataFunc<File>)File.hash,
+			                                        (Gee.EqualDataFunc<File>)File.equal);
+		}
 
 		try
 		{
@@ -101,19 +140,28 @@ class RecursiveMonitor : Object
 		}
 	}
 
+	private GitgExt.ExternalChangeHint classify(File file)
+	{
+		if (d_classify_func == null)
+		{
+			return GitgExt.ExternalChangeHint.REFS | GitgExt.ExternalChangeHint.INDEX;
+		}
+
+		return d_classify_func(file);
+	}
+
 	private void add_submonitor(File location)
 	{
-		if (d_filter_func != null && !d_filter_func(location))
+		if (classify(location) == GitgExt.ExternalChangeHint.NONE)
 		{
 			return;
 		}
 
-		var mon = new RecursiveMonitor(location, (l) => {
-			return d_filter_func(l);
+		var mon = new RecursiveMonitor.with_root(location, d_root != null ? d_root : this, (l) => {
+			return classify(l);
 		});
 
 		d_sub_monitors.add(new Monitor(location, mon));
-		mon.changed.connect((files) => { changed_timeout(files); });
 	}
 
 	private void add_submonitor_if_directory(File location)
@@ -142,6 +190,7 @@ class RecursiveMonitor : Object
 		{
 			if (location.equal(monitor.location))
 			{
+				monitor.monitor.cancel();
 				d_sub_monitors.remove(monitor);
 				return;
 			}
@@ -168,35 +217,70 @@ class RecursiveMonitor : Object
 			}
 		}
 
-		changed_timeout(new File[] { file, other_file });
+		// Changes of all subdirectories are collected by the root monitor
+		var root = d_root != null ? d_root : this;
+
+		root.add_changed(file);
+
+		if (other_file != null)
+		{
+			root.add_changed(other_file);
+		}
 	}
 
-	private void changed_timeout(File?[] files)
+	private void add_changed(File file)
 	{
-		foreach (var f in files)
+		var hint = classify(file);
+
+		if (hint == GitgExt.ExternalChangeHint.NONE)
 		{
-			if (f != null && (d_filter_func == null || d_filter_func(f)))
-			{
-				d_changed_files += f;
-			}
+			return;
 		}
 
-		if (d_monitor_changed_timeout_id != 0)
+		d_changed_hint |= hint;
+
+		if (d_changed_files.size < MAX_CHANGED_FILES)
 		{
-			return;
+			d_changed_files.add(file);
 		}
 
-		if (d_changed_files.length > 0)
+		d_last_change = get_monotonic_time();
+
+		if (d_monitor_changed_timeout_id == 0)
 		{
-			d_monitor_changed_timeout_id = Timeout.add_seconds(1, () => {
-				d_monitor_changed_timeout_id = 0;
+			d_first_change = d_last_change;
+			d_monitor_changed_timeout_id = Timeout.add(QUIET_MS, changed_timeout);
+		}
+	}
 
-				changed(d_changed_files);
-				d_changed_files = new File[0];
+	private bool changed_timeout()
+	{
+		var now = get_monotonic_time();
+		var quiet = (now - d_last_change) / 1000;
+		var waited = (now - d_first_change) / 1000;
 
-				return false;
-			});
+		if (quiet < QUIET_MS && waited < MAX_DELAY_MS)
+		{
+			// Changes are still coming in, wait for them to settle
+			var delay = int64.min(QUIET_MS - quiet, MAX_DELAY_MS - waited);
+
+			d_monitor_changed_timeout_id = Timeout.add((uint)int64.max(delay, 1), changed_timeout);
+			return false;
 		}
+
+		d_monitor_changed_timeout_id = 0;
+
+		var files = d_changed_files.to_array();
+		var hint = d_changed_hint;
+
+		d_changed_files.clear();
+		d_changed_hint = GitgExt.ExternalChangeHint.NONE;
+
+		// The whole burst, from the first change until it settled
+		Gitg.Trace.end_detail(d_first_change, "RecursiveMonitor.changes", "%d files", files.length);
+
+		changed(files, hint);
+		return false;
 	}
 
 	public void cancel()
@@ -19,85 +19,391 @@
 namespace Gitg
 {
 
+/* The state of a scan. Directories are visited breadth first by a bounded
+ * number of concurrent enumerators. What was found in each directory is
+ * recorded with the modification time of the directory, so that a later
+ * scan of the same location does not enumerate directories again which
+ * did not change.
+ */
+class RecursiveScan : Object
+{
+	private const int MAX_ENUMERATORS = 8;
+
+	public const string ATTRIBUTES = FileAttribute.STANDARD_NAME + "," +
+	                                 FileAttribute.STANDARD_TYPE + "," +
+	                                 FileAttribute.TIME_MODIFIED + "," +
+	                                 FileAttribute.TIME_MODIFIED_USEC + "," +
+	                                 FileAttribute.UNIX_DEVICE + "," +
+	                                 FileAttribute.UNIX_INODE;
+
+	// Directories which are big and very unlikely to contain repositories
+	public const string[] HEAVY_DIRECTORIES = {
+		"node_modules",
+		"bower_components",
+		"__pycache__",
+		"site-packages",
+		"venv"
+	};
+
+	public class Entry
+	{
+		public uint64 mtime;
+		public bool is_repository;
+		public string[] children;
+
+		public Entry(uint64 mtime, bool is_repository, string[] children)
+		{
+			this.mtime = mtime;
+			this.is_repository = is_repository;
+			this.children = children;
+		}
+	}
+
+	private class Task
+	{
+		public File location;
+		public FileInfo? info;
+
+		public Task(File location, FileInfo? info)
+		{
+			this.location = location;
+			this.info = info;
+		}
+	}
+
+	private RecursiveScanner d_scanner;
+	private File d_root;
+	private string d_cache_path;
+	private Gee.HashMap<string, Entry> d_previous;
+	private Gee.HashMap<string, Entry> d_entries;
+	private Gee.HashSet<string> d_seen;
+
+	private Gee.ArrayQueue<Task> d_queue;
+	private int d_running;
+	private SourceFunc? d_callback;
+
+	public Cancellable? cancellable;
+	public uint n_scanned;
+
+	public RecursiveScan(RecursiveScanner scanner, File root, Cancellable? cancellable)
+	{
+		d_scanner = scanner;
+		d_root = root;
+		this.cancellable = cancellable;
+
+		d_entries = new Gee.HashMap<string, Entry>();
+		d_seen = new Gee.HashSet<string>();
+		d_queue = new Gee.ArrayQueue<Task>();
+
+		d_cache_path = Path.build_filename(Environment.get_user_cache_dir(),
+		                                   "gitg",
+		                                   "repository-scan",
+		                                   Checksum.compute_for_string(ChecksumType.SHA1, root.get_uri()));
+
+		d_previous = load();
+	}
+
+	public bool is_cancelled
+	{
+		get { return cancellable != null && cancellable.is_cancelled(); }
+	}
+
+	public static uint64 mtime_of(FileInfo info)
+	{
+		return info.get_attribute_uint64(FileAttribute.TIME_MODIFIED) * 1000000 +
+		       info.get_attribute_uint32(FileAttribute.TIME_MODIFIED_USEC);
+	}
+
+	/* Whether the directory was seen already, through another path. */
+	public bool check_seen(FileInfo info)
+	{
+		if (!info.has_attribute(FileAttribute.UNIX_INODE))
+		{
+			return false;
+		}
+
+		var key = "%u:%s".printf(info.get_attribute_uint32(FileAttribute.UNIX_DEVICE),
+		                         info.get_attribute_uint64(FileAttribute.UNIX_INODE).to_string());
+
+		if (d_seen.contains(key))
+		{
+			return true;
+		}
+
+		d_seen.add(key);
+		return false;
+	}
+
+	/* Gets what @location contained when it was last scanned, if it did
+	 * not change since.
+	 */
+	public Entry? lookup(File location, uint64 mtime)
+	{
+		var entry = d_previous[location.get_path()];
+
+		if (entry != null && entry.mtime == mtime)
+		{
+			return entry;
+		}
+
+		return null;
+	}
+
+	public void record(File location, Entry entry)
+	{
+		d_entries[location.get_path()] = entry;
+	}
+
+	public void add(File location, FileInfo? info)
+	{
+		d_queue.offer(new Task(location, info));
+		start_next();
+	}
+
+	private void start_next()
+	{
+		while (d_running < MAX_ENUMERATORS && !d_queue.is_empty && !is_cancelled)
+		{
+			var task = d_queue.poll();
+			d_running++;
+
+			d_scanner.scan_directory.begin(this, task.location, task.info, task.location.equal(d_root), (obj, res) => {
+				d_scanner.scan_directory.end(res);
+
+				n_scanned++;
+				d_running--;
+
+				start_next();
+			});
+		}
+
+		if (d_running == 0 && (d_queue.is_empty || is_cancelled) && d_callback != null)
+		{
+			var cb = (owned)d_callback;
+			d_callback = null;
+
+			Idle.add((owned)cb);
+		}
+	}
+
+	/* Waits for all queued directories to be visited. */
+	public async void run()
+	{
+		d_callback = run.callback;
+		start_next();
+
+		yield;
+
+		if (!is_cancelled)
+		{
+			save();
+		}
+	}
+
+	private Gee.HashMap<string, Entry> load()
+	{
+		var ret = new Gee.HashMap<string, Entry>();
+
+		try
+		{
+			var bytes = new MappedFile(d_cache_path, false).get_bytes();
+			var v = new Variant.from_bytes(new VariantType("a(stbas)"), bytes, false);
+
+			foreach (var item in v)
+			{
+				ret[item.get_child_value(0).get_string()] = new Entry(item.get_child_value(1).get_uint64(),
+				                                                      item.get_child_value(2).get_boolean(),
+				                                                      item.get_child_value(3).dup_strv());
+			}
+		} catch {}
+
+		return ret;
+	}
+
+	private void save()
+	{
+		var builder = new VariantBuilder(new VariantType("a(stbas)"));
+
+		foreach (var item in d_entries.entries)
+		{
+			builder.add_value(new Variant.tuple(new Variant[] {
+				new Variant.string(item.key),
+				new Variant.uint64(item.value.mtime),
+				new Variant.boolean(item.value.is_repository),
+				new Variant.strv(item.value.children)
+			}));
+		}
+
+		var v = builder.end();
+
+		try
+		{
+			DirUtils.create_with_parents(Path.get_dirname(d_cache_path), 0700);
+			FileUtils.set_data(d_cache_path, v.get_data_as_bytes().get_data());
+		}
+		catch (Error e)
+		{
+			stderr.printf("Failed to save the repository scan cache: %s\n", e.message);
+		}
+	}
+}
+
 interface RecursiveScanner : Object
 {
-	protected async virtual void scan_visit_file(File file, Cancellable? cancellable)
+	/* Whether the directory named @name should not be scanned at all. */
+	protected virtual bool scan_prune_directory(string name)
 	{
+		return name.has_prefix(".") || name in RecursiveScan.HEAVY_DIRECTORIES;
 	}
 
-	protected bool scan_visit_directory_default(File file)
+	/* Visits a scanned directory which contains @names. Returns whether its
+	 * subdirectories should be scanned as well.
+	 */
+	protected virtual bool scan_visit_directory(File file, Gee.Set<string> names)
 	{
-		return !file.get_basename().has_prefix(".");
+		return true;
 	}
 
-	protected async virtual bool scan_visit_directory(File file, Cancellable? cancellable)
+	/* Called regularly while scanning, with the number of directories
+	 * scanned so far.
+	 */
+	protected virtual void scan_progress(uint n_scanned)
 	{
-		return scan_visit_directory_default(file);
 	}
 
 	public async void scan(File location, Cancellable? cancellable = null)
 	{
-		yield scan_real(location, cancellable, new Gee.HashSet<File>((file) => { return file.hash(); }, (file, other) => { return file.equal(other); }));
+		var state = new RecursiveScan(this, location, cancellable);
+
+		state.add(location, null);
+		yield state.run();
+
+		scan_progress(state.n_scanned);
 	}
 
-	private async void scan_real(File location, Cancellable? cancellable, Gee.HashSet<File> seen)
+	internal async void scan_directory(RecursiveScan state, File location, FileInfo? info, bool is_root)
 	{
-		if (cancellable != null && cancellable.is_cancelled())
+		if (state.is_cancelled)
 		{
 			return;
 		}
 
+		if ((state.n_scanned % 100) == 0)
+		{
+			scan_progress(state.n_scanned);
+		}
+
+		if (info == null)
+		{
+			try
+			{
+				info = yield location.query_info_async(RecursiveScan.ATTRIBUTES,
+				                                       FileQueryInfoFlags.NOFOLLOW_SYMLINKS,
+				                                       Priority.DEFAULT,
+				                                       state.cancellable);
+			} catch { return; }
+
+			if (state.check_seen(info))
+			{
+				return;
+			}
+		}
+
+		var mtime = RecursiveScan.mtime_of(info);
+		var entry = state.lookup(location, mtime);
+
+		if (entry != null)
+		{
+			// Not changed since the last scan, visit the repository again or
+			// the same subdirectories without enumerating
+			state.record(location, entry);
+
+			var names = new Gee.HashSet<string>();
+
+			if (entry.is_repository)
+			{
+				names.add(".git");
+			}
+
+			if (!is_root && !scan_visit_directory(location, names))
+			{
+				return;
+			}
+
+			foreach (var child in entry.children)
+			{
+				state.add(location.get_child(child), null);
+			}
+
+			return;
+		}
+
 		FileEnumerator? e;
 
 		try
 		{
-			e = yield location.enumerate_children_async(FileAttribute.STANDARD_NAME + "," + FileAttribute.STANDARD_TYPE,
-		                                                FileQueryInfoFlags.NOFOLLOW_SYMLINKS,
-		                                                Priority.DEFAULT,
-		                                                cancellable);
+			e = yield location.enumerate_children_async(RecursiveScan.ATTRIBUTES,
+			                                            FileQueryInfoFlags.NOFOLLOW_SYMLINKS,
+			                                            Priority.DEFAULT,
+			                                            state.cancellable);
 		} catch { return; }
 
-		while (cancellable == null || !cancellable.is_cancelled())
+		var names = new Gee.HashSet<string>();
+		var directories = new Gee.ArrayList<FileInfo>();
+
+		while (!state.is_cancelled)
 		{
 			List<FileInfo>? files = null;
 
 			try
 			{
-				files = yield e.next_files_async(10, Priority.DEFAULT);
+				files = yield e.next_files_async(100, Priority.DEFAULT, state.cancellable);
 			} catch {}
 
-			if (files == null) {
+			if (files == null)
+			{
 				break;
 			}
 
 			foreach (var f in files)
 			{
-				var file = location.get_child(f.get_name());
+				var name = f.get_name();
+				names.add(name);
 
-				if (seen.contains(file))
+				if (f.get_file_type() == FileType.DIRECTORY && !scan_prune_directory(name))
 				{
-					continue;
+					directories.add(f);
 				}
+			}
+		}
 
-				seen.add(file);
+		try
+		{
+			yield e.close_async(Priority.DEFAULT, state.cancellable);
+		} catch {}
 
-				yield scan_visit_file(file, cancellable);
+		if (state.is_cancelled)
+		{
+			return;
+		}
 
-				if (f.get_file_type() == FileType.DIRECTORY)
-				{
-					if (!(yield scan_visit_directory(file, cancellable)))
-					{
-						continue;
-					}
+		// Do not descend into repositories
+		var descend = is_root || scan_visit_directory(location, names);
+		var children = new string[0];
 
-					yield scan_real(file, cancellable, seen);
+		if (descend)
+		{
+			foreach (var f in directories)
+			{
+				if (!state.check_seen(f))
+				{
+					children += f.get_name();
+					state.add(location.get_child(f.get_name()), f);
 				}
 			}
 		}
 
-		try {
-			yield e.close_async(Priority.DEFAULT, cancellable);
-		} catch {}
+		state.record(location, new RecursiveScan.Entry(mtime, !descend, children));
 	}
 }
 
@@ -26,6 +26,9 @@ public class Window : Gtk.ApplicationWindow, GitgExt.Application, Initable
 	// Do this to pull in config.h before glib.h (for gettext...)
 	private const string version = Gitg.Config.VERSION;
 
+	// Time to wait at most for the first commits at startup, in milliseconds
+	private const uint STARTUP_TIMEOUT = 1000;
+
 	private Settings d_state_settings;
 	private Settings d_interface_settings;
 	private Repository? d_repository;
@@ -43,6 +46,17 @@ public class Window : Gtk.ApplicationWindow, GitgExt.Application, Initable
 	private GitgExt.SelectionMode d_selectable_mode;
 
 	private UIElements<GitgExt.Activity> d_activities;
+	private GitgHistory.Activity d_history;
+
+	/* Startup is finished once the window painted the first commits of the
+	 * history, the plugins, the repository monitor and the dash are only
+	 * set up then.
+	 */
+	private bool d_started;
+	private bool d_drawn;
+	private ulong d_commits_shown_id;
+	private uint d_startup_timeout_id;
+	private uint d_startup_id;
 
 	private RemoteManager d_remote_manager;
 	private Notifications d_notifications;
@@ -580,7 +594,11 @@ public class Window : Gtk.ApplicationWindow, GitgExt.Application, Initable
 			d_dash_button.show();
 			d_clone_button.hide();
 			d_add_button.hide();
-			d_dash_view.add_repository(d_repository);
+
+			if (d_started)
+			{
+				d_dash_view.add_repository(d_repository);
+			}
 
 			d_gear_menu.menu_model = d_activities_model;
 			gear_image.set_from_icon_name ("view-more-symbolic", BUTTON);
@@ -628,6 +646,116 @@ public class Window : Gtk.ApplicationWindow, GitgExt.Application, Initable
 		base.realize();
 	}
 
+	protected override bool draw(Cairo.Context cr)
+	{
+		var ret = base.draw(cr);
+
+		if (!d_drawn)
+		{
+			d_drawn = true;
+			Gitg.Trace.mark("first paint");
+
+			if (d_repository == null || d_history.commits_shown)
+			{
+				schedule_startup();
+			}
+			else
+			{
+				d_commits_shown_id = d_history.notify["commits-shown"].connect(schedule_startup);
+
+				// Do not wait for a history which is slow to load
+				d_startup_timeout_id = Timeout.add(STARTUP_TIMEOUT, () => {
+					d_startup_timeout_id = 0;
+					schedule_startup();
+
+					return false;
+				});
+			}
+		}
+
+		return ret;
+	}
+
+	private void schedule_startup()
+	{
+		if (d_commits_shown_id != 0)
+		{
+			d_history.disconnect(d_commits_shown_id);
+			d_commits_shown_id = 0;
+		}
+
+		if (d_startup_timeout_id != 0)
+		{
+			Source.remove(d_startup_timeout_id);
+			d_startup_timeout_id = 0;
+		}
+
+		if (d_started || d_startup_id != 0)
+		{
+			return;
+		}
+
+		// At a low priority, so that the first commits are painted before
+		d_startup_id = Idle.add(() => {
+			d_startup_id = 0;
+			finish_startup();
+
+			return false;
+		}, Priority.LOW);
+	}
+
+	private void finish_startup()
+	{
+		var span = Gitg.Trace.begin();
+
+		d_started = true;
+
+		PluginsEngine.get_default().load_deferred();
+
+		var app = application as Gitg.Application;
+
+		if (app != null)
+		{
+			foreach (var element in d_history.d_panels.get_available_elements())
+			{
+				app.register_shortcut(element.display_name, element.shortcut);
+			}
+		}
+
+		update_enable_monitoring();
+
+		if (d_repository != null)
+		{
+			d_dash_view.add_repository(d_repository);
+		}
+
+		Gitg.Trace.end(span, "Window.finish_startup");
+		Gitg.Trace.mark("startup finished");
+	}
+
+	protected override void destroy()
+	{
+		if (d_commits_shown_id != 0)
+		{
+			d_history.disconnect(d_commits_shown_id);
+			d_commits_shown_id = 0;
+		}
+
+		if (d_startup_timeout_id != 0)
+		{
+			Source.remove(d_startup_timeout_id);
+			d_startup_timeout_id = 0;
+		}
+
+		if (d_startup_id != 0)
+		{
+			Source.remove(d_startup_id);
+			d_startup_id = 0;
+		}
+
+		base.destroy();
+	}
+
 	protected override bool window_state_event(Gdk.EventWindowState event)
 	{
 		d_state_settings.set_int("state", event.new_window_state);
@@ -651,10 +779,13 @@ public class Window : Gtk.ApplicationWindow, GitgExt.Application, Initable
 		var l = d_repository.get_location();
 
 		var refs = l.get_child("refs");
+		var logs = l.get_child("logs");
 		var index = l.get_child("index");
 		var head = l.get_child("HEAD");
 
-		if (location.equal(refs) || location.has_prefix(refs) || location.equal(head))
+		if (location.equal(refs) || location.has_prefix(refs) ||
+		    location.equal(logs) || location.has_prefix(logs) ||
+		    location.equal(head) || location.get_basename().has_prefix("packed-refs"))
 		{
 			return GitgExt.ExternalChangeHint.REFS;
 		}
@@ -669,9 +800,61 @@ public class Window : Gtk.ApplicationWindow, GitgExt.Application, Initable
 
 	}
 
-	private bool filter_repository_changes(File location)
+	/* The names of the refs which changed, from the changed files of the
+	 * repository monitor, or null if they are not known.
+	 */
+	private string[]? ref_names_from_files(File[] files)
 	{
-		return external_change_hint_from_file(location) != GitgExt.ExternalChangeHint.NONE;
+		if (files.length >= RecursiveMonitor.MAX_CHANGED_FILES)
+		{
+			return null;
+		}
+
+		var l = d_repository.get_location();
+		var logs = l.get_child("logs");
+		var names = new Gee.HashSet<string>();
+
+		foreach (var file in files)
+		{
+			string? name;
+
+			if (file.has_prefix(logs))
+			{
+				name = logs.get_relative_path(file);
+			}
+			else
+			{
+				name = l.get_relative_path(file);
+			}
+
+			if (name == null)
+			{
+				continue;
+			}
+
+			if (name.has_suffix(".lock"))
+			{
+				name = name.substring(0, name.length - 5);
+			}
+
+			if (name == "packed-refs")
+			{
+				// Any ref may have been packed, moved or removed
+				return null;
+			}
+
+			if (name == "refs" || name == "logs")
+			{
+				return null;
+			}
+
+			if (name == "HEAD" || name.has_prefix("refs/"))
+			{
+				names.add(name);
+			}
+		}
+
+		return names.to_array();
 	}
 
 	private void set_repository_internal(Repository? repository)
@@ -717,15 +900,14 @@ public class Window : Gtk.ApplicationWindow, GitgExt.Application, Initable
 			d_repository_monitor = null;
 		}
 
-		if (enable_monitoring && d_repository != null)
+		// The monitor is only started once the startup finished
+		if (enable_monitoring && d_repository != null && d_started)
 		{
-			d_repository_monitor = new RecursiveMonitor(d_repository.get_location(), filter_repository_changes);
-			d_repository_monitor.changed.connect((files) => {
-				var hint = GitgExt.ExternalChangeHint.NONE;
-
-				foreach (var f in files)
+			d_repository_monitor = new RecursiveMonitor(d_repository.get_location(), external_change_hint_from_file);
+			d_repository_monitor.changed.connect((files, hint) => {
+				if ((hint & GitgExt.ExternalChangeHint.REFS) != 0)
 				{
-					hint |= external_change_hint_from_file(f);
+					d_repository.invalidate_refs(ref_names_from_files(files));
 				}
 
 				repository_changed_externally(hint);
@@ -981,12 +1163,9 @@ public class Window : Gtk.ApplicationWindow, GitgExt.Application, Initable
 		                                                             extset,
 		                                                             d_stack_activities);
 
-		var history_panels = ((GitgHistory.Activity) builtins[0]).d_panels;
-
-		foreach(var element in history_panels.get_available_elements())
-		{
-			app.register_shortcut(element.display_name, element.shortcut);
-		};
+		// The shortcuts of the history panels are registered once the
+		// plugins providing them are loaded, see finish_startup
+		d_history = (GitgHistory.Activity)builtins[0];
 
 		d_activities.notify["current"].connect(on_current_activity_changed);
 
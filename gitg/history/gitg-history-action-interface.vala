@@ -42,21 +42,21 @@ class ActionInterface : Object, GitgExt.RefActionInterface
 
 	public void add_ref(Gitg.Ref reference)
 	{
-		application.repository.clear_refs_cache();
+		application.repository.invalidate_refs(new string[] {reference.get_name()});
 		d_refs_list.add_ref(reference);
 		updated();
 	}
 
 	public void remove_ref(Gitg.Ref reference)
 	{
-		application.repository.clear_refs_cache();
+		application.repository.invalidate_refs(new string[] {reference.get_name()});
 		d_refs_list.remove_ref(reference);
 		updated();
 	}
 
 	public void replace_ref(Gitg.Ref old_ref, Gitg.Ref new_ref)
 	{
-		application.repository.clear_refs_cache();
+		application.repository.invalidate_refs(new string[] {old_ref.get_name(), new_ref.get_name()});
 		d_refs_list.replace_ref(old_ref, new_ref);
 		updated();
 	}
@@ -153,33 +153,46 @@ private class RefRow : RefTyped, Gtk.ListBoxRow
 			{
 				var upstream = branch.get_upstream();
 
-				size_t ahead = 0;
-				size_t behind = 0;
+				var local_id = reference.resolve().get_target();
+				var upstream_id = upstream.resolve().get_target();
+				var cache = reference.get_owner().ahead_behind;
 
-				reference.get_owner().get_ahead_behind(reference.resolve().get_target(),
-				                                       upstream.resolve().get_target(),
-				                                       out ahead,
-				                                       out behind);
+				size_t ahead;
+				size_t behind;
 
-				if (ahead != 0 || behind != 0)
+				if (cache.cached(local_id, upstream_id, out ahead, out behind))
 				{
-					if (ahead != 0 && behind != 0)
-					{
-						d_ahead_behind.label = _("%zu ahead, %zu behind").printf(ahead, behind);
-					}
-					else if (ahead != 0)
-					{
-						d_ahead_behind.label = _("%zu ahead").printf(ahead);
-					}
-					else
-					{
-						d_ahead_behind.label = _("%zu behind").printf(behind);
-					}
+					update_ahead_behind(ahead, behind);
+				}
+				else
+				{
+					cache.lookup.begin(local_id, upstream_id, (obj, res) => {
+						if (cache.lookup.end(res, out ahead, out behind))
+						{
+							update_ahead_behind(ahead, behind);
+						}
+					});
 				}
 			} catch {}
 		}
 	}
 
+	private void update_ahead_behind(size_t ahead, size_t behind)
+	{
+		if (ahead != 0 && behind != 0)
+		{
+			d_ahead_behind.label = _("%zu ahead, %zu behind").printf(ahead, behind);
+		}
+		else if (ahead != 0)
+		{
+			d_ahead_behind.label = _("%zu ahead").printf(ahead);
+		}
+		else if (behind != 0)
+		{
+			d_ahead_behind.label = _("%zu behind").printf(behind);
+		}
+	}
+
 	public Ggit.Signature? updated
 	{
 		get { return d_updated; }
@@ -556,6 +569,9 @@ public class RefsList : Gtk.ListBox
 
 	private Gitg.Repository? d_repository;
 	private Gee.HashMap<Gitg.Ref, RefRow> d_ref_map;
+	private Gee.HashMap<string, Gitg.Ref> d_ref_names;
+	private Gee.HashSet<string>? d_changed_refs;
+	private ulong d_refs_invalidated_id;
 	private Gtk.ListBoxRow? d_selected_row;
 	private Gitg.Remote[] d_remotes;
 	private RefRow? d_all_commits;
@@ -603,13 +619,31 @@ public class RefsList : Gtk.ListBox
 		get { return d_repository; }
 		set
 		{
+			if (d_repository != null)
+			{
+				d_repository.disconnect(d_refs_invalidated_id);
+				d_refs_invalidated_id = 0;
+			}
+
 			d_repository = value;
+
+			if (d_repository != null)
+			{
+				d_refs_invalidated_id = d_repository.refs_invalidated.connect(on_refs_invalidated);
+			}
+
 			refresh();
 		}
 	}
 
 	protected override void dispose()
 	{
+		if (d_repository != null && d_refs_invalidated_id != 0)
+		{
+			d_repository.disconnect(d_refs_invalidated_id);
+			d_refs_invalidated_id = 0;
+		}
+
 		foreach (var remote in d_remotes)
 		{
 			remote.tip_updated.disconnect(on_tip_updated);
@@ -624,6 +658,7 @@ public class RefsList : Gtk.ListBox
 	{
 		d_header_map = new Gee.HashMap<string, RemoteHeader>();
 		d_ref_map = new Gee.HashMap<Gitg.Ref, RefRow>();
+		d_ref_names = new Gee.HashMap<string, Gitg.Ref>();
 		selection_mode = Gtk.SelectionMode.BROWSE;
 		d_remotes = new Gitg.Remote[0];
 
@@ -823,6 +858,7 @@ public class RefsList : Gtk.ListBox
 
 		d_header_map = new Gee.HashMap<string, RemoteHeader>();
 		d_ref_map = new Gee.HashMap<Gitg.Ref, RefRow>();
+		d_ref_names = new Gee.HashMap<string, Gitg.Ref>();
 
 		foreach (var child in get_children())
 		{
@@ -931,42 +967,100 @@ public class RefsList : Gtk.ListBox
 	                            Ggit.OId    a,
 	                            Ggit.OId    b)
 	{
-		if (a.is_zero())
+		var names = new string[] {refname};
+
+		repository.invalidate_refs(names);
+		update_refs(names);
+	}
+
+	private void on_refs_invalidated(string[]? names)
+	{
+		if (names == null)
+		{
+			d_changed_refs = null;
+		}
+		else if (d_changed_refs != null)
 		{
-			Gitg.Ref reference;
+			foreach (var name in names)
+			{
+				d_changed_refs.add(name);
+			}
+		}
+	}
 
-			repository.clear_refs_cache();
+	/**
+	 * Apply the changes of the refs invalidated in the repository since the
+	 * last update.
+	 *
+	 * Only the rows of the refs which changed are added, removed or
+	 * replaced. Everything is refreshed when it is not known which refs
+	 * changed, or when HEAD changed since that changes which row is the
+	 * head.
+	 */
+	public void update()
+	{
+		if (d_repository == null)
+		{
+			return;
+		}
+
+		if (d_changed_refs == null || d_changed_refs.contains("HEAD"))
+		{
+			refresh();
+			return;
+		}
+
+		var names = d_changed_refs.to_array();
+		d_changed_refs.clear();
+
+		update_refs(names);
+	}
+
+	private static bool same_target(Gitg.Ref a, Gitg.Ref b)
+	{
+		var ta = a.get_target();
+		var tb = b.get_target();
+
+		if (ta == null || tb == null)
+		{
+			return ta == null && tb == null && a.get_symbolic_target() == b.get_symbolic_target();
+		}
+
+		return ta.equal(tb);
+	}
+
+	private void update_refs(string[] names)
+	{
+		foreach (var name in names)
+		{
+			var old = d_ref_names[name];
+			Gitg.Ref? r = null;
 
 			try
 			{
-				reference = repository.lookup_reference(refname);
-			}
-			catch (Error e)
+				r = d_repository.lookup_reference(name);
+			} catch {}
+
+			if (r != null && (ref_is_a_symbolic_head(r) || (filter_unknown_refs && ref_is_filtered(r))))
 			{
-				stderr.printf("Failed to lookup new reference '%s': %s\n", refname, e.message);
-				return;
+				r = null;
 			}
 
-			add_ref(reference);
-		}
-		else if (b.is_zero())
-		{
-			// Reference was removed, we need to find it by name
-			foreach (var reference in d_ref_map.keys)
+			if (old == null)
 			{
-				if (reference.get_name() == refname)
+				if (r != null)
 				{
-					repository.clear_refs_cache();
-					remove_ref(reference);
-					break;
+					add_ref(r);
 				}
 			}
-		}
-		else
-		{
-			// Ref just got updated, we should already have it. Just emit changed.
-			repository.clear_refs_cache();
-			changed();
+			else if (r == null)
+			{
+				remove_ref(old);
+			}
+			else if (!same_target(old, r))
+			{
+				replace_ref(old, r);
+			}
 		}
 	}
 
@@ -1011,6 +1105,7 @@ public class RefsList : Gtk.ListBox
 		if (reference != null)
 		{
 			d_ref_map[reference] = row;
+			d_ref_names[reference.get_name()] = reference;
 		}
 
 		return row;
@@ -1125,6 +1220,11 @@ public class RefsList : Gtk.ListBox
 
 		d_ref_map.unset(reference);
 
+		if (d_ref_names[reference.get_name()] == reference)
+		{
+			d_ref_names.unset(reference.get_name());
+		}
+
 		if (reference.parsed_name.rtype == Gitg.RefType.REMOTE)
 		{
 			var remote = reference.parsed_name.remote_name;
@@ -1195,21 +1295,19 @@ public class RefsList : Gtk.ListBox
 	{
 		// Find by name because the supplied reference might be a separate
 		// instance
-		var refname = reference.get_name();
+		var ourref = d_ref_names[reference.get_name()];
 
-		foreach (var ourref in d_ref_map.keys)
+		if (ourref == null)
 		{
-			if (ourref.get_name() == refname)
-			{
-				var row = d_ref_map[ourref];
-
-				select_row(row);
-				scroll_to_row(row);
-				return true;
-			}
+			return false;
 		}
 
-		return false;
+		var row = d_ref_map[ourref];
+
+		select_row(row);
+		scroll_to_row(row);
+
+		return true;
 	}
 
 	private void store_expanded_state()
@@ -1238,6 +1336,7 @@ public class RefsList : Gtk.ListBox
 		store_expanded_state();
 
 		clear();
+		d_changed_refs = new Gee.HashSet<string>();
 
 		if (d_repository == null)
 		{
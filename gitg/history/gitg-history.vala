@@ -57,6 +57,11 @@ namespace GitgHistory
 
 		private string[] d_mainline;
 		private bool d_ignore_external;
+		private bool d_incremental_reload;
+
+		private string? d_search_key;
+		private Gee.HashSet<uint>? d_search_rows;
+		private Cancellable? d_search_cancellable;
 
 		private Gitg.UIElements<GitgExt.HistoryPanel> _d_panels;
 
@@ -65,6 +70,12 @@ namespace GitgHistory
 			get { return _d_panels; }
 		}
 
+		/* Whether the first commits were shown, set once the first batch of
+		 * commits is in the list. The window waits for it at startup before
+		 * loading the rest.
+		 */
+		public bool commits_shown { get; private set; }
+
 		public Activity(GitgExt.Application application)
 		{
 			Object(application: application);
@@ -149,9 +160,17 @@ namespace GitgHistory
 			                                       (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
 
 			d_commit_list_model = new Gitg.CommitModel(application.repository);
+			d_commit_list_model.search_index_enabled = true;
 			d_commit_list_model.started.connect(on_commit_model_started);
 			d_commit_list_model.finished.connect(on_commit_model_finished);
 
+			d_commit_list_model.update.connect((added) => {
+				if (added > 0)
+				{
+					set_commits_shown();
+				}
+			});
+
 			update_sort_mode();
 
 			d_repository = application.repository;
@@ -161,6 +180,21 @@ namespace GitgHistory
 
 			reload_mainline();
 
+			// A dismissed search is not searched for again on reloads
+			notify["search-visible"].connect(() => {
+				if (!search_visible)
+				{
+					clear_search();
+				}
+			});
+
+			notify["search-text"].connect(() => {
+				if (search_text == "")
+				{
+					clear_search();
+				}
+			});
+
 			d_externally_changed_id = application.repository_changed_externally.connect(repository_changed_externally);
 			d_commits_changed_id = application.repository_commits_changed.connect(repository_commits_changed);
 		}
@@ -169,7 +203,7 @@ namespace GitgHistory
 		{
 			if (d_main != null && (hint & GitgExt.ExternalChangeHint.REFS) != 0  && !d_ignore_external)
 			{
-				reload_when_mapped();
+				update_when_mapped();
 			}
 
 			d_ignore_external = false;
@@ -197,6 +231,31 @@ namespace GitgHistory
 			}
 		}
 
+		/* Like reload_when_mapped, but keeps the repository and the current
+		 * history and only updates them for the changed refs.
+		 */
+		private void update_when_mapped()
+		{
+			if (d_main != null)
+			{
+				d_reload_when_mapped = new Gitg.WhenMapped(d_main);
+
+				d_reload_when_mapped.update(() => {
+					if (d_repository == null)
+					{
+						return;
+					}
+
+					d_incremental_reload = true;
+
+					d_main.refs_list.update();
+					d_main.commit_list_view.queue_draw();
+
+					update_walker_idle();
+				}, this);
+			}
+		}
+
 		public override void dispose()
 		{
 			if (d_refs_list_selection_id != 0)
@@ -317,14 +376,32 @@ namespace GitgHistory
 			}
 		}
 
+		private void set_commits_shown()
+		{
+			if (!commits_shown)
+			{
+				Gitg.Trace.mark("first commits");
+				commits_shown = true;
+			}
+		}
+
 		private void on_commit_model_finished(Gitg.CommitModel model)
 		{
+			set_commits_shown();
+
 			if (d_insertsig != 0)
 			{
 				d_commit_list_model.disconnect(d_insertsig);
 				d_insertsig = 0;
 			}
 
+			if (d_search_key != null && search_visible)
+			{
+				// The rows have changed, refresh the matches without moving
+				// the cursor
+				start_search(d_search_key, false);
+			}
+
 			scroll_into_view();
 		}
 
@@ -1165,7 +1242,16 @@ namespace GitgHistory
 
 			d_commit_list_model.set_permanent_lanes(permanent);
 			d_commit_list_model.set_include(include.to_array());
-			d_commit_list_model.reload();
+
+			if (d_incremental_reload)
+			{
+				d_incremental_reload = false;
+				d_commit_list_model.reload_incremental();
+			}
+			else
+			{
+				d_commit_list_model.reload();
+			}
 		}
 
 		private void on_ref_list_row_activated(Gtk.ListBoxRow row)
@@ -1196,46 +1282,126 @@ namespace GitgHistory
 			}
 		}
 
-		private string normalize(string s)
+		private void start_search(string key, bool jump)
 		{
-			return s.normalize(-1, NormalizeMode.ALL).casefold();
+			if (d_search_cancellable != null)
+			{
+				d_search_cancellable.cancel();
+			}
+
+			var index = d_commit_list_model.search_index;
+
+			d_search_key = key;
+			d_search_rows = null;
+
+			if (index == null)
+			{
+				d_search_cancellable = null;
+				return;
+			}
+
+			var cancellable = new Cancellable();
+			d_search_cancellable = cancellable;
+
+			index.search.begin(key, cancellable, (obj, res) => {
+				var rows = index.search.end(res);
+
+				if (cancellable.is_cancelled())
+				{
+					return;
+				}
+
+				d_search_cancellable = null;
+				d_search_rows = new Gee.HashSet<uint>();
+
+				foreach (var row in rows)
+				{
+					d_search_rows.add(row);
+				}
+
+				if (jump)
+				{
+					jump_to_match(rows);
+				}
+			});
 		}
 
-		private bool search_filter_func(Gtk.TreeModel model, int column, string key, Gtk.TreeIter iter)
+		private void clear_search()
 		{
-			var c = d_commit_list_model.commit_from_iter(iter);
+			if (d_search_cancellable != null)
+			{
+				d_search_cancellable.cancel();
+				d_search_cancellable = null;
+			}
 
-			if (c.get_id().has_prefix(key))
+			d_search_key = null;
+			d_search_rows = null;
+		}
+
+		private void jump_to_match(uint[] rows)
+		{
+			if (rows.length == 0)
 			{
-				return false;
+				return;
 			}
 
-			var nkey = normalize(key);
-			var subject = normalize(c.get_subject());
+			Gtk.TreePath? cursor;
+			d_main.commit_list_view.get_cursor(out cursor, null);
+
+			uint from = 0;
 
-			if (subject.contains(nkey))
+			if (cursor != null)
 			{
-				return false;
+				from = (uint)cursor.get_indices()[0];
 			}
 
-			var message = normalize(c.get_message());
+			// First match at or after the cursor, wrapping around
+			var target = rows[0];
 
-			if (message.contains(nkey))
+			foreach (var row in rows)
 			{
-				return false;
+				if (row >= from)
+				{
+					target = row;
+					break;
+				}
 			}
 
-			var author = c.get_author();
-			if (author.get_name().down().contains(nkey) || author.get_email().down().contains(nkey)) {
-				return false;
+			if (target >= d_commit_list_model.iter_n_children(null))
+			{
+				return;
 			}
 
-			var committer = c.get_committer();
-			if (committer.get_name().down().contains(nkey) || committer.get_email().down().contains(nkey)) {
-				return false;
+			var path = new Gtk.TreePath.from_indices((int)target);
+
+			d_main.commit_list_view.set_cursor(path, null, false);
+			d_main.commit_list_view.scroll_to_cell(path, null, true, 0.5f, 0);
+		}
+
+		private bool search_filter_func(Gtk.TreeModel model, int column, string key, Gtk.TreeIter iter)
+		{
+			if (d_commit_list_model.search_index == null)
+			{
+				var c = d_commit_list_model.commit_from_iter(iter);
+
+				return !c.get_id().has_prefix(key) &&
+				       !Gitg.CommitSearchIndex.matches(c, Gitg.CommitSearchIndex.normalize(key));
 			}
 
-			return true;
+			// Matching happens in the background on the search index, rows
+			// only match once the results are in
+			if (key != d_search_key)
+			{
+				start_search(key, true);
+			}
+
+			if (d_search_rows == null)
+			{
+				return true;
+			}
+
+			var path = model.get_path(iter);
+			return !d_search_rows.contains((uint)path.get_indices()[0]);
 		}
 
 		public Gtk.Entry? search_entry
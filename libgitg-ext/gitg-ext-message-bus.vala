@@ -22,12 +22,27 @@ namespace GitgExt
 
 public delegate void MessageCallback(GitgExt.Message message);
 
+/**
+ * Message bus.
+ *
+ * Messages are either sent, which calls the listeners right away, or
+ * posted. Posted messages are delivered together once per main loop
+ * iteration, and a message posted while another one with the same id is
+ * still pending replaces it, so that listeners only see the latest one,
+ * e.g. when moving quickly through the history.
+ *
+ * Listeners connected with connect_threaded are called on a thread of the
+ * bus instead of the main thread, in the order the messages are
+ * dispatched. The message is frozen before, listeners should only read it.
+ */
 public class MessageBus : Object
 {
 	class Listener
 	{
 		public uint id;
 		public bool blocked;
+		public bool threaded;
+		public bool removed;
 
 		public MessageCallback callback;
 
@@ -41,6 +56,26 @@ public class MessageBus : Object
 		}
 	}
 
+	class Delivery
+	{
+		public Listener listener;
+		public GitgExt.Message message;
+
+		public Delivery(Listener listener, GitgExt.Message message)
+		{
+			this.listener = listener;
+			this.message = message;
+		}
+
+		public void run()
+		{
+			if (!listener.removed && !listener.blocked)
+			{
+				listener.callback(message);
+			}
+		}
+	}
+
 	class Message
 	{
 		public MessageId id;
@@ -67,6 +102,10 @@ public class MessageBus : Object
 	private HashTable<MessageId, Message> d_messages;
 	private HashTable<uint, IdMap> d_idmap;
 	private HashTable<MessageId, Type> d_types;
+	private HashTable<MessageId, GitgExt.Message> d_posted;
+	private Queue<MessageId> d_posted_order;
+	private uint d_flush_id;
+	private ThreadPool<Delivery>? d_pool;
 	private static MessageBus? s_instance;
 	private static uint s_next_id;
 
@@ -88,6 +127,19 @@ public class MessageBus : Object
 		d_messages = new HashTable<MessageId, Message>(MessageId.hash, MessageId.equal);
 		d_idmap = new HashTable<uint, IdMap>(direct_hash, direct_equal);
 		d_types = new HashTable<MessageId, Type>(MessageId.hash, MessageId.equal);
+		d_posted = new HashTable<MessageId, GitgExt.Message>(MessageId.hash, MessageId.equal);
+		d_posted_order = new Queue<MessageId>();
+	}
+
+	protected override void dispose()
+	{
+		if (d_flush_id != 0)
+		{
+			Source.remove(d_flush_id);
+			d_flush_id = 0;
+		}
+
+		base.dispose();
 	}
 
 	public static MessageBus get_default()
@@ -103,13 +155,69 @@ public class MessageBus : Object
 
 	private void dispatch_message_real(Message msg, GitgExt.Message message)
 	{
+		var threaded = false;
+
 		foreach (Listener l in msg.listeners)
 		{
-			if (!l.blocked)
+			if (l.threaded)
+			{
+				threaded = true;
+			}
+			else if (!l.blocked)
 			{
 				l.callback(message);
 			}
 		}
+
+		if (!threaded)
+		{
+			return;
+		}
+
+		// Listeners on the main thread may still fill in the message,
+		// the threaded ones get it once that is done
+		message.freeze();
+
+		foreach (Listener l in msg.listeners)
+		{
+			if (l.threaded && !l.blocked)
+			{
+				dispatch_threaded(new Delivery(l, message));
+			}
+		}
+	}
+
+	private void dispatch_threaded(owned Delivery delivery)
+	{
+		if (d_pool == null)
+		{
+			try
+			{
+				// A single thread, so that messages arrive in order
+				d_pool = new ThreadPool<Delivery>.with_owned_data((delivery) => {
+					delivery.run();
+				}, 1, false);
+			}
+			catch (ThreadError e)
+			{
+				stderr.printf("Failed to start message bus thread: %s\n", e.message);
+			}
+		}
+
+		if (d_pool == null)
+		{
+			delivery.run();
+			return;
+		}
+
+		try
+		{
+			d_pool.add((owned)delivery);
+		}
+		catch (ThreadError e)
+		{
+			stderr.printf("Failed to dispatch message: %s\n", e.message);
+		}
 	}
 
 	public Type lookup(MessageId id)
@@ -201,9 +309,10 @@ public class MessageBus : Object
 		return message;
 	}
 
-	private uint add_listener(Message message, owned MessageCallback callback)
+	private uint add_listener(Message message, owned MessageCallback callback, bool threaded)
 	{
 		var listener = new Listener(++s_next_id, (owned)callback);
+		listener.threaded = threaded;
 
 		message.listeners.append(listener);
 
@@ -218,6 +327,9 @@ public class MessageBus : Object
 	{
 		unowned Listener lst = listener.data;
 
+		// Messages already queued for it on the bus thread are dropped
+		lst.removed = true;
+
 		d_idmap.remove(lst.id);
 
 		message.listeners.delete_link(listener);
@@ -242,7 +354,22 @@ public class MessageBus : Object
 	{
 		var message = lookup_message(id, true);
 
-		return add_listener(message, (owned)callback);
+		return add_listener(message, (owned)callback, false);
+	}
+
+	/**
+	 * Connect a listener which is called on a thread of the bus.
+	 *
+	 * The listener is called after the listeners on the main thread, with
+	 * the message frozen. It must not modify the message, nor use widgets.
+	 *
+	 * @return the id of the listener, to disconnect or block it.
+	 */
+	public uint connect_threaded(MessageId id, owned MessageCallback callback)
+	{
+		var message = lookup_message(id, true);
+
+		return add_listener(message, (owned)callback, true);
 	}
 
 	private delegate void MatchCallback(Message message, List<Listener> listeners);
@@ -286,6 +413,75 @@ public class MessageBus : Object
 	}
 
 	public GitgExt.Message? send(MessageId id, string? firstprop, ...)
+	{
+		var msg = create_message(id, firstprop, va_list());
+
+		if (msg != null)
+		{
+			dispatch_message(msg);
+		}
+
+		return msg;
+	}
+
+	/**
+	 * Post a message, to be delivered in the next main loop iteration.
+	 *
+	 * A message which is still pending with the same id is replaced, it
+	 * is not delivered.
+	 */
+	public void post_message(GitgExt.Message message)
+	{
+		var id = message.id;
+
+		if (!d_posted.contains(id))
+		{
+			d_posted_order.push_tail(id);
+		}
+
+		d_posted.insert(id, message);
+
+		if (d_flush_id == 0)
+		{
+			d_flush_id = Idle.add(flush_posted);
+		}
+	}
+
+	public GitgExt.Message? post(MessageId id, string? firstprop, ...)
+	{
+		var msg = create_message(id, firstprop, va_list());
+
+		if (msg != null)
+		{
+			post_message(msg);
+		}
+
+		return msg;
+	}
+
+	private bool flush_posted()
+	{
+		d_flush_id = 0;
+
+		// Messages posted by the listeners are delivered in the next
+		// iteration
+		var posted = d_posted;
+		var order = (owned)d_posted_order;
+
+		d_posted = new HashTable<MessageId, GitgExt.Message>(MessageId.hash, MessageId.equal);
+		d_posted_order = new Queue<MessageId>();
+
+		MessageId? id;
+
+		while ((id = order.pop_head()) != null)
+		{
+			dispatch_message(posted.lookup(id));
+		}
+
+		return false;
+	}
+
+	private GitgExt.Message? create_message(MessageId id, string? firstprop, va_list args)
 	{
 		Type type = lookup(id);
 
@@ -295,15 +491,13 @@ public class MessageBus : Object
 			return null;
 		}
 
-		GitgExt.Message? msg = (GitgExt.Message?)Object.new_valist(type, firstprop, va_list());
+		GitgExt.Message? msg = (GitgExt.Message?)Object.new_valist(type, firstprop, args);
 
 		if (msg != null)
 		{
 			msg.id = id;
 		}
 
-		dispatch_message(msg);
-
 		return msg;
 	}
 }
@@ -23,6 +23,7 @@ namespace GitgExt
 public abstract class Message : Object
 {
 	private MessageId d_id;
+	private bool d_frozen;
 
 	public MessageId id
 	{
@@ -36,6 +37,33 @@ public abstract class Message : Object
 		}
 	}
 
+	/**
+	 * Whether the message is frozen.
+	 *
+	 * A message is frozen before it is handed to listeners running off the
+	 * main thread, which read it concurrently. It must not be modified
+	 * anymore after that.
+	 */
+	public bool frozen
+	{
+		get { return d_frozen; }
+	}
+
+	construct
+	{
+		notify.connect((pspec) => {
+			if (d_frozen)
+			{
+				warning("Message `%s' was modified (%s) after being frozen", d_id.id, pspec.name);
+			}
+		});
+	}
+
+	internal void freeze()
+	{
+		d_frozen = true;
+	}
+
 	public bool has(string propname)
 	{
 		return get_class().find_property(propname) != null;
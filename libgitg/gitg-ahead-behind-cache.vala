@@ -0,0 +1,479 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Computes how many commits branches are ahead and behind of their
+ * upstream on a background thread. Lookups made in the same main loop
+ * iteration are computed together, in a single walk of the history which
+ * marks each commit with the tips it is reachable from, instead of one
+ * walk per branch. Results are cached by the pair of ids, so they only
+ * need to be computed again once one of the branches moved. Like git, the
+ * walk relies on commit times to know when to stop, so it tolerates commits
+ * dated older than their parents, but a history skewed several times over
+ * within the same walk can still be miscounted.
+ */
+public class AheadBehindCache : Object
+{
+	// Above this number of cached results, the cache starts over
+	private const int MAX_RESULTS = 10000;
+
+	private class Waiter
+	{
+		public SourceFunc callback;
+
+		public Waiter(owned SourceFunc callback)
+		{
+			this.callback = (owned)callback;
+		}
+	}
+
+	private class Pair
+	{
+		public Ggit.OId local;
+		public Ggit.OId upstream;
+
+		public size_t ahead;
+		public size_t behind;
+		public bool done;
+		public bool valid;
+
+		public Gee.ArrayList<Waiter> waiters;
+
+		// Bits of the tips in the walk
+		public int local_bit;
+		public int upstream_bit;
+
+		public Pair(Ggit.OId local, Ggit.OId upstream)
+		{
+			this.local = local;
+			this.upstream = upstream;
+
+			waiters = new Gee.ArrayList<Waiter>();
+		}
+	}
+
+	private class Node
+	{
+		public Ggit.OId id;
+		public int64 time;
+		public uint32[] bits;
+		public bool queued;
+	}
+
+	private weak Repository d_repository;
+
+	private Gee.HashMap<string, Pair> d_results;
+	private Gee.ArrayList<Pair> d_pending;
+	private uint d_batch_id;
+	private bool d_running;
+
+	public AheadBehindCache(Repository repository)
+	{
+		d_repository = repository;
+
+		d_results = new Gee.HashMap<string, Pair>();
+		d_pending = new Gee.ArrayList<Pair>();
+	}
+
+	protected override void dispose()
+	{
+		if (d_batch_id != 0)
+		{
+			Source.remove(d_batch_id);
+			d_batch_id = 0;
+		}
+
+		base.dispose();
+	}
+
+	private static string key(Ggit.OId local, Ggit.OId upstream)
+	{
+		return @"$(local.to_string()):$(upstream.to_string())";
+	}
+
+	/**
+	 * Get an already computed result.
+	 *
+	 * @return true if the result is cached and valid.
+	 */
+	public bool cached(Ggit.OId local, Ggit.OId upstream, out size_t ahead, out size_t behind)
+	{
+		ahead = 0;
+		behind = 0;
+
+		var pair = d_results[key(local, upstream)];
+
+		if (pair == null || !pair.done || !pair.valid)
+		{
+			return false;
+		}
+
+		ahead = pair.ahead;
+		behind = pair.behind;
+
+		return true;
+	}
+
+	/**
+	 * Get how many commits @local is ahead and behind of @upstream.
+	 *
+	 * @return false if it could not be computed, e.g. when one of the ids
+	 *         is not a commit.
+	 */
+	public async bool lookup(Ggit.OId local, Ggit.OId upstream, out size_t ahead, out size_t behind)
+	{
+		ahead = 0;
+		behind = 0;
+
+		var k = key(local, upstream);
+		var pair = d_results[k];
+
+		if (pair == null)
+		{
+			if (d_results.size >= MAX_RESULTS)
+			{
+				d_results.clear();
+			}
+
+			pair = new Pair(local, upstream);
+
+			d_results[k] = pair;
+			d_pending.add(pair);
+
+			schedule();
+		}
+
+		if (!pair.done)
+		{
+			pair.waiters.add(new Waiter(lookup.callback));
+			yield;
+		}
+
+		if (!pair.valid)
+		{
+			return false;
+		}
+
+		ahead = pair.ahead;
+		behind = pair.behind;
+
+		return true;
+	}
+
+	private void schedule()
+	{
+		if (d_batch_id != 0 || d_running)
+		{
+			return;
+		}
+
+		d_batch_id = Idle.add(() => {
+			d_batch_id = 0;
+			run_batch.begin();
+
+			return false;
+		});
+	}
+
+	private async void run_batch()
+	{
+		var pairs = d_pending;
+		d_pending = new Gee.ArrayList<Pair>();
+
+		d_running = true;
+
+		yield Async.thread_try(() => {
+			compute(pairs);
+		});
+
+		d_running = false;
+
+		foreach (var pair in pairs)
+		{
+			pair.done = true;
+
+			foreach (var waiter in pair.waiters)
+			{
+				Idle.add((owned)waiter.callback);
+			}
+
+			pair.waiters.clear();
+		}
+
+		if (d_pending.size != 0)
+		{
+			schedule();
+		}
+	}
+
+	private Node? create_node(Ggit.OId id, int nwords)
+	{
+		Ggit.Commit commit;
+
+		try
+		{
+			commit = d_repository.lookup<Ggit.Commit>(id);
+		}
+		catch
+		{
+			return null;
+		}
+
+		var node = new Node();
+
+		node.id = id;
+		node.time = commit.get_committer().get_time().to_unix();
+		node.bits = new uint32[nwords];
+
+		return node;
+	}
+
+	private static bool is_full(Node node, uint32[] full)
+	{
+		for (var i = 0; i < full.length; i++)
+		{
+			if (node.bits[i] != full[i])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	private static bool has_bit(Node node, int bit)
+	{
+		return (node.bits[bit / 32] & (1u << (bit % 32))) != 0;
+	}
+
+	// Runs in a thread
+	private void compute(Gee.ArrayList<Pair> pairs)
+	{
+		var tips = new Gee.HashMap<Ggit.OId, int>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+		                                          (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+		var tip_ids = new Gee.ArrayList<Ggit.OId>();
+
+		foreach (var pair in pairs)
+		{
+			foreach (var id in new Ggit.OId[] {pair.local, pair.upstream})
+			{
+				if (!tips.has_key(id))
+				{
+					tips[id] = tip_ids.size;
+					tip_ids.add(id);
+				}
+			}
+
+			pair.local_bit = tips[pair.local];
+			pair.upstream_bit = tips[pair.upstream];
+		}
+
+		var ntips = tip_ids.size;
+		var nwords = (ntips + 31) / 32;
+
+		// The bits of a commit reachable from all tips
+		var full = new uint32[nwords];
+
+		for (var i = 0; i < ntips; i++)
+		{
+			full[i / 32] |= 1u << (i % 32);
+		}
+
+		var nodes = new Gee.HashMap<Ggit.OId, Node>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+		                                            (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+		var queue = new Gee.PriorityQueue<Node>((a, b) => {
+			return a.time > b.time ? -1 : (a.time < b.time ? 1 : 0);
+		});
+
+		var missing = new bool[ntips];
+
+		// Number of queued commits which are not reachable from all tips.
+		// Once there are none left, the commits further down the history
+		// are reachable from all tips and so do not count for any pair.
+		var partial = 0;
+
+		for (var i = 0; i < ntips; i++)
+		{
+			var id = tip_ids[i];
+			var node = nodes[id];
+
+			if (node == null)
+			{
+				node = create_node(id, nwords);
+
+				if (node == null)
+				{
+					missing[i] = true;
+					continue;
+				}
+
+				nodes[id] = node;
+			}
+
+			node.bits[i / 32] |= 1u << (i % 32);
+
+			if (!node.queued)
+			{
+				node.queued = true;
+				queue.offer(node);
+			}
+		}
+
+		// Tips which are not commits are never reached
+		for (var i = 0; i < ntips; i++)
+		{
+			if (missing[i])
+			{
+				full[i / 32] &= ~(1u << (i % 32));
+			}
+		}
+
+		foreach (var node in queue)
+		{
+			if (!is_full(node, full))
+			{
+				partial++;
+			}
+		}
+
+		// Time of the oldest commit walked before it was reachable from all
+		// tips. When commit times are out of order, full commits which are as
+		// new as that one may still lead to commits which were walked
+		// already, so those are walked as well before stopping
+		var oldest_partial = int64.MAX;
+
+		while (partial > 0 || (queue.size > 0 && queue.peek().time >= oldest_partial))
+		{
+			var node = queue.poll();
+			node.queued = false;
+
+			if (!is_full(node, full))
+			{
+				partial--;
+
+				if (node.time < oldest_partial)
+				{
+					oldest_partial = node.time;
+				}
+			}
+
+			Ggit.CommitParents parents;
+
+			try
+			{
+				parents = d_repository.lookup<Ggit.Commit>(node.id).get_parents();
+			}
+			catch
+			{
+				continue;
+			}
+
+			for (uint i = 0; i < parents.size; i++)
+			{
+				var pid = parents.get_id(i);
+				var parent = nodes[pid];
+
+				if (parent == null)
+				{
+					parent = create_node(pid, nwords);
+
+					if (parent == null)
+					{
+						continue;
+					}
+
+					nodes[pid] = parent;
+				}
+
+				var was_full = is_full(parent, full);
+				var changed = false;
+
+				for (var w = 0; w < nwords; w++)
+				{
+					var bits = parent.bits[w] | node.bits[w];
+
+					if (bits != parent.bits[w])
+					{
+						parent.bits[w] = bits;
+						changed = true;
+					}
+				}
+
+				if (!changed)
+				{
+					continue;
+				}
+
+				var now_full = is_full(parent, full);
+
+				if (parent.queued)
+				{
+					if (!was_full && now_full)
+					{
+						partial--;
+					}
+				}
+				else
+				{
+					// Also queues commits again whose bits changed after
+					// being walked, which happens when commit times are
+					// out of order
+					parent.queued = true;
+					queue.offer(parent);
+
+					if (!now_full)
+					{
+						partial++;
+					}
+				}
+			}
+		}
+
+		foreach (var pair in pairs)
+		{
+			pair.valid = !missing[pair.local_bit] && !missing[pair.upstream_bit];
+		}
+
+		foreach (var node in nodes.values)
+		{
+			foreach (var pair in pairs)
+			{
+				var l = has_bit(node, pair.local_bit);
+				var u = has_bit(node, pair.upstream_bit);
+
+				if (l && !u)
+				{
+					pair.ahead++;
+				}
+				else if (u && !l)
+				{
+					pair.behind++;
+				}
+			}
+		}
+	}
+}
+
+}
+
+// ex:set ts=4 noet
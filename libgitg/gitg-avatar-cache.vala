@@ -17,14 +17,75 @@
  * along with gitg. If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* Avatars are kept in memory in least recently used order, and on disk in
+ * the user cache directory so that they survive restarts. An avatar found on
+ * disk is used right away, and fetched again in the background once it is
+ * older than a week. Authors without an avatar are remembered as well, on
+ * disk by an empty marker file, and asked for again after a day. Concurrent
+ * loads of the same avatar wait for the one already running.
+ */
 public class Gitg.AvatarCache : Object
 {
-	private Gee.HashMap<string, Gdk.Pixbuf?> d_cache;
+	private const size_t MEMORY_BUDGET = 16 * 1024 * 1024;
+	private const size_t READ_SIZE = 64 * 1024;
+
+	// In seconds
+	private const int64 AVATAR_TTL = 7 * 24 * 3600;
+	private const int64 MISSING_TTL = 24 * 3600;
+
+	// Retry delay when an avatar could not be fetched for another reason
+	// than not existing, e.g. when offline
+	private const int64 FAILED_TTL = 5 * 60;
+
+	private class Entry
+	{
+		public Gdk.Pixbuf? pixbuf;
+		public size_t cost;
+
+		// Monotonic time until which a missing avatar is not asked for again
+		public int64 expires;
+	}
+
+	private class Waiter
+	{
+		public SourceFunc callback;
+
+		public Waiter(owned SourceFunc callback)
+		{
+			this.callback = (owned)callback;
+		}
+	}
+
+	private Gee.HashMap<string, Entry> d_entries;
+	private Gee.LinkedList<string> d_order;
+	private Gee.HashMap<string, Gee.ArrayList<Waiter>> d_loading;
+	private Gee.HashSet<string> d_refreshing;
+	private size_t d_size;
+	private File? d_directory;
+
 	private static AvatarCache? s_instance;
 
 	construct
 	{
-		d_cache = new Gee.HashMap<string, Gdk.Pixbuf>();
+		d_entries = new Gee.HashMap<string, Entry>();
+		d_order = new Gee.LinkedList<string>();
+		d_loading = new Gee.HashMap<string, Gee.ArrayList<Waiter>>();
+		d_refreshing = new Gee.HashSet<string>();
+
+		d_directory = File.new_for_path(Path.build_filename(Environment.get_user_cache_dir(),
+		                                                    "gitg",
+		                                                    "avatars"));
+
+		try
+		{
+			d_directory.make_directory_with_parents();
+		}
+		catch (IOError.EXISTS e) {}
+		catch (Error e)
+		{
+			stderr.printf("Failed to create avatar cache directory: %s\n", e.message);
+			d_directory = null;
+		}
 	}
 
 	private AvatarCache()
@@ -45,81 +106,337 @@ public class Gitg.AvatarCache : Object
 	public async Gdk.Pixbuf? load(string email, int size = 50, Cancellable? cancellable = null)
 	{
 		var id = Checksum.compute_for_string(ChecksumType.MD5, email.down());
+		var ckey = @"$id-$size";
 
-		var ckey = @"$id $size";
-
-		if (d_cache.has_key(ckey))
+		while (true)
 		{
-			return d_cache[ckey];
+			var entry = d_entries[ckey];
+
+			if (entry != null)
+			{
+				if (entry.pixbuf != null || entry.expires > get_monotonic_time())
+				{
+					d_order.remove(ckey);
+					d_order.offer_tail(ckey);
+
+					return entry.pixbuf;
+				}
+
+				remove(ckey);
+			}
+
+			var waiters = d_loading[ckey];
+
+			if (waiters == null)
+			{
+				break;
+			}
+
+			waiters.add(new Waiter(load.callback));
+			yield;
 		}
 
-		var gravatar = @"https://www.gravatar.com/avatar/$(id)?d=404&s=$(size)";
-		var gfile = File.new_for_uri(gravatar);
+		d_loading[ckey] = new Gee.ArrayList<Waiter>();
 
-		var pixbuf = yield read_avatar_from_file(id, gfile, size, cancellable);
+		// If cancelled, nothing is added and one of the waiting loads will
+		// load the avatar instead
+		var pixbuf = yield load_avatar(id, size, ckey, cancellable);
 
-		d_cache[ckey] = pixbuf;
+		wake(ckey);
 		return pixbuf;
 	}
 
-	private async Gdk.Pixbuf? read_avatar_from_file(string       id,
-	                                                File         file,
-	                                                int          size,
-	                                                Cancellable? cancellable)
+	private async Gdk.Pixbuf? load_avatar(string id, int size, string ckey, Cancellable? cancellable)
 	{
-		InputStream stream;
+		var file = cache_file(ckey);
+		var age = yield file_age(file);
+
+		if (age >= 0)
+		{
+			var pixbuf = yield read_cached(file, size, cancellable);
+
+			if (pixbuf != null)
+			{
+				add(ckey, pixbuf, 0);
+
+				if (age > AVATAR_TTL)
+				{
+					refresh.begin(id, size, ckey, (obj, res) => {
+						refresh.end(res);
+					});
+				}
+
+				return pixbuf;
+			}
+		}
+
+		age = yield file_age(missing_file(ckey));
+
+		if (age >= 0 && age < MISSING_TTL)
+		{
+			add(ckey, null, MISSING_TTL - age);
+			return null;
+		}
+
+		return yield fetch(id, size, ckey, cancellable);
+	}
+
+	// Fetches a stale avatar again, the one already shown stays until then
+	private async void refresh(string id, int size, string ckey)
+	{
+		if (!d_refreshing.add(ckey))
+		{
+			return;
+		}
+
+		var current = d_entries[ckey];
+		var pixbuf = yield fetch(id, size, ckey, null);
+
+		if (pixbuf == null && current != null && current.pixbuf != null)
+		{
+			// Keep showing the avatar we have for now
+			add(ckey, current.pixbuf, 0);
+		}
+
+		d_refreshing.remove(ckey);
+	}
+
+	private async Gdk.Pixbuf? fetch(string id, int size, string ckey, Cancellable? cancellable)
+	{
+		var gravatar = @"https://www.gravatar.com/avatar/$(id)?d=404&s=$(size)";
+		Bytes bytes;
+
+		var span = Trace.begin();
 
 		try
 		{
-			stream = yield Gitg.PlatformSupport.http_get(file, cancellable);
+			bytes = yield read_bytes(File.new_for_uri(gravatar), cancellable);
+			Trace.end_detail(span, "AvatarCache.fetch", "%s", ckey);
 		}
-		catch(Error e)
+		catch (IOError.CANCELLED e)
 		{
-			debug("Can not retrieve avatar from %s: %s", file.get_path(), e.message);
 			return null;
 		}
+		catch (IOError.NOT_FOUND e)
+		{
+			yield write_cached(missing_file(ckey), new Bytes(new uint8[0]));
+			yield delete_cached(cache_file(ckey));
 
-		uint8[] buffer = new uint8[4096];
-		var loader = new Gdk.PixbufLoader();
+			add(ckey, null, MISSING_TTL);
 
-		loader.set_size(size, size);
+			return null;
+		}
+		catch (Error e)
+		{
+			debug("Can not retrieve avatar from %s: %s", gravatar, e.message);
+			add(ckey, null, FAILED_TTL);
+
+			return null;
+		}
+
+		var pixbuf = decode(bytes, size);
+
+		if (pixbuf == null)
+		{
+			add(ckey, null, FAILED_TTL);
+			return null;
+		}
+
+		yield write_cached(cache_file(ckey), bytes);
+
+		yield delete_cached(missing_file(ckey));
+
+		add(ckey, pixbuf, 0);
+		return pixbuf;
+	}
+
+	private File cache_file(string ckey)
+	{
+		return d_directory != null ? d_directory.get_child(ckey) : File.new_for_path("");
+	}
+
+	private File missing_file(string ckey)
+	{
+		return d_directory != null ? d_directory.get_child(ckey + ".missing") : File.new_for_path("");
+	}
+
+	// The age of the file in seconds, or -1 if it does not exist
+	private async int64 file_age(File file)
+	{
+		if (d_directory == null)
+		{
+			return -1;
+		}
+
+		try
+		{
+			var info = yield file.query_info_async(FileAttribute.TIME_MODIFIED,
+			                                       FileQueryInfoFlags.NONE,
+			                                       Priority.LOW);
+
+			var mtime = info.get_attribute_uint64(FileAttribute.TIME_MODIFIED);
+			var now = get_real_time() / 1000000;
+
+			return int64.max(now - (int64)mtime, 0);
+		}
+		catch
+		{
+			return -1;
+		}
+	}
 
-		return yield read_avatar(id, stream, buffer, loader, cancellable);
+	private async Gdk.Pixbuf? read_cached(File file, int size, Cancellable? cancellable)
+	{
+		try
+		{
+			uint8[] contents;
+
+			yield file.load_contents_async(cancellable, out contents, null);
+			return decode(new Bytes.take((owned)contents), size);
+		}
+		catch
+		{
+			return null;
+		}
 	}
 
-	private async Gdk.Pixbuf? read_avatar(string           id,
-	                                      InputStream      stream,
-	                                      uint8[]          buffer,
-	                                      Gdk.PixbufLoader loader,
-	                                      Cancellable?     cancellable)
+	private async void write_cached(File file, Bytes bytes)
 	{
-		ssize_t n;
+		if (d_directory == null)
+		{
+			return;
+		}
 
 		try
 		{
-			n = yield stream.read_async(buffer, Priority.LOW, cancellable);
+			yield file.replace_contents_bytes_async(bytes,
+			                                        null,
+			                                        false,
+			                                        FileCreateFlags.REPLACE_DESTINATION);
+		}
+		catch (Error e)
+		{
+			debug("Can not write avatar to %s: %s", file.get_path(), e.message);
 		}
-		catch { return null; }
+	}
 
-		if (n != 0)
+	private async void delete_cached(File file)
+	{
+		if (d_directory == null)
 		{
-			try
+			return;
+		}
+
+		try
+		{
+			yield file.delete_async(Priority.LOW, null);
+		} catch {}
+	}
+
+	private async Bytes read_bytes(File file, Cancellable? cancellable) throws Error
+	{
+		var stream = yield Gitg.PlatformSupport.http_get(file, cancellable);
+		var data = new ByteArray();
+
+		while (true)
+		{
+			var chunk = yield stream.read_bytes_async(READ_SIZE, Priority.LOW, cancellable);
+
+			if (chunk.get_size() == 0)
 			{
-				loader.write(buffer[0:n]);
+				break;
 			}
-			catch { return null; }
 
-			return yield read_avatar(id, stream, buffer, loader, cancellable);
+			data.append(chunk.get_data());
 		}
-		else
+
+		try
+		{
+			yield stream.close_async(Priority.LOW, null);
+		} catch {}
+
+		return ByteArray.free_to_bytes((owned)data);
+	}
+
+	private Gdk.Pixbuf? decode(Bytes bytes, int size)
+	{
+		var loader = new Gdk.PixbufLoader();
+		loader.set_size(size, size);
+
+		try
+		{
+			loader.write_bytes(bytes);
+			loader.close();
+		}
+		catch
 		{
-			// Finished reading
 			try
 			{
 				loader.close();
-			} catch { return null; }
+			} catch {}
+
+			return null;
+		}
+
+		return loader.get_pixbuf();
+	}
+
+	private void add(string ckey, Gdk.Pixbuf? pixbuf, int64 ttl)
+	{
+		remove(ckey);
+
+		var entry = new Entry();
+		entry.pixbuf = pixbuf;
 
-			return loader.get_pixbuf();
+		if (pixbuf != null)
+		{
+			entry.cost = pixbuf.get_byte_length();
+		}
+		else
+		{
+			entry.expires = get_monotonic_time() + ttl * 1000000;
+		}
+
+		d_entries[ckey] = entry;
+		d_order.offer_tail(ckey);
+		d_size += entry.cost;
+
+		evict();
+	}
+
+	private void remove(string ckey)
+	{
+		Entry entry;
+
+		if (d_entries.unset(ckey, out entry))
+		{
+			d_order.remove(ckey);
+			d_size -= entry.cost;
+		}
+	}
+
+	private void wake(string ckey)
+	{
+		Gee.ArrayList<Waiter> waiters;
+
+		if (!d_loading.unset(ckey, out waiters))
+		{
+			return;
+		}
+
+		foreach (var waiter in waiters)
+		{
+			Idle.add((owned)waiter.callback);
+		}
+	}
+
+	private void evict()
+	{
+		// Keep the most recent avatar, even if it exceeds the budget by
+		// itself
+		while (d_size > MEMORY_BUDGET && d_order.size > 1)
+		{
+			remove(d_order.first());
 		}
 	}
 }
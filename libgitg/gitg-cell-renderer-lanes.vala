@@ -28,6 +28,13 @@ namespace Gitg
 		public unowned SList<Ref> labels { get; set; }
 
 		private int d_last_height;
+		private LaneBuffer d_buffer = new LaneBuffer();
+
+		// Rendered lanes of rows, keyed by everything that affects how the
+		// lanes of a row look. Linear stretches of history render the same
+		// lanes for many rows, which then share a single surface.
+		private const uint MAX_LANE_SURFACES = 256;
+		private Gee.HashMap<string, Cairo.ImageSurface> d_lane_surfaces = new Gee.HashMap<string, Cairo.ImageSurface>();
 
 		private delegate double DirectionFunc(double i);
 
@@ -38,11 +45,13 @@ namespace Gitg
 				int ret = 0;
 				int trailing_hidden = 0;
 
-				foreach (var lane in commit.get_lanes())
+				unowned uint16[] from;
+
+				foreach (var lane in commit.get_lane_records(d_buffer, out from))
 				{
 					++ret;
 
-					if ((lane.tag & LaneTag.HIDDEN) != 0)
+					if (((LaneTag)lane.tag & LaneTag.HIDDEN) != 0)
 					{
 						trailing_hidden++;
 					}
@@ -76,6 +85,14 @@ namespace Gitg
 			}
 		}
 
+		private void set_source_lane_color(Cairo.Context context, uint color)
+		{
+			double r, g, b;
+
+			Color.components_for_index(color, out r, out g, out b);
+			context.set_source_rgb(r, g, b);
+		}
+
 		private void draw_arrow(Cairo.Context context,
 		                        Gdk.Rectangle area,
 		                        uint          laneidx,
@@ -101,17 +118,17 @@ namespace Gitg
 		                         Gdk.Rectangle area)
 		{
 			uint to = 0;
+			unowned uint16[] from;
 
-			foreach (var lane in commit.get_lanes())
+			foreach (var lane in commit.get_lane_records(d_buffer, out from))
 			{
-				var color = lane.color;
-				context.set_source_rgb(color.r, color.g, color.b);
+				set_source_lane_color(context, lane.color);
 
-				if (lane.tag == LaneTag.START)
+				if ((LaneTag)lane.tag == LaneTag.START)
 				{
 					draw_arrow(context, area, to, true);
 				}
-				else if (lane.tag == LaneTag.END)
+				else if ((LaneTag)lane.tag == LaneTag.END)
 				{
 					draw_arrow(context, area, to, false);
 				}
@@ -135,20 +152,21 @@ namespace Gitg
 			double cw = lane_width;
 			double ch = area.height / 2.0;
 
-			foreach (var lane in commit.get_lanes())
+			unowned uint16[] from;
+
+			foreach (var lane in commit.get_lane_records(d_buffer, out from))
 			{
-				if ((lane.tag & LaneTag.HIDDEN) != 0)
+				if (((LaneTag)lane.tag & LaneTag.HIDDEN) != 0)
 				{
 					++to;
 					continue;
 				}
 
-				var color = lane.color;
-				context.set_source_rgb(color.r, color.g, color.b);
+				set_source_lane_color(context, lane.color);
 
-				foreach (var from in lane.from)
+				for (uint i = 0; i < lane.nfrom; i++)
 				{
-					double x1 = area.x + f(from * cw + cw / 2.0);
+					double x1 = area.x + f(from[lane.from + i] * cw + cw / 2.0);
 					double x2 = area.x + f(to * cw + cw / 2.0);
 					double y1 = area.y + yoffset * ch;
 					double y2 = area.y + (yoffset + 1) * ch;
@@ -214,10 +232,12 @@ namespace Gitg
 			context.set_source_rgb(0, 0, 0);
 			context.stroke_preserve();
 
-			if (commit.lane != null)
+			unowned uint16[] from;
+			unowned LaneRecord[] lanes = commit.get_lane_records(d_buffer, out from);
+
+			if (commit.mylane < lanes.length)
 			{
-				var color = commit.lane.color;
-				context.set_source_rgb(color.r, color.g, color.b);
+				set_source_lane_color(context, lanes[commit.mylane].color);
 			}
 
 			context.fill();
@@ -244,19 +264,82 @@ namespace Gitg
 			context.restore();
 		}
 
-		private void draw_lane(Cairo.Context context,
-		                       Gtk.Widget    widget,
-		                       Gdk.Rectangle area)
+		private void append_lanes_key(StringBuilder key, Commit? c, ref uint ncols)
 		{
-			DirectionFunc f;
+			if (c == null)
+			{
+				key.append_c('-');
+				return;
+			}
 
-			var rtl = (widget.get_style_context().get_state() & Gtk.StateFlags.DIR_RTL) != 0;
+			unowned uint16[] from;
+			uint to = 0;
 
-			context.save();
+			foreach (var lane in c.get_lane_records(d_buffer, out from))
+			{
+				key.append_printf("%x.%x", lane.color, lane.tag);
+
+				for (uint i = 0; i < lane.nfrom; i++)
+				{
+					var f = from[lane.from + i];
+
+					key.append_printf(".%x", f);
+					ncols = uint.max(ncols, f + 1);
+				}
+
+				key.append_c(';');
+				++to;
+			}
+
+			ncols = uint.max(ncols, to);
+			key.append_c('|');
+		}
+
+		private Cairo.ImageSurface lane_surface(Gtk.Widget widget, int height, bool rtl)
+		{
+			var scale = widget.get_scale_factor();
+			var key = new StringBuilder();
+			uint ncols = commit.mylane + 1;
+
+			key.append_printf("%u:%u:%d:%d:%d:%u|",
+			                  lane_width,
+			                  dot_width,
+			                  height,
+			                  scale,
+			                  rtl ? 1 : 0,
+			                  commit.mylane);
+
+			append_lanes_key(key, commit, ref ncols);
+			append_lanes_key(key, next_commit, ref ncols);
+
+			var surface = d_lane_surfaces[key.str];
+
+			if (surface != null)
+			{
+				return surface;
+			}
+
+			var width = (int)(ncols * lane_width);
+
+			surface = new Cairo.ImageSurface(Cairo.Format.ARGB32,
+			                                 int.max(width, 1) * scale,
+			                                 height * scale);
+
+			surface.set_device_scale(scale, scale);
+
+			var area = Gdk.Rectangle() {
+				x = 0,
+				y = 0,
+				width = width,
+				height = height
+			};
+
+			var context = new Cairo.Context(surface);
+			DirectionFunc f;
 
 			if (rtl)
 			{
-				context.translate(area.width, 0);
+				context.translate(width, 0);
 				f = (a) => -a;
 			}
 			else
@@ -267,7 +350,31 @@ namespace Gitg
 			draw_paths(context, area, f);
 			draw_indicator(context, area, f);
 
-			context.restore();
+			if (d_lane_surfaces.size >= MAX_LANE_SURFACES)
+			{
+				d_lane_surfaces.clear();
+			}
+
+			d_lane_surfaces[key.str] = surface;
+			return surface;
+		}
+
+		private void draw_lane(Cairo.Context context,
+		                       Gtk.Widget    widget,
+		                       Gdk.Rectangle area)
+		{
+			var rtl = (widget.get_style_context().get_state() & Gtk.StateFlags.DIR_RTL) != 0;
+			var surface = lane_surface(widget, area.height, rtl);
+
+			double x = area.x;
+
+			if (rtl)
+			{
+				x += area.width - surface.get_width() / widget.get_scale_factor();
+			}
+
+			context.set_source_surface(surface, x, area.y);
+			context.paint();
 		}
 
 		public override void render(Cairo.Context         context,
@@ -276,6 +383,8 @@ namespace Gitg
 		                            Gdk.Rectangle         cell_area,
 		                            Gtk.CellRendererState flags)
 		{
+			Trace.rate("rows rendered/s");
+
 			var ncell_area = cell_area;
 			var narea = area;
 
@@ -56,6 +56,16 @@ public class Color : Object
 		current_index = 0;
 	}
 
+	public static uint current()
+	{
+		return current_index;
+	}
+
+	public static uint palette_size()
+	{
+		return palette.length;
+	}
+
 	public double r
 	{
 		get { return palette[idx].r / 255.0; }
@@ -78,6 +88,13 @@ public class Color : Object
 		b = this.b;
 	}
 
+	public static void components_for_index(uint idx, out double r, out double g, out double b)
+	{
+		r = palette[idx].r / 255.0;
+		g = palette[idx].g / 255.0;
+		b = palette[idx].b / 255.0;
+	}
+
 	private static uint inc_index()
 	{
 		uint next = current_index++;
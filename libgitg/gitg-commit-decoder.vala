@@ -0,0 +1,218 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Looks up the commits of a walk on a pool of worker threads. Ids are
+ * pushed in walk order and the commits are popped in that same order, so
+ * that the commits ahead of the consumer are read and parsed in parallel
+ * while the consumer lays out the current one.
+ */
+public class CommitDecoder : Object
+{
+	private const uint BATCH_SIZE = 128;
+	private const uint MAX_THREADS = 16;
+
+	private class Batch
+	{
+		public Ggit.OId[] ids;
+		public Commit?[] commits;
+		public uint n_ids;
+
+		public Mutex mutex;
+		public Cond cond;
+		public bool done;
+
+		public Batch()
+		{
+			ids = new Ggit.OId[BATCH_SIZE];
+			commits = new Commit?[BATCH_SIZE];
+
+			mutex = Mutex();
+			cond = Cond();
+		}
+
+		public void decode(Repository repository)
+		{
+			for (uint i = 0; i < n_ids; i++)
+			{
+				try
+				{
+					commits[i] = repository.lookup<Commit>(ids[i]);
+				} catch {}
+			}
+
+			mutex.lock();
+			done = true;
+			cond.broadcast();
+			mutex.unlock();
+		}
+
+		public void wait()
+		{
+			mutex.lock();
+
+			while (!done)
+			{
+				cond.wait(mutex);
+			}
+
+			mutex.unlock();
+		}
+	}
+
+	private Repository d_repository;
+	private ThreadPool<Batch>? d_pool;
+
+	private Gee.ArrayQueue<Batch> d_batches;
+	private Batch? d_filling;
+	private uint d_read;
+	private uint d_queued;
+
+	public CommitDecoder(Repository repository)
+	{
+		d_repository = repository;
+		d_batches = new Gee.ArrayQueue<Batch>();
+
+		var n = uint.min(get_num_processors(), MAX_THREADS);
+
+		if (n > 1)
+		{
+			try
+			{
+				d_pool = new ThreadPool<Batch>.with_owned_data((batch) => {
+					batch.decode(d_repository);
+				}, (int)n, false);
+			}
+			catch (ThreadError e)
+			{
+				stderr.printf("Failed to start commit decoder threads: %s\n", e.message);
+				d_pool = null;
+			}
+		}
+	}
+
+	/* The number of ids which were pushed but not popped yet. */
+	public uint queued
+	{
+		get { return d_queued; }
+	}
+
+	/* Queues @id to be looked up. */
+	public void push(Ggit.OId id)
+	{
+		if (d_filling == null)
+		{
+			d_filling = new Batch();
+		}
+
+		d_filling.ids[d_filling.n_ids++] = id;
+		d_queued++;
+
+		if (d_filling.n_ids == BATCH_SIZE)
+		{
+			flush();
+		}
+	}
+
+	/* Starts looking up the ids which were pushed so far, even if they do
+	 * not fill a batch yet.
+	 */
+	public void flush()
+	{
+		if (d_filling == null)
+		{
+			return;
+		}
+
+		var batch = d_filling;
+		d_filling = null;
+
+		d_batches.offer(batch);
+
+		if (d_pool != null)
+		{
+			try
+			{
+				d_pool.add(batch);
+				return;
+			} catch {}
+		}
+
+		batch.decode(d_repository);
+	}
+
+	/* Gets the next commit in the order the ids were pushed, waiting for it
+	 * to be looked up if needed. Returns false if there are no more ids.
+	 * @commit is null if the commit could not be looked up.
+	 */
+	public bool pop(out Ggit.OId? id, out Commit? commit)
+	{
+		id = null;
+		commit = null;
+
+		if (d_batches.is_empty)
+		{
+			flush();
+		}
+
+		var batch = d_batches.peek();
+
+		if (batch == null)
+		{
+			return false;
+		}
+
+		batch.wait();
+
+		id = batch.ids[d_read];
+		commit = (owned)batch.commits[d_read];
+
+		d_queued--;
+
+		if (++d_read == batch.n_ids)
+		{
+			d_batches.poll();
+			d_read = 0;
+		}
+
+		return true;
+	}
+
+	/* Waits for all pending lookups and stops the worker threads. */
+	public void close()
+	{
+		flush();
+
+		if (d_pool != null)
+		{
+			ThreadPool.free((owned)d_pool, false, true);
+			d_pool = null;
+		}
+
+		d_batches.clear();
+		d_read = 0;
+		d_queued = 0;
+	}
+}
+
+}
+
+// ex:set ts=4 noet
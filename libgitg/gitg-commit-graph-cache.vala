@@ -0,0 +1,652 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+public delegate bool CommitGraphCacheFunc(Ggit.OId id, owned SList<Lane> lanes, int mylane);
+
+public delegate void CommitGraphCacheRowFunc(uint                idx,
+                                             out Ggit.OId        id,
+                                             out uint            mylane,
+                                             out unowned LaneRecord[] lanes,
+                                             out unowned uint16[] from);
+
+/* A point of the cached walk, recorded every so many walked commits: the
+ * digest of the lanes state before laying out commit @id, the position of
+ * @id in the walk and the hash over the ids walked before it.
+ */
+public class CommitGraphCacheCheckpoint
+{
+	public Ggit.OId id;
+	public string digest;
+	public uint position;
+	public uint64 prefix;
+
+	public CommitGraphCacheCheckpoint(Ggit.OId id, string digest, uint position, uint64 prefix)
+	{
+		this.id = id;
+		this.digest = digest;
+		this.position = position;
+		this.prefix = prefix;
+	}
+}
+
+/* The walk a cached layout was computed for. Together with the checkpoints,
+ * this allows CommitModel to bring the cached layout up to date with the
+ * commits which arrived since, like it does for reload_incremental.
+ */
+public class CommitGraphCacheWalk
+{
+	public Ggit.OId[] include;
+	public Ggit.OId[] exclude;
+	public Ggit.OId[] permanent;
+
+	// The number of walked commits, and the hash over their ids
+	public uint length;
+	public uint64 prefix;
+
+	public CommitGraphCacheCheckpoint[] checkpoints;
+
+	public CommitGraphCacheWalk()
+	{
+		include = new Ggit.OId[0];
+		exclude = new Ggit.OId[0];
+		permanent = new Ggit.OId[0];
+		checkpoints = new CommitGraphCacheCheckpoint[0];
+	}
+}
+
+/* Persistent cache of the commit order and lane layout computed by
+ * CommitModel. Each sort mode and lane collapse setting maps to its own file
+ * in $GIT_DIR/gitg/. The file stores the walk it was written for, so once
+ * the included commits moved the cached layout is used as the previous walk
+ * of an incremental reload, instead of walking everything again.
+ */
+public class CommitGraphCache : Object
+{
+	private const uint32 MAGIC = 0x4c474747;
+	private const uint32 VERSION = 3;
+	private const int OID_HEX_SIZE = 40;
+
+	// Only histories larger than this are worth caching, smaller ones
+	// are walked quickly enough
+	private const int MIN_COMMITS = 5000;
+
+	// Maximum number of cached walk configurations kept per repository
+	private const int MAX_FILES = 8;
+
+	private File d_file;
+
+	// The file being read, from read_walk() up to load()
+	private MappedFile? d_mapped;
+	private size_t d_pos;
+	private uint32 d_num_rows;
+
+	public File file
+	{
+		get { return d_file; }
+	}
+
+	public CommitGraphCache(File file)
+	{
+		d_file = file;
+	}
+
+	public static CommitGraphCache? for_walk(Repository repository,
+	                                         Ggit.SortMode sort_mode,
+	                                         Lanes lanes)
+	{
+		var location = repository.get_location();
+
+		if (location == null)
+		{
+			return null;
+		}
+
+		var key = "%u:%d:%d:%d:%d:%d".printf(VERSION,
+		                                     (int)sort_mode,
+		                                     lanes.inactive_max,
+		                                     lanes.inactive_collapse,
+		                                     lanes.inactive_gap,
+		                                     lanes.inactive_enabled ? 1 : 0);
+
+		var name = Checksum.compute_for_string(ChecksumType.SHA1, key) + ".lanes";
+
+		return new CommitGraphCache(location.get_child("gitg").get_child(name));
+	}
+
+	public static bool should_save(uint num_commits)
+	{
+		return num_commits >= MIN_COMMITS;
+	}
+
+	public void invalidate()
+	{
+		try
+		{
+			d_file.delete();
+		} catch {}
+	}
+
+	private bool read_uint8(uint8[] data, ref size_t pos, out uint8 val)
+	{
+		if (pos + 1 > data.length)
+		{
+			val = 0;
+			return false;
+		}
+
+		val = data[pos++];
+		return true;
+	}
+
+	private bool read_uint16(uint8[] data, ref size_t pos, out uint16 val)
+	{
+		if (pos + 2 > data.length)
+		{
+			val = 0;
+			return false;
+		}
+
+		val = (uint16)data[pos] | ((uint16)data[pos + 1] << 8);
+		pos += 2;
+
+		return true;
+	}
+
+	private bool read_uint32(uint8[] data, ref size_t pos, out uint32 val)
+	{
+		if (pos + 4 > data.length)
+		{
+			val = 0;
+			return false;
+		}
+
+		val = (uint32)data[pos] |
+		      ((uint32)data[pos + 1] << 8) |
+		      ((uint32)data[pos + 2] << 16) |
+		      ((uint32)data[pos + 3] << 24);
+
+		pos += 4;
+		return true;
+	}
+
+	private bool read_uint64(uint8[] data, ref size_t pos, out uint64 val)
+	{
+		uint32 low;
+		uint32 high;
+
+		val = 0;
+
+		if (!read_uint32(data, ref pos, out low) ||
+		    !read_uint32(data, ref pos, out high))
+		{
+			return false;
+		}
+
+		val = (uint64)low | ((uint64)high << 32);
+		return true;
+	}
+
+	private bool read_hex(uint8[] data, ref size_t pos, out string? val)
+	{
+		val = null;
+
+		if (pos + OID_HEX_SIZE > data.length)
+		{
+			return false;
+		}
+
+		var hex = new uint8[OID_HEX_SIZE + 1];
+		Memory.copy(hex, &data[pos], OID_HEX_SIZE);
+		hex[OID_HEX_SIZE] = 0;
+
+		pos += OID_HEX_SIZE;
+
+		val = (string)hex;
+		return true;
+	}
+
+	private bool read_oid(uint8[] data, ref size_t pos, out Ggit.OId? val)
+	{
+		string? hex;
+
+		val = null;
+
+		if (!read_hex(data, ref pos, out hex))
+		{
+			return false;
+		}
+
+		val = new Ggit.OId.from_string(hex);
+		return val != null;
+	}
+
+	private bool read_oids(uint8[] data, ref size_t pos, out Ggit.OId[] val)
+	{
+		uint32 n;
+
+		val = new Ggit.OId[0];
+
+		if (!read_uint32(data, ref pos, out n))
+		{
+			return false;
+		}
+
+		for (uint32 i = 0; i < n; i++)
+		{
+			Ggit.OId? id;
+
+			if (!read_oid(data, ref pos, out id))
+			{
+				return false;
+			}
+
+			val += id;
+		}
+
+		return true;
+	}
+
+	private bool read_checkpoint(uint8[] data, ref size_t pos, out CommitGraphCacheCheckpoint? val)
+	{
+		Ggit.OId? id;
+		string? digest;
+		uint32 position;
+		uint64 prefix;
+
+		val = null;
+
+		if (!read_oid(data, ref pos, out id) ||
+		    !read_hex(data, ref pos, out digest) ||
+		    !read_uint32(data, ref pos, out position) ||
+		    !read_uint64(data, ref pos, out prefix))
+		{
+			return false;
+		}
+
+		val = new CommitGraphCacheCheckpoint(id, digest, position, prefix);
+		return true;
+	}
+
+	private bool read_lane(uint8[] data, ref size_t pos, out Lane? lane)
+	{
+		uint8 color;
+		uint8 tag;
+		uint16 nfrom;
+
+		lane = null;
+
+		if (!read_uint8(data, ref pos, out color) ||
+		    !read_uint8(data, ref pos, out tag) ||
+		    !read_uint16(data, ref pos, out nfrom))
+		{
+			return false;
+		}
+
+		if (color >= Color.palette_size())
+		{
+			return false;
+		}
+
+		var c = new Color();
+		c.idx = color;
+
+		var ret = new Lane.with_color(c);
+		ret.tag = (LaneTag)tag;
+
+		for (var i = 0; i < nfrom; i++)
+		{
+			uint16 from;
+
+			if (!read_uint16(data, ref pos, out from))
+			{
+				return false;
+			}
+
+			ret.from.prepend((int)from);
+		}
+
+		ret.from.reverse();
+
+		lane = ret;
+		return true;
+	}
+
+	/* Reads the walk the cache was written for, or returns null if there is
+	 * no (valid) cache. The layout itself is replayed by load() afterwards.
+	 */
+	public CommitGraphCacheWalk? read_walk()
+	{
+		d_mapped = null;
+
+		MappedFile mapped;
+
+		try
+		{
+			mapped = new MappedFile(d_file.get_path(), false);
+		}
+		catch
+		{
+			return null;
+		}
+
+		var bytes = mapped.get_bytes();
+		unowned uint8[] data = bytes.get_data();
+
+		size_t pos = 0;
+		uint32 magic;
+		uint32 version;
+		uint32 length;
+		uint32 ncheckpoints;
+
+		if (!read_uint32(data, ref pos, out magic) ||
+		    !read_uint32(data, ref pos, out version))
+		{
+			return null;
+		}
+
+		if (magic != MAGIC || version != VERSION)
+		{
+			return null;
+		}
+
+		Ggit.OId[] include;
+		Ggit.OId[] exclude;
+		Ggit.OId[] permanent;
+		uint64 prefix;
+
+		if (!read_oids(data, ref pos, out include) ||
+		    !read_oids(data, ref pos, out exclude) ||
+		    !read_oids(data, ref pos, out permanent) ||
+		    !read_uint32(data, ref pos, out length) ||
+		    !read_uint64(data, ref pos, out prefix) ||
+		    !read_uint32(data, ref pos, out ncheckpoints))
+		{
+			return null;
+		}
+
+		var checkpoints = new CommitGraphCacheCheckpoint[0];
+
+		for (uint32 i = 0; i < ncheckpoints; i++)
+		{
+			CommitGraphCacheCheckpoint? checkpoint;
+
+			if (!read_checkpoint(data, ref pos, out checkpoint))
+			{
+				return null;
+			}
+
+			checkpoints += checkpoint;
+		}
+
+		if (!read_uint32(data, ref pos, out d_num_rows))
+		{
+			return null;
+		}
+
+		d_mapped = mapped;
+		d_pos = pos;
+
+		var ret = new CommitGraphCacheWalk();
+
+		ret.include = include;
+		ret.exclude = exclude;
+		ret.permanent = permanent;
+		ret.length = length;
+		ret.prefix = prefix;
+		ret.checkpoints = checkpoints;
+
+		return ret;
+	}
+
+	/* Replays the cached layout by calling @func for each commit, in order.
+	 * Requires a successful read_walk() first. Returns true if the complete
+	 * cache was replayed, false if the cache turned out to be invalid or if
+	 * @func requested to stop.
+	 */
+	public bool load(CommitGraphCacheFunc func, Cancellable? cancellable = null)
+	{
+		if (d_mapped == null)
+		{
+			return false;
+		}
+
+		// Keeps the file mapped while replaying
+		var mapped = d_mapped;
+		d_mapped = null;
+
+		var bytes = mapped.get_bytes();
+		unowned uint8[] data = bytes.get_data();
+		var pos = d_pos;
+
+		for (uint32 i = 0; i < d_num_rows; i++)
+		{
+			Ggit.OId? id;
+			uint16 mylane;
+			uint16 nlanes;
+
+			if (cancellable != null && cancellable.is_cancelled())
+			{
+				return false;
+			}
+
+			if (!read_oid(data, ref pos, out id) ||
+			    !read_uint16(data, ref pos, out mylane) ||
+			    !read_uint16(data, ref pos, out nlanes))
+			{
+				return false;
+			}
+
+			var lanes = new SList<Lane>();
+
+			for (var j = 0; j < nlanes; j++)
+			{
+				Lane? lane;
+
+				if (!read_lane(data, ref pos, out lane))
+				{
+					return false;
+				}
+
+				lanes.prepend(lane);
+			}
+
+			lanes.reverse();
+
+			if (!func(id, (owned)lanes, mylane))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	private void write_oid(DataOutputStream stream, Ggit.OId id) throws IOError
+	{
+		stream.put_string(id.to_string());
+	}
+
+	private void write_oids(DataOutputStream stream, Ggit.OId[] ids) throws IOError
+	{
+		stream.put_uint32((uint32)ids.length);
+
+		foreach (var id in ids)
+		{
+			write_oid(stream, id);
+		}
+	}
+
+	private void write_walk(DataOutputStream stream, CommitGraphCacheWalk walk) throws IOError
+	{
+		write_oids(stream, walk.include);
+		write_oids(stream, walk.exclude);
+		write_oids(stream, walk.permanent);
+
+		stream.put_uint32((uint32)walk.length);
+		stream.put_uint64(walk.prefix);
+		stream.put_uint32((uint32)walk.checkpoints.length);
+
+		foreach (var checkpoint in walk.checkpoints)
+		{
+			write_oid(stream, checkpoint.id);
+			stream.put_string(checkpoint.digest);
+			stream.put_uint32((uint32)checkpoint.position);
+			stream.put_uint64(checkpoint.prefix);
+		}
+	}
+
+	private void write_row(DataOutputStream stream, uint idx, CommitGraphCacheRowFunc func) throws IOError
+	{
+		Ggit.OId id;
+		uint mylane;
+		unowned LaneRecord[] lanes;
+		unowned uint16[] from;
+
+		func(idx, out id, out mylane, out lanes, out from);
+
+		write_oid(stream, id);
+		stream.put_uint16((uint16)mylane);
+		stream.put_uint16((uint16)lanes.length);
+
+		foreach (var lane in lanes)
+		{
+			stream.put_byte(lane.color);
+			stream.put_byte(lane.tag);
+			stream.put_uint16(lane.nfrom);
+
+			for (uint i = 0; i < lane.nfrom; i++)
+			{
+				stream.put_uint16(from[lane.from + i]);
+			}
+		}
+	}
+
+	/* Writes the layout of @num_commits rows computed by @walk, which are
+	 * retrieved in order using @func.
+	 */
+	public void save(CommitGraphCacheWalk walk, uint num_commits, CommitGraphCacheRowFunc func, Cancellable? cancellable = null)
+	{
+		var dir = d_file.get_parent();
+		var tmp = dir.get_child(d_file.get_basename() + ".tmp");
+
+		try
+		{
+			try
+			{
+				dir.make_directory_with_parents(cancellable);
+			} catch (IOError.EXISTS e) {}
+
+			var stream = tmp.replace(null, false, FileCreateFlags.REPLACE_DESTINATION, cancellable);
+			var buffered = new BufferedOutputStream.sized(stream, 64 * 1024);
+			var os = new DataOutputStream(buffered);
+
+			os.byte_order = DataStreamByteOrder.LITTLE_ENDIAN;
+
+			os.put_uint32(MAGIC);
+			os.put_uint32(VERSION);
+
+			write_walk(os, walk);
+
+			os.put_uint32((uint32)num_commits);
+
+			for (uint i = 0; i < num_commits; i++)
+			{
+				if (cancellable != null && cancellable.is_cancelled())
+				{
+					throw new IOError.CANCELLED("cancelled");
+				}
+
+				write_row(os, i, func);
+			}
+
+			os.close(cancellable);
+			tmp.move(d_file, FileCopyFlags.OVERWRITE, cancellable);
+		}
+		catch (Error e)
+		{
+			if (!(e is IOError.CANCELLED))
+			{
+				stderr.printf("Failed to write commit graph cache: %s\n", e.message);
+			}
+
+			try
+			{
+				tmp.delete();
+			} catch {}
+
+			return;
+		}
+
+		prune(dir);
+	}
+
+	private void prune(File dir)
+	{
+		var files = new Gee.ArrayList<FileInfo>();
+
+		try
+		{
+			var e = dir.enumerate_children(FileAttribute.STANDARD_NAME + "," +
+			                               FileAttribute.TIME_MODIFIED,
+			                               FileQueryInfoFlags.NONE);
+
+			FileInfo? info;
+
+			while ((info = e.next_file()) != null)
+			{
+				if (info.get_name().has_suffix(".lanes"))
+				{
+					files.add(info);
+				}
+			}
+		}
+		catch
+		{
+			return;
+		}
+
+		if (files.size <= MAX_FILES)
+		{
+			return;
+		}
+
+		// Newest first
+		files.sort((a, b) => {
+			var ta = a.get_attribute_uint64(FileAttribute.TIME_MODIFIED);
+			var tb = b.get_attribute_uint64(FileAttribute.TIME_MODIFIED);
+
+			return ta < tb ? 1 : (ta > tb ? -1 : 0);
+		});
+
+		for (var i = MAX_FILES; i < files.size; i++)
+		{
+			try
+			{
+				dir.get_child(files[i].get_name()).delete();
+			} catch {}
+		}
+	}
+}
+
+}
+
+// ex:set ts=4 noet
@@ -21,11 +21,55 @@ namespace Gitg
 {
 	public class CommitListView : Gtk.TreeView, Gtk.Buildable
 	{
+		private Gtk.Adjustment? d_vadjustment;
+		private ulong d_vadjustment_changed_id;
+
 		public CommitListView(CommitModel model)
 		{
 			Object(model: model);
 		}
 
+		construct
+		{
+			notify["vadjustment"].connect(update_vadjustment);
+			update_vadjustment();
+		}
+
+		private void update_vadjustment()
+		{
+			if (d_vadjustment != null)
+			{
+				d_vadjustment.disconnect(d_vadjustment_changed_id);
+				d_vadjustment_changed_id = 0;
+			}
+
+			d_vadjustment = vadjustment;
+
+			if (d_vadjustment != null)
+			{
+				d_vadjustment_changed_id = d_vadjustment.value_changed.connect(prefetch_visible);
+			}
+		}
+
+		private void prefetch_visible()
+		{
+			CommitModel? m = model as CommitModel;
+			Gtk.TreePath start;
+			Gtk.TreePath end;
+
+			if (m == null || !get_visible_range(out start, out end))
+			{
+				return;
+			}
+
+			// Prefetch a page around the visible rows in both directions
+			var first = start.get_indices()[0];
+			var last = end.get_indices()[0];
+			var page = last - first + 1;
+
+			m.prefetch((uint)int.max(first - page, 0), (uint)(last + page + 1));
+		}
+
 		public CommitListView.for_repository(Repository repository)
 		{
 			this(new CommitModel(repository));
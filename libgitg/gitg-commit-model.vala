@@ -65,15 +65,16 @@ namespace Gitg
 	{
 		private Repository d_repository;
 		private Cancellable? d_cancellable;
-		private Commit[] d_ids;
-		private Commit[] d_hidden_ids;
+		private RowStore d_rows;
 		private Thread<void*>? d_thread;
 		private Ggit.RevisionWalker? d_walker;
 		private uint d_advertized_size;
 		private uint d_idleid;
 		private Lanes d_lanes;
 		private Ggit.SortMode d_sortmode;
-		private Gee.HashMap<Ggit.OId, int> d_id_hash;
+		private OIdTable d_id_hash;
+		private Ggit.OId[] d_hash_pending;
+		private uint d_hash_pending_start;
 
 		private Ggit.OId[] d_include;
 		private Ggit.OId[] d_exclude;
@@ -81,8 +82,318 @@ namespace Gitg
 		private uint d_size;
 		private int d_stamp;
 
+		// Every so many walked commits, the lanes state is recorded so that
+		// a later incremental walk can detect where it converges
+		private const uint CHECKPOINT_INTERVAL = 256;
+
+		// Base of the polynomial hash over the walked commit ids
+		private const uint64 WALK_HASH_BASE = 1099511628211;
+
+		// Above this many replaced rows, reset the view instead of
+		// emitting per row changes
+		private const uint SPLICE_RESET_THRESHOLD = 10000;
+
+		// Rows of which the commit has been released are looked up again on
+		// demand, the most recently used ones are kept around
+		private const uint DEFAULT_COMMIT_CACHE_SIZE = 1000;
+
+		// Number of rows materialized per prefetch iteration
+		private const uint PREFETCH_BATCH = 64;
+
+		// Commits whose lanes are frozen are released in batches of at
+		// least this many
+		private const uint RELEASE_BATCH = 64;
+
+		// Number of commits looked up ahead of the layout while walking
+		private const uint DECODE_AHEAD = 4096;
+
+		/* A row of the model. While the lanes of a commit are still being
+		 * laid out, the row keeps the commit itself. Afterwards only the id
+		 * and the location of the frozen lanes are kept and the commit is
+		 * looked up again when needed.
+		 */
+		private struct CommitRow
+		{
+			public Ggit.OId id;
+			public Commit? commit;
+			public LaneStore? store;
+			public uint chunk;
+			public uint first;
+			public uint nlanes;
+			public uint mylane;
+		}
+
+		private class CommitCache
+		{
+			private class Entry
+			{
+				public uint idx;
+				public Commit commit;
+				public Entry? next;
+				public unowned Entry? prev;
+			}
+
+			private Gee.HashMap<uint, Entry> d_entries;
+			private Entry? d_head;
+			private unowned Entry? d_tail;
+			private uint d_capacity;
+
+			public CommitCache(uint capacity)
+			{
+				d_entries = new Gee.HashMap<uint, Entry>();
+				d_capacity = capacity;
+			}
+
+			public uint capacity
+			{
+				get { return d_capacity; }
+				set
+				{
+					d_capacity = value;
+					trim();
+				}
+			}
+
+			public Commit? lookup(uint idx)
+			{
+				var entry = d_entries.get(idx);
+
+				if (entry == null)
+				{
+					return null;
+				}
+
+				if (entry != d_head)
+				{
+					unlink(entry);
+					push_front(entry);
+				}
+
+				return entry.commit;
+			}
+
+			public void insert(uint idx, Commit commit)
+			{
+				var entry = d_entries.get(idx);
+
+				if (entry != null)
+				{
+					unlink(entry);
+				}
+				else
+				{
+					entry = new Entry();
+					entry.idx = idx;
+
+					d_entries.set(idx, entry);
+				}
+
+				entry.commit = commit;
+				push_front(entry);
+
+				trim();
+			}
+
+			public void clear()
+			{
+				d_entries.clear();
+
+				d_head = null;
+				d_tail = null;
+			}
+
+			private void trim()
+			{
+				while (d_entries.size > d_capacity && d_tail != null)
+				{
+					Entry tail = d_tail;
+
+					unlink(tail);
+					d_entries.unset(tail.idx);
+				}
+			}
+
+			private void unlink(Entry entry)
+			{
+				if (entry.prev != null)
+				{
+					entry.prev.next = entry.next;
+				}
+				else
+				{
+					d_head = entry.next;
+				}
+
+				if (entry.next != null)
+				{
+					entry.next.prev = entry.prev;
+				}
+				else
+				{
+					d_tail = entry.prev;
+				}
+
+				entry.next = null;
+				entry.prev = null;
+			}
+
+			private void push_front(Entry entry)
+			{
+				entry.next = d_head;
+
+				if (d_head != null)
+				{
+					d_head.prev = entry;
+				}
+
+				d_head = entry;
+
+				if (d_tail == null)
+				{
+					d_tail = entry;
+				}
+			}
+		}
+
+		/* Append-only storage of the rows. The rows are kept in chunks of
+		 * which the size doubles, chunk k holding ROW_CHUNK_BASE << k rows,
+		 * so rows never move once appended and the chunk directory never
+		 * grows. The length is published atomically after appending, rows
+		 * below the published length can be read without taking a lock.
+		 */
+		private class RowStore
+		{
+			private const int N_CHUNKS = 32;
+			private const uint CHUNK_BITS = 10;
+
+			private class Chunk
+			{
+				public CommitRow[] rows;
+
+				public Chunk(uint size)
+				{
+					rows = new CommitRow[size];
+				}
+			}
+
+			private Chunk?[] d_chunks;
+			private uint d_length;
+
+			public RowStore()
+			{
+				d_chunks = new Chunk?[N_CHUNKS];
+			}
+
+			public uint length
+			{
+				get { return AtomicUint.get(ref d_length); }
+			}
+
+			private static void locate(uint idx, out uint chunk, out uint offset)
+			{
+				chunk = (uint)Bit.nth_msf((idx >> CHUNK_BITS) + 1, -1);
+				offset = idx - ((((uint)1 << chunk) - 1) << CHUNK_BITS);
+			}
+
+			public CommitRow @get(uint idx)
+			{
+				uint chunk;
+				uint offset;
+
+				locate(idx, out chunk, out offset);
+				return d_chunks[chunk].rows[offset];
+			}
+
+			public void @set(uint idx, CommitRow row)
+			{
+				uint chunk;
+				uint offset;
+
+				locate(idx, out chunk, out offset);
+				d_chunks[chunk].rows[offset] = row;
+			}
+
+			/* Appends @row. Only a single thread may append at a time. */
+			public void append(CommitRow row)
+			{
+				var idx = d_length;
+				uint chunk;
+				uint offset;
+
+				locate(idx, out chunk, out offset);
+
+				if (d_chunks[chunk] == null)
+				{
+					d_chunks[chunk] = new Chunk((uint)1 << (chunk + CHUNK_BITS));
+				}
+
+				d_chunks[chunk].rows[offset] = row;
+				AtomicUint.set(ref d_length, idx + 1);
+			}
+		}
+
+		private CommitCache d_commit_cache;
+
+		// Rows below this index have been released and are not modified
+		// anymore, they are read without locking. Other rows are only read
+		// and written while holding the d_rows lock.
+		private uint d_released;
+
+		private CommitSearchIndex? d_search_index;
+		private Cancellable? d_search_index_cancellable;
+
+		private uint d_prefetch_start;
+		private uint d_prefetch_end;
+		private uint d_prefetch_id;
+
+		private class WalkCheckpoint
+		{
+			public string digest;
+			public uint position;
+			public uint64 prefix;
+
+			public WalkCheckpoint(string digest, uint position, uint64 prefix)
+			{
+				this.digest = digest;
+				this.position = position;
+				this.prefix = prefix;
+			}
+		}
+
+		// State of the last complete walk
+		private Gee.HashMap<Ggit.OId, WalkCheckpoint>? d_checkpoints;
+		private uint d_walk_length;
+		private uint64 d_walk_prefix;
+		private Ggit.OId[] d_walk_include;
+		private Ggit.OId[] d_walk_exclude;
+		private Ggit.OId[] d_walk_permanent;
+		private Ggit.SortMode d_walk_sortmode;
+		private bool d_walk_incremental;
+
 		public uint limit { get; set; }
 
+		public bool use_graph_cache { get; set; default = true; }
+
+		/* Whether to build a search index of the rows while walking. */
+		public bool search_index_enabled { get; set; default = false; }
+
+		/* The search index of the rows, if enabled. A new index is created
+		 * for every reload.
+		 */
+		public CommitSearchIndex? search_index
+		{
+			get { return d_search_index; }
+		}
+
+		/* The maximum number of commits kept for rows which are not being
+		 * laid out anymore.
+		 */
+		public uint commit_cache_size
+		{
+			get { return d_commit_cache.capacity; }
+			set { d_commit_cache.capacity = uint.max(value, 1); }
+		}
+
 		public Ggit.SortMode sort_mode
 		{
 			get { return d_sortmode; }
@@ -138,6 +449,7 @@ namespace Gitg
 		construct
 		{
 			d_lanes = new Lanes();
+			d_commit_cache = new CommitCache(DEFAULT_COMMIT_CACHE_SIZE);
 			d_sortmode = Ggit.SortMode.TOPOLOGICAL | Ggit.SortMode.TIME;
 		}
 
@@ -146,7 +458,7 @@ namespace Gitg
 			cancel();
 		}
 
-		private void cancel()
+		private void stop_walk()
 		{
 			if (d_cancellable != null)
 			{
@@ -167,14 +479,30 @@ namespace Gitg
 					d_idleid = 0;
 				}
 			}
+		}
 
+		private void cancel()
+		{
+			stop_walk();
 			clear();
 
-			d_ids = new Commit[0];
-			d_hidden_ids = new Commit[0];
+			d_rows = new RowStore();
+			d_released = 0;
 			d_advertized_size = 0;
 
-			d_id_hash = new Gee.HashMap<Ggit.OId, int>();
+			d_commit_cache.clear();
+			stop_prefetch();
+
+			if (d_search_index_cancellable != null)
+			{
+				d_search_index_cancellable.cancel();
+				d_search_index_cancellable = null;
+			}
+
+			d_search_index = null;
+
+			d_id_hash = new OIdTable();
+			d_checkpoints = null;
 		}
 
 		public void reload()
@@ -189,328 +517,1289 @@ namespace Gitg
 			var cancellable = new Cancellable();
 			d_cancellable = cancellable;
 
+			if (search_index_enabled)
+			{
+				d_search_index = new CommitSearchIndex(d_repository);
+			}
+
 			started();
 
 			walk.begin(cancellable, (obj, res) => {
-				walk.end(res);
+				var resume = walk.end(res);
 
 				d_thread.join();
 				d_thread = null;
 
+				if (resume && !cancellable.is_cancelled())
+				{
+					// The cached layout is of a previous walk, bring it up to
+					// date with the commits which arrived since
+					d_cancellable = new Cancellable();
+					walk_incremental.begin(d_cancellable, true);
+					return;
+				}
+
 				finished();
 				d_cancellable = null;
 			});
 		}
 
-		public uint size()
-		{
-			return d_advertized_size;
+		/* Updates the model after the included commits changed, without
+		 * clearing it first. Only the commits up to the point where the new
+		 * lane layout converges with the previous one are laid out again,
+		 * the remaining rows are kept as they are. Falls back to a full
+		 * reload() when the previous walk cannot be reused. The ids of the
+		 * whole history are still walked to verify that the kept rows did not
+		 * change, only looking up and laying out commits is saved.
+		 */
+		public void reload_incremental()
+		{
+			if (d_repository == null || get_include().length == 0)
+			{
+				reload();
+				return;
+			}
+
+			if (d_cancellable != null && d_walk_incremental)
+			{
+				// Restart, the previous complete walk is still what is shown
+				stop_walk();
+			}
+
+			if (d_cancellable != null ||
+			    d_checkpoints == null ||
+			    limit != 0 ||
+			    d_walk_sortmode != d_sortmode ||
+			    !same_ids(d_walk_exclude, d_exclude))
+			{
+				reload();
+				return;
+			}
+
+			if (same_ids(d_walk_include, d_include) &&
+			    same_ids(d_walk_permanent, get_permanent_lanes()))
+			{
+				finished();
+				return;
+			}
+
+			var cancellable = new Cancellable();
+			d_cancellable = cancellable;
+
+			walk_incremental.begin(cancellable);
+		}
+
+		private static bool same_ids(Ggit.OId[]? a, Ggit.OId[]? b)
+		{
+			var na = a != null ? a.length : 0;
+			var nb = b != null ? b.length : 0;
+
+			if (na != nb)
+			{
+				return false;
+			}
+
+			for (var i = 0; i < na; i++)
+			{
+				if (!a[i].equal(b[i]))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		private static void add_symmetric_difference(Gee.HashSet<Ggit.OId> ret,
+		                                             Ggit.OId[]? a,
+		                                             Ggit.OId[]? b)
+		{
+			var sa = new Gee.HashSet<Ggit.OId>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+			                                   (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+			var sb = new Gee.HashSet<Ggit.OId>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+			                                   (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+			if (a != null)
+			{
+				foreach (var id in a)
+				{
+					sa.add(id);
+				}
+			}
+
+			if (b != null)
+			{
+				foreach (var id in b)
+				{
+					sb.add(id);
+				}
+			}
+
+			foreach (var id in sa)
+			{
+				if (!sb.contains(id))
+				{
+					ret.add(id);
+				}
+			}
+
+			foreach (var id in sb)
+			{
+				if (!sa.contains(id))
+				{
+					ret.add(id);
+				}
+			}
+		}
+
+		public uint size()
+		{
+			return d_advertized_size;
+		}
+
+		public new Commit? @get(uint idx)
+		{
+			CommitRow row;
+
+			if (idx >= d_advertized_size)
+			{
+				return null;
+			}
+
+			if (idx < AtomicUint.get(ref d_released))
+			{
+				row = d_rows[idx];
+			}
+			else
+			{
+				lock(d_rows)
+				{
+					row = d_rows[idx];
+				}
+			}
+
+			if (row.commit != null)
+			{
+				return row.commit;
+			}
+
+			var ret = d_commit_cache.lookup(idx);
+
+			if (ret != null || row.store == null)
+			{
+				return ret;
+			}
+
+			try
+			{
+				ret = d_repository.lookup<Commit>(row.id);
+			}
+			catch (Error e)
+			{
+				stderr.printf("Failed to lookup commit %s: %s\n", row.id.to_string(), e.message);
+				return null;
+			}
+
+			// Restore the lanes, which were frozen before the commit of the
+			// row was released
+			ret.set_frozen_lanes(row.store, row.chunk, row.first, row.nlanes, row.mylane);
+
+			d_commit_cache.insert(idx, ret);
+			return ret;
+		}
+
+		/* Looks up the commits of the rows from @start up to @end in the
+		 * background (when idle), so that they are readily available when
+		 * these rows get shown.
+		 */
+		public void prefetch(uint start, uint end)
+		{
+			d_prefetch_start = start;
+			d_prefetch_end = uint.min(end, start + d_commit_cache.capacity);
+
+			if (d_prefetch_id == 0)
+			{
+				d_prefetch_id = Idle.add(prefetch_idle, Priority.LOW);
+			}
+		}
+
+		private bool prefetch_idle()
+		{
+			var end = uint.min(d_prefetch_end, d_advertized_size);
+			uint n = 0;
+
+			while (d_prefetch_start < end && n < PREFETCH_BATCH)
+			{
+				this[d_prefetch_start++];
+				n++;
+			}
+
+			if (d_prefetch_start >= end)
+			{
+				d_prefetch_id = 0;
+				return false;
+			}
+
+			return true;
+		}
+
+		private void stop_prefetch()
+		{
+			if (d_prefetch_id != 0)
+			{
+				Source.remove(d_prefetch_id);
+				d_prefetch_id = 0;
+			}
+		}
+
+		public void set_include(Ggit.OId[] ids)
+		{
+			this.d_include = ids;
+		}
+
+		public Ggit.OId[] get_include()
+		{
+			return this.d_include;
+		}
+
+		public void set_exclude(Ggit.OId[] ids)
+		{
+			this.d_exclude = ids;
+		}
+
+		/* Adds the rows appended since the last batch to the id hash. This is
+		 * done once per batch rather than for every row, the rows of a batch
+		 * are not looked up by id before they are advertized anyway.
+		 */
+		private void flush_id_hash()
+		{
+			if (d_hash_pending.length == 0)
+			{
+				return;
+			}
+
+			lock(d_id_hash)
+			{
+				for (var i = 0; i < d_hash_pending.length; i++)
+				{
+					d_id_hash.set(d_hash_pending[i], d_hash_pending_start + i);
+				}
+			}
+
+			d_hash_pending = new Ggit.OId[0];
+		}
+
+		private void notify_batch(owned SourceFunc? finishedcb)
+		{
+			flush_id_hash();
+
+			lock(d_idleid)
+			{
+				if (d_idleid != 0)
+				{
+					Source.remove(d_idleid);
+					d_idleid = 0;
+				}
+
+				uint newsize = d_rows.length;
+
+				d_idleid = Idle.add(() => {
+					lock(d_idleid)
+					{
+						if (d_idleid == 0)
+						{
+							return false;
+						}
+
+						d_idleid = 0;
+
+						uint added = newsize - d_advertized_size;
+						d_advertized_size = newsize;
+
+						emit_update(added);
+
+						if (finishedcb != null)
+						{
+							finishedcb();
+						}
+					}
+
+					return false;
+				});
+			}
+		}
+
+		private void append_row(CommitRow row)
+		{
+			var idx = d_rows.length;
+
+			if (d_hash_pending.length == 0)
+			{
+				d_hash_pending_start = idx;
+			}
+
+			d_hash_pending += row.id;
+
+			d_rows.append(row);
+
+			if (row.commit == null && d_released == idx)
+			{
+				AtomicUint.set(ref d_released, idx + 1);
+			}
+		}
+
+		private void append_commit(Commit commit)
+		{
+			append_row(CommitRow() {
+				id = commit.get_id(),
+				commit = commit
+			});
+		}
+
+		private static bool release_commit(ref CommitRow row)
+		{
+			LaneStore? store;
+
+			if (row.commit == null)
+			{
+				return true;
+			}
+
+			if (!row.commit.get_frozen_lanes(out store,
+			                                 out row.chunk,
+			                                 out row.first,
+			                                 out row.nlanes))
+			{
+				return false;
+			}
+
+			row.store = store;
+			row.mylane = row.commit.mylane;
+			row.commit = null;
+
+			return true;
+		}
+
+		private static CommitRow released_row(Commit commit)
+		{
+			var row = CommitRow() {
+				id = commit.get_id(),
+				commit = commit
+			};
+
+			release_commit(ref row);
+			return row;
+		}
+
+		/* Releases the commits of the rows of which the lanes have been
+		 * frozen, in order.
+		 */
+		private void release_commits(bool force = false)
+		{
+			var length = d_rows.length;
+
+			if (!force && length - d_released < RELEASE_BATCH)
+			{
+				return;
+			}
+
+			lock(d_rows)
+			{
+				var released = d_released;
+
+				while (released < length)
+				{
+					var row = d_rows[released];
+
+					if (!release_commit(ref row))
+					{
+						break;
+					}
+
+					d_rows[released] = row;
+					released++;
+				}
+
+				AtomicUint.set(ref d_released, released);
+			}
+		}
+
+		private static uint64 walk_hash_next(uint64 prefix, Ggit.OId id)
+		{
+			return prefix * WALK_HASH_BASE + id.hash();
+		}
+
+		private static uint64 walk_hash_pow(uint n)
+		{
+			uint64 ret = 1;
+			uint64 b = WALK_HASH_BASE;
+
+			while (n > 0)
+			{
+				if ((n & 1) != 0)
+				{
+					ret *= b;
+				}
+
+				b *= b;
+				n >>= 1;
+			}
+
+			return ret;
+		}
+
+		private bool setup_walker(Ggit.OId[] included,
+		                          Ggit.OId[] excluded,
+		                          Ggit.OId[] permlanes)
+		{
+			if (d_walker == null)
+			{
+				try
+				{
+					d_walker = new Ggit.RevisionWalker(d_repository);
+				}
+				catch
+				{
+					return false;
+				}
+			}
+
+			d_walker.reset();
+			d_walker.set_sort_mode(d_sortmode);
+
+			var incset = new Gee.HashSet<Ggit.OId>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+			                                       (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+			foreach (Ggit.OId oid in included)
+			{
+				try
+				{
+					d_walker.push(oid);
+					incset.add(oid);
+				} catch {};
+			}
+
+			foreach (Ggit.OId oid in excluded)
+			{
+				try
+				{
+					d_walker.hide(oid);
+					incset.remove(oid);
+				} catch {};
+			}
+
+			var permanent = new Ggit.OId[0];
+
+			foreach (Ggit.OId oid in permlanes)
+			{
+				try
+				{
+					d_walker.push(oid);
+					permanent += oid;
+				} catch {}
+			}
+
+			d_lanes.reset(permanent, incset);
+			return true;
+		}
+
+		private delegate void AppendFunc(Commit commit);
+
+		private void layout_commit(Commit commit, AppendFunc append)
+		{
+			int mylane;
+			SList<Lane> lanes;
+
+			bool finded = d_lanes.next(commit, out lanes, out mylane, true);
+
+			if (finded)
+			{
+				debug ("finded parent for %s %s\n", commit.get_subject(), commit.get_id().to_string());
+
+				commit.update_lanes((owned)lanes, mylane);
+				append(commit);
+			}
+
+			Commit? miss_commit;
+
+			// Retry the commits which were missed before, now that there may
+			// be a lane for them
+			while ((miss_commit = d_lanes.next_unmissed()) != null)
+			{
+				debug ("trying again %s %s", miss_commit.get_subject(), miss_commit.get_id().to_string());
+
+				if (d_lanes.next(miss_commit, out lanes, out mylane))
+				{
+					debug ("finded parent for miss %s %s\n", miss_commit.get_subject(), miss_commit.get_id().to_string());
+
+					miss_commit.update_lanes((owned)lanes, mylane);
+					append(miss_commit);
+				}
+			}
+		}
+
+		private void take_checkpoint(Gee.HashMap<Ggit.OId, WalkCheckpoint> checkpoints,
+		                             Ggit.OId                              id,
+		                             uint                                  position,
+		                             uint64                                prefix,
+		                             string?                               digest = null)
+		{
+			if (position % CHECKPOINT_INTERVAL == 0)
+			{
+				checkpoints.set(id, new WalkCheckpoint(digest != null ? digest : d_lanes.state_digest(),
+				                                       position,
+				                                       prefix));
+			}
+		}
+
+		private Gee.HashMap<Ggit.OId, WalkCheckpoint> new_checkpoints()
+		{
+			return new Gee.HashMap<Ggit.OId, WalkCheckpoint>((i) => { return i.hash(); }, (a, b) => { return a.equal(b); });
+		}
+
+		private void store_walk_state(Gee.HashMap<Ggit.OId, WalkCheckpoint>? checkpoints,
+		                              uint                                   length,
+		                              uint64                                 prefix,
+		                              Ggit.OId[]                             included,
+		                              Ggit.OId[]                             excluded,
+		                              Ggit.OId[]                             permanent)
+		{
+			d_checkpoints = checkpoints;
+			d_walk_length = length;
+			d_walk_prefix = prefix;
+			d_walk_include = included;
+			d_walk_exclude = excluded;
+			d_walk_permanent = permanent;
+			d_walk_sortmode = d_sortmode;
+		}
+
+		private CommitGraphCacheWalk cache_walk(Gee.HashMap<Ggit.OId, WalkCheckpoint> checkpoints,
+		                                        uint                                  length,
+		                                        uint64                                prefix,
+		                                        Ggit.OId[]                            included,
+		                                        Ggit.OId[]                            excluded,
+		                                        Ggit.OId[]                            permanent)
+		{
+			var cps = new CommitGraphCacheCheckpoint[0];
+
+			foreach (var entry in checkpoints.entries)
+			{
+				var cp = entry.value;
+				cps += new CommitGraphCacheCheckpoint(entry.key, cp.digest, cp.position, cp.prefix);
+			}
+
+			var ret = new CommitGraphCacheWalk();
+
+			ret.include = included;
+			ret.exclude = excluded;
+			ret.permanent = permanent;
+			ret.length = length;
+			ret.prefix = prefix;
+			ret.checkpoints = cps;
+
+			return ret;
+		}
+
+		private Gee.HashMap<Ggit.OId, WalkCheckpoint> cached_checkpoints(CommitGraphCacheWalk walk)
+		{
+			var ret = new_checkpoints();
+
+			foreach (var cp in walk.checkpoints)
+			{
+				ret.set(cp.id, new WalkCheckpoint(cp.digest, cp.position, cp.prefix));
+			}
+
+			return ret;
+		}
+
+		private void save_graph_cache(CommitGraphCache    cache,
+		                              CommitGraphCacheWalk walk,
+		                              RowStore            rows,
+		                              Cancellable         cancellable)
+		{
+			var span = Trace.begin();
+
+			cache.save(walk, rows.length, (idx, out id, out mylane, out lanes, out from) => {
+				var row = rows[idx];
+
+				id = row.id;
+				mylane = row.mylane;
+				lanes = row.store.get_lanes(row.chunk, row.first, row.nlanes, out from);
+			}, cancellable);
+
+			Trace.end(span, "CommitModel.save_graph_cache");
+		}
+
+		/* Walks the history and lays it out, or restores the layout from the
+		 * graph cache. Returns true when the restored layout is of other
+		 * included commits and still needs to be brought up to date.
+		 */
+		private async bool walk(Cancellable cancellable)
+		{
+			Ggit.OId[] included = d_include;
+			Ggit.OId[] excluded = d_exclude;
+
+			uint limit = this.limit;
+
+			SourceFunc cb = walk.callback;
+
+			// First time, wait a bit longer to make loading small repositories
+			// subjectively quicker
+			var wait_elapsed_initial = 1.0;
+
+			// After initial wait elapsed, continue with incremental updates at
+			// a quicker pace
+			var wait_elapsed_incremental = 0.2;
+
+			var wait_elapsed = wait_elapsed_initial;
+
+			var permlanes = get_permanent_lanes();
+
+			var checkpoints = new_checkpoints();
+			uint position = 0;
+			uint64 prefix = 0;
+			bool complete = false;
+			bool cached = false;
+			CommitGraphCacheWalk? cached_walk = null;
+
+			var search_index = d_search_index;
+
+			d_walk_incremental = false;
+
+			var walk_span = Trace.begin();
+
+			ThreadFunc<void*> run = () => {
+				var span = Trace.begin();
+
+				if (!setup_walker(included, excluded, permlanes))
+				{
+					notify_batch((owned)cb);
+					return null;
+				}
+
+				Trace.end(span, "CommitModel.setup_walker");
+
+				// The rows were reset when cancelling the previous walk
+				Timer timer = new Timer();
+
+				lock(d_id_hash)
+				{
+					d_id_hash = new OIdTable();
+				}
+
+				d_hash_pending = new Ggit.OId[0];
+
+				CommitGraphCache? cache = null;
+
+				if (use_graph_cache)
+				{
+					cache = CommitGraphCache.for_walk(d_repository, d_sortmode, d_lanes);
+				}
+
+				if (cache != null)
+				{
+					cached_walk = cache.read_walk();
+
+					// A cached walk of other tips can only be brought up to date
+					// when it is complete
+					if (cached_walk != null &&
+					    (!same_ids(cached_walk.exclude, excluded) ||
+					     (limit != 0 && (!same_ids(cached_walk.include, included) ||
+					                     !same_ids(cached_walk.permanent, permlanes)))))
+					{
+						cached_walk = null;
+					}
+				}
+
+				if (cached_walk != null)
+				{
+					span = Trace.begin();
+
+					var loaded = cache.load((oid, lanes, lane) => {
+						// Rows are restored without looking up any commit,
+						// they are only looked up when shown
+						var row = CommitRow() {
+							id = oid,
+							store = d_lanes.store,
+							nlanes = lanes.length(),
+							mylane = (uint)lane
+						};
+
+						d_lanes.store.append(lanes, out row.chunk, out row.first);
+						append_row(row);
+
+						if (timer.elapsed() >= wait_elapsed)
+						{
+							notify_batch(null);
+							timer.start();
+
+							wait_elapsed = wait_elapsed_incremental;
+						}
+
+						return limit == 0 || d_rows.length < limit;
+					}, cancellable);
+
+					Trace.end_detail(span, "CommitModel.load_graph_cache", "%u rows", d_rows.length);
+
+					if (cancellable.is_cancelled())
+					{
+						return null;
+					}
+
+					if (loaded || (limit > 0 && d_rows.length == limit))
+					{
+						cached = true;
+						complete = loaded;
+
+						notify_batch((owned)cb);
+						return null;
+					}
+
+					if (d_rows.length != 0)
+					{
+						// The cache turned out to be unusable halfway, drop it
+						// and start over with a normal walk
+						cache.invalidate();
+
+						Idle.add(() => {
+							reload();
+							return false;
+						});
+
+						return null;
+					}
+				}
+
+				// The commits are looked up ahead of the layout on the threads
+				// of the decoder, the layout itself needs them in walk order
+				var decoder = new CommitDecoder(d_repository);
+				var walked = false;
+				var failed = false;
+
+				span = Trace.begin();
+
+				while (true)
+				{
+					Ggit.OId? id;
+					Commit? commit;
+
+					if (cancellable.is_cancelled())
+					{
+						decoder.close();
+						return null;
+					}
+
+					while (!walked && decoder.queued < DECODE_AHEAD)
+					{
+						try
+						{
+							id = d_walker.next();
+						}
+						catch
+						{
+							id = null;
+							failed = true;
+						}
+
+						if (id == null)
+						{
+							walked = true;
+							break;
+						}
+
+						decoder.push(id);
+					}
+
+					if (!decoder.pop(out id, out commit))
+					{
+						complete = !failed;
+						break;
+					}
+
+					if (commit == null)
+					{
+						break;
+					}
+
+					take_checkpoint(checkpoints, id, position, prefix);
+
+					prefix = walk_hash_next(prefix, id);
+					++position;
+
+					Trace.rate("commits/s");
+
+					layout_commit(commit, (c) => {
+						if (search_index != null)
+						{
+							search_index.add(d_rows.length, c);
+						}
+
+						append_commit(c);
+					});
+
+					release_commits();
+
+					if (timer.elapsed() >= wait_elapsed)
+					{
+						notify_batch(null);
+						timer.start();
+
+						wait_elapsed = wait_elapsed_incremental;
+					}
+
+					if (limit > 0 && d_rows.length == limit)
+					{
+						complete = false;
+						break;
+					}
+				}
+
+				decoder.close();
+
+				d_lanes.finish();
+				release_commits(true);
+
+				Trace.end_detail(span, "CommitModel.layout", "%u commits", position);
+
+				if (complete &&
+				    cache != null &&
+				    CommitGraphCache.should_save(d_rows.length))
+				{
+					// Show everything before spending time on writing the cache
+					notify_batch(null);
+
+					save_graph_cache(cache,
+					                 cache_walk(checkpoints, position, prefix, included, excluded, permlanes),
+					                 d_rows,
+					                 cancellable);
+				}
+
+				notify_batch((owned)cb);
+				return null;
+			};
+
+			try
+			{
+				d_thread = new Thread<void*>.try("gitg-history-walk", (owned)run);
+			}
+			catch
+			{
+				d_thread = null;
+				return false;
+			}
+
+			yield;
+
+			Trace.end_detail(walk_span, "CommitModel.walk", "%u rows", d_rows.length);
+
+			if (cached && search_index != null && !cancellable.is_cancelled())
+			{
+				// No commits were looked up for the cached rows
+				d_search_index_cancellable = new Cancellable();
+				index_rows.begin(search_index, d_rows, d_search_index_cancellable);
+			}
+
+			if (cancellable.is_cancelled())
+			{
+				return false;
+			}
+
+			if (cached)
+			{
+				// The rows are those of the cached walk, which may have been
+				// of other tips
+				store_walk_state(complete ? cached_checkpoints(cached_walk) : null,
+				                 cached_walk.length,
+				                 cached_walk.prefix,
+				                 cached_walk.include,
+				                 cached_walk.exclude,
+				                 cached_walk.permanent);
+
+				return complete &&
+				       (!same_ids(cached_walk.include, included) ||
+				        !same_ids(cached_walk.permanent, permlanes));
+			}
+
+			store_walk_state(complete ? checkpoints : null,
+			                 position,
+			                 prefix,
+			                 included,
+			                 excluded,
+			                 permlanes);
+
+			return false;
+		}
+
+		/* Indexes the rows for searching, looking up their commits. */
+		private async void index_rows(CommitSearchIndex index, RowStore rows, Cancellable cancellable)
+		{
+			// Only called once the walk is done, so the rows do not change
+			// anymore
+			yield Async.thread_try(() => {
+				var n = rows.length;
+
+				for (uint i = 0; i < n && !cancellable.is_cancelled(); i++)
+				{
+					try
+					{
+						index.add(i, d_repository.lookup<Commit>(rows[i].id));
+					} catch {}
+				}
+			});
+
+			if (d_search_index_cancellable == cancellable)
+			{
+				d_search_index_cancellable = null;
+			}
 		}
 
-		public new Commit? @get(uint idx)
+		private CommitSearchIndex? index_new_rows(bool indexed, Commit[] commits, uint num)
 		{
-			Commit? ret;
-
-			if (idx >= d_advertized_size)
+			if (!indexed)
 			{
 				return null;
 			}
 
-			lock(d_ids)
+			var ret = new CommitSearchIndex(d_repository);
+
+			for (uint i = 0; i < num; i++)
 			{
-				ret = d_ids[idx];
+				ret.add(i, commits[i]);
 			}
 
 			return ret;
 		}
 
-		public void set_include(Ggit.OId[] ids)
+		private void splice_search_index(WalkSplice splice, uint old_size)
 		{
-			this.d_include = ids;
-		}
+			if (d_search_index_cancellable != null)
+			{
+				// The rows were still being indexed in the background, start
+				// over on the new rows since they have shifted
+				d_search_index_cancellable.cancel();
 
-		public Ggit.OId[] get_include()
-		{
-			return this.d_include;
+				d_search_index = new CommitSearchIndex(d_repository);
+				d_search_index_cancellable = new Cancellable();
+
+				index_rows.begin(d_search_index, d_rows, d_search_index_cancellable);
+			}
+			else if (splice.search_index != null)
+			{
+				d_search_index.splice(splice.replaced,
+				                      splice.inserted,
+				                      old_size,
+				                      splice.search_index);
+			}
 		}
 
-		public void set_exclude(Ggit.OId[] ids)
+		private class WalkSplice
 		{
-			this.d_exclude = ids;
+			// The new rows, replacing the first @replaced rows of the model
+			// with the first @inserted rows of @ids
+			public RowStore rows;
+			public OIdTable id_hash;
+			public uint replaced;
+			public uint inserted;
+
+			public Gee.HashMap<Ggit.OId, WalkCheckpoint> checkpoints;
+			public uint length;
+			public uint64 prefix;
+
+			// Search index of the inserted rows
+			public CommitSearchIndex? search_index;
 		}
 
-		private void notify_batch(owned SourceFunc? finishedcb)
+		/* Finds where the rows of the walk in progress line up with the
+		 * previous rows, given that the lanes state of both walks is identical
+		 * at this point. Rows laid out since the oldest commit the lanes still
+		 * track may get modified later on (collapsed, expanded), so the splice
+		 * happens at that commit and the previous rows, which already have
+		 * these modifications, are used from there on.
+		 */
+		private bool find_splice(Commit[]   ids,
+		                         OIdTable   id_hash,
+		                         OIdTable   old_hash,
+		                         out uint   splice_new,
+		                         out uint   splice_old)
 		{
-			lock(d_idleid)
-			{
-				if (d_idleid != 0)
-				{
-					Source.remove(d_idleid);
-					d_idleid = 0;
-				}
-
-				uint newsize = d_ids.length;
-
-				d_idleid = Idle.add(() => {
-					lock(d_idleid)
-					{
-						if (d_idleid == 0)
-						{
-							return false;
-						}
-
-						d_idleid = 0;
-
-						uint added = newsize - d_advertized_size;
-						d_advertized_size = newsize;
+			splice_new = 0;
+			splice_old = 0;
 
-						emit_update(added);
+			Ggit.OId? oldest = null;
 
-						if (finishedcb != null)
-						{
-							finishedcb();
-						}
-					}
+			foreach (unowned Commit commit in d_lanes.get_previous())
+			{
+				var id = commit.get_id();
 
-					return false;
-				});
+				if (id_hash.contains(id))
+				{
+					oldest = id;
+				}
 			}
-		}
 
-		private bool needs_resize(Gitg.Commit[] ids, ref uint size)
-		{
-			if (ids.length < size)
+			if (oldest == null || !old_hash.lookup(oldest, out splice_old))
 			{
 				return false;
 			}
 
-			if (ids.length < 20000)
+			id_hash.lookup(oldest, out splice_new);
+
+			uint n = (uint)ids.length - splice_new;
+
+			if (splice_old + n > d_rows.length)
 			{
-				size *= 2;
+				return false;
 			}
-			else
+
+			for (uint i = 0; i < n; i++)
 			{
-				size = (uint)((double)size * 1.2);
+				if (!ids[splice_new + i].get_id().equal(d_rows[splice_old + i].id))
+				{
+					return false;
+				}
 			}
 
 			return true;
 		}
 
-		private async void walk(Cancellable cancellable)
+		/* Lays out the commits which changed since the previous walk, and
+		 * splices them into the rows. With @cached, the previous walk is the
+		 * one restored from the graph cache, which is then brought up to date
+		 * as well.
+		 */
+		private async void walk_incremental(Cancellable cancellable, bool cached = false)
 		{
 			Ggit.OId[] included = d_include;
 			Ggit.OId[] excluded = d_exclude;
 
-			uint limit = this.limit;
+			var permlanes = get_permanent_lanes();
 
-			SourceFunc cb = walk.callback;
+			var old_hash = d_id_hash;
+			var old_checkpoints = d_checkpoints;
+			var old_length = d_walk_length;
+			var old_prefix = d_walk_prefix;
 
-			// First time, wait a bit longer to make loading small repositories
-			// subjectively quicker
-			var wait_elapsed_initial = 1.0;
+			// Commits which are treated as roots in only one of the walks. These
+			// are laid out differently, so they must not be part of the rows
+			// that are reused.
+			var tipdiff = new Gee.HashSet<Ggit.OId>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+			                                        (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
 
-			// After initial wait elapsed, continue with incremental updates at
-			// a quicker pace
-			var wait_elapsed_incremental = 0.2;
+			add_symmetric_difference(tipdiff, d_walk_include, included);
+			add_symmetric_difference(tipdiff, d_walk_permanent, permlanes);
 
-			var wait_elapsed = wait_elapsed_initial;
+			SourceFunc cb = walk_incremental.callback;
+			WalkSplice? splice = null;
 
-			var permlanes = get_permanent_lanes();
+			var indexed = d_search_index != null;
+
+			CommitGraphCache? cache = null;
+
+			if (cached)
+			{
+				cache = CommitGraphCache.for_walk(d_repository, d_sortmode, d_lanes);
+			}
+
+			d_walk_incremental = true;
 
 			ThreadFunc<void*> run = () => {
-				if (d_walker == null)
+				if (!setup_walker(included, excluded, permlanes))
 				{
-					try
-					{
-						d_walker = new Ggit.RevisionWalker(d_repository);
-					}
-					catch
-					{
-						notify_batch((owned)cb);
-						return null;
-					}
+					Idle.add((owned)cb);
+					return null;
 				}
 
-				d_walker.reset();
-				d_walker.set_sort_mode(d_sortmode);
+				var ids = new Commit[0];
+				var id_hash = new OIdTable();
+				var checkpoints = new_checkpoints();
+
+				uint position = 0;
+				uint64 prefix = 0;
+				uint splice_new = 0;
+				uint splice_old = 0;
 
-				var incset = new Gee.HashSet<Ggit.OId>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
-				                                       (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+				WalkCheckpoint? converged = null;
+				Ggit.OId? id = null;
 
-				foreach (Ggit.OId oid in included)
+				while (true)
 				{
-					try
+					if (cancellable.is_cancelled())
 					{
-						d_walker.push(oid);
-						incset.add(oid);
-					} catch {};
-				}
+						return null;
+					}
 
-				foreach (Ggit.OId oid in excluded)
-				{
 					try
 					{
-						d_walker.hide(oid);
-						incset.remove(oid);
-					} catch {};
-				}
+						id = d_walker.next();
+					} catch { id = null; }
+
+					if (id == null)
+					{
+						break;
+					}
 
-				var permanent = new Ggit.OId[0];
+					string? digest = null;
+					var checkpoint = old_checkpoints.get(id);
 
-				foreach (Ggit.OId oid in permlanes)
-				{
-					try
+					if (checkpoint != null)
 					{
-						d_walker.push(oid);
-						permanent += oid;
-					} catch {}
-				}
+						digest = d_lanes.state_digest();
+
+						if (digest == checkpoint.digest &&
+						    find_splice(ids, id_hash, old_hash, out splice_new, out splice_old))
+						{
+							converged = checkpoint;
+							break;
+						}
+					}
 
-				d_lanes.reset(permanent, incset);
+					take_checkpoint(checkpoints, id, position, prefix, digest);
 
-				uint size;
-				uint hidden_size;
+					prefix = walk_hash_next(prefix, id);
+					++position;
 
-				// Pre-allocate array to store commits
-				lock(d_ids)
-				{
-					d_ids = new Commit[1000];
-					d_hidden_ids = new Commit[100];
+					Trace.rate("commits/s");
 
-					size = d_ids.length;
-					hidden_size = d_hidden_ids.length;
+					Commit commit;
 
-					d_ids.length = 0;
-					d_hidden_ids.length = 0;
+					try
+					{
+						commit = d_repository.lookup<Commit>(id);
+					}
+					catch
+					{
+						Idle.add((owned)cb);
+						return null;
+					}
 
-					d_advertized_size = 0;
+					layout_commit(commit, (c) => {
+						id_hash.set(c.get_id(), (uint)ids.length);
+						ids += c;
+					});
 				}
 
-				Timer timer = new Timer();
+				d_lanes.finish();
 
-				lock(d_id_hash)
+				if (converged == null)
 				{
-					d_id_hash = new Gee.HashMap<Ggit.OId, int>((i) => { return i.hash(); }, (a, b) => { return a.equal(b); });
+					// Walked everything without converging, replace all rows
+					splice = new WalkSplice();
+
+					splice.rows = new RowStore();
+
+					for (var i = 0; i < ids.length; i++)
+					{
+						splice.rows.append(released_row(ids[i]));
+					}
+
+					splice.id_hash = id_hash;
+					splice.replaced = d_rows.length;
+					splice.inserted = splice.rows.length;
+					splice.checkpoints = checkpoints;
+					splice.length = position;
+					splice.prefix = prefix;
+					splice.search_index = index_new_rows(indexed, ids, ids.length);
+
+					save_splice(cache, splice, included, excluded, permlanes, cancellable);
+
+					Idle.add((owned)cb);
+					return null;
 				}
 
-				while (true)
+				// The lanes converged, which means the remaining commits are laid
+				// out exactly as before provided that the walk continues with
+				// the same commits as the previous one did. Checking that still
+				// reads all the remaining ids from the walker, but without
+				// looking up or laying out their commits. With the default
+				// topological sorting, the walker has already gone through the
+				// whole history before returning the first id anyway, so this
+				// only adds a pass over ids in memory.
+				uint64 rest = 0;
+				uint count = 0;
+
+				while (id != null)
 				{
-					Ggit.OId? id;
-					Commit? commit;
-
 					if (cancellable.is_cancelled())
 					{
 						return null;
 					}
 
+					if (tipdiff.contains(id))
+					{
+						Idle.add((owned)cb);
+						return null;
+					}
+
+					rest = walk_hash_next(rest, id);
+					++count;
+
 					try
 					{
 						id = d_walker.next();
+					} catch { id = null; }
+				}
 
-						if (id == null)
-						{
-							break;
-						}
+				var expected_count = old_length - converged.position;
+				var expected = old_prefix - converged.prefix * walk_hash_pow(expected_count);
 
-						commit = d_repository.lookup<Commit>(id);
-					} catch { break; }
+				if (count != expected_count || rest != expected)
+				{
+					Idle.add((owned)cb);
+					return null;
+				}
 
-					int mylane;
-					SList<Lane> lanes;
+				uint nold = d_rows.length - splice_old;
+				var rows = new RowStore();
 
-					bool finded = d_lanes.next(commit, out lanes, out mylane, true);
-					if (finded)
-					{
-						debug ("finded parent for %s %s\n", commit.get_subject(), commit.get_id().to_string());
-						commit.update_lanes((owned)lanes, mylane);
+				for (uint i = 0; i < splice_new; i++)
+				{
+					rows.append(released_row(ids[i]));
+				}
 
-						lock(d_id_hash)
-						{
-							d_id_hash.set(id, d_ids.length);
-						}
+				// The previous rows have all been released, they can be read
+				// without locking
+				for (uint i = 0; i < nold; i++)
+				{
+					var row = d_rows[splice_old + i];
 
-						if (needs_resize(d_ids, ref size))
-						{
-							var l = d_ids.length;
+					rows.append(row);
+					id_hash.set(row.id, splice_new + i);
+				}
 
-							lock(d_ids)
-							{
-								d_ids.resize((int)size);
-								d_ids.length = l;
-							}
-						}
+				// Carry over the checkpoints of the reused part of the walk
+				foreach (var entry in old_checkpoints.entries)
+				{
+					var cp = entry.value;
 
-						d_ids[d_ids.length++] = commit;
-					}
-					while (d_lanes.miss_commits.size > 0)
+					if (cp.position < converged.position)
 					{
-						finded = false;
-						var iter = d_lanes.miss_commits.iterator();
-						while (iter.next())
-						{
-							var miss_commit = iter.get();
-							debug ("trying again %s %s", miss_commit.get_subject(), miss_commit.get_id().to_string());
-							bool tmp_finded = d_lanes.next(miss_commit, out lanes, out mylane);
-							if (tmp_finded)
-							{
-								finded = true;
-								debug ("finded parent for miss %s %s\n", miss_commit.get_subject(), miss_commit.get_id().to_string());
-								iter.remove();
-								commit = miss_commit;
-
-								commit.update_lanes((owned)lanes, mylane);
-
-								lock(d_id_hash)
-								{
-									d_id_hash.set(id, d_ids.length);
-								}
-
-								if (needs_resize(d_ids, ref size))
-								{
-									var l = d_ids.length;
-
-									lock(d_ids)
-									{
-										d_ids.resize((int)size);
-										d_ids.length = l;
-									}
-								}
-
-								d_ids[d_ids.length++] = commit;
-							}
-						}
-						if (!finded)
-							break;
+						continue;
 					}
 
-					if (!finded)
-					{
-						if (needs_resize(d_hidden_ids, ref hidden_size))
-						{
-							var l = d_hidden_ids.length;
-
-							d_hidden_ids.resize((int)hidden_size);
-							d_hidden_ids.length = l;
-						}
+					var delta = cp.position - converged.position;
+					var p = walk_hash_pow(delta);
 
-						d_hidden_ids[d_hidden_ids.length++] = commit;
-					}
+					checkpoints.set(entry.key,
+					                new WalkCheckpoint(cp.digest,
+					                                   position + delta,
+					                                   prefix * p + (cp.prefix - converged.prefix * p)));
+				}
 
-					if (timer.elapsed() >= wait_elapsed)
-					{
-						notify_batch(null);
-						timer.start();
+				splice = new WalkSplice();
 
-						wait_elapsed = wait_elapsed_incremental;
-					}
+				splice.rows = rows;
+				splice.id_hash = id_hash;
+				splice.replaced = splice_old;
+				splice.inserted = splice_new;
+				splice.checkpoints = checkpoints;
+				splice.length = position + expected_count;
+				splice.prefix = prefix * walk_hash_pow(expected_count) + rest;
+				splice.search_index = index_new_rows(indexed, ids, splice_new);
 
-					if (limit > 0 && d_ids.length == limit)
-					{
-						break;
-					}
-				}
+				save_splice(cache, splice, included, excluded, permlanes, cancellable);
 
-				notify_batch((owned)cb);
+				Idle.add((owned)cb);
 				return null;
 			};
 
@@ -521,10 +1810,145 @@ namespace Gitg
 			catch
 			{
 				d_thread = null;
+				d_cancellable = null;
+
+				reload_uncached(cache);
 				return;
 			}
 
 			yield;
+
+			if (cancellable.is_cancelled())
+			{
+				return;
+			}
+
+			d_thread.join();
+			d_thread = null;
+			d_cancellable = null;
+
+			if (splice == null)
+			{
+				reload_uncached(cache);
+				return;
+			}
+
+			if (splice.replaced > SPLICE_RESET_THRESHOLD)
+			{
+				clear();
+			}
+
+			var old_size = d_rows.length;
+
+			lock(d_rows)
+			{
+				d_rows = splice.rows;
+				AtomicUint.set(ref d_released, d_rows.length);
+			}
+
+			d_commit_cache.clear();
+
+			lock(d_id_hash)
+			{
+				d_id_hash = splice.id_hash;
+			}
+
+			d_advertized_size = d_rows.length;
+
+			if (d_search_index != null)
+			{
+				splice_search_index(splice, old_size);
+			}
+
+			store_walk_state(splice.checkpoints,
+			                 splice.length,
+			                 splice.prefix,
+			                 included,
+			                 excluded,
+			                 permlanes);
+
+			if (d_size == 0)
+			{
+				emit_update(d_advertized_size);
+			}
+			else
+			{
+				emit_splice(splice.replaced, splice.inserted);
+			}
+
+			finished();
+		}
+
+		/* Writes the rows of @splice to @cache, before they are shown. It
+		 * only happens when bringing a cached walk up to date on load, where
+		 * the cached rows are shown in the meantime.
+		 */
+		private void save_splice(CommitGraphCache? cache,
+		                         WalkSplice        splice,
+		                         Ggit.OId[]        included,
+		                         Ggit.OId[]        excluded,
+		                         Ggit.OId[]        permanent,
+		                         Cancellable       cancellable)
+		{
+			if (cache == null || !CommitGraphCache.should_save(splice.rows.length))
+			{
+				return;
+			}
+
+			save_graph_cache(cache,
+			                 cache_walk(splice.checkpoints, splice.length, splice.prefix, included, excluded, permanent),
+			                 splice.rows,
+			                 cancellable);
+		}
+
+		private void reload_uncached(CommitGraphCache? cache)
+		{
+			if (cache != null)
+			{
+				// The cached walk cannot be brought up to date, do not restore
+				// it again
+				cache.invalidate();
+			}
+
+			reload();
+		}
+
+		private void emit_splice(uint replaced, uint inserted)
+		{
+			var diff = (int)inserted - (int)replaced;
+			var path = new Gtk.TreePath.first();
+
+			Gtk.TreeIter iter = Gtk.TreeIter();
+			iter.stamp = d_stamp;
+
+			if (diff < 0)
+			{
+				for (var i = 0; i < -diff; i++)
+				{
+					--d_size;
+					row_deleted(path.copy());
+				}
+			}
+
+			for (var i = 0; i < diff; i++)
+			{
+				iter.user_data = (void *)(ulong)i;
+
+				++d_size;
+
+				row_inserted(path.copy(), iter);
+				path.next();
+			}
+
+			for (uint i = (uint)int.max(diff, 0); i < inserted; i++)
+			{
+				iter.user_data = (void *)(ulong)i;
+
+				row_changed(path.copy(), iter);
+				path.next();
+			}
+
+			update((uint)int.max(diff, 0));
 		}
 
 		private void clear()
@@ -688,14 +2112,14 @@ namespace Gitg
 		{
 			lock(d_id_hash)
 			{
-				var id = commit.get_id();
+				uint idx;
 
-				if (!d_id_hash.has_key(id))
+				if (!d_id_hash.lookup(commit.get_id(), out idx))
 				{
 					return null;
 				}
 
-				return new Gtk.TreePath.from_indices(d_id_hash.get(commit.get_id()));
+				return new Gtk.TreePath.from_indices((int)idx);
 			}
 		}
 
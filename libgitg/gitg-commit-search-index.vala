@@ -0,0 +1,575 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Search index over the rows of a CommitModel. The subject, message,
+ * author and committer of each commit are indexed by trigrams and the ids
+ * by their first two bytes. Searching looks up the candidate rows in the
+ * index and then verifies each candidate, in a thread.
+ */
+public class CommitSearchIndex : Object
+{
+	// Keys of the id buckets, trigrams only use the lower 24 bits
+	private const uint ID_KEY = 1 << 24;
+
+	private const int RAW_ID_SIZE = 20;
+
+	/* Delta and varint encoded list of increasing numbers */
+	private class Postings
+	{
+		private uint8[] d_data;
+		private uint d_size;
+		private uint d_last;
+
+		public uint count;
+
+		public Postings()
+		{
+			d_data = new uint8[8];
+		}
+
+		public void add(uint n)
+		{
+			if (count != 0 && n == d_last)
+			{
+				return;
+			}
+
+			uint delta = count == 0 ? n : n - d_last;
+
+			if (d_size + 5 > d_data.length)
+			{
+				d_data.resize(d_data.length * 2);
+			}
+
+			while (delta >= 0x80)
+			{
+				d_data[d_size++] = (uint8)(delta | 0x80);
+				delta >>= 7;
+			}
+
+			d_data[d_size++] = (uint8)delta;
+
+			d_last = n;
+			count++;
+		}
+
+		public uint[] decode()
+		{
+			var ret = new uint[count];
+
+			uint pos = 0;
+			uint n = 0;
+
+			for (uint i = 0; i < count; i++)
+			{
+				uint delta = 0;
+				uint shift = 0;
+				uint8 b;
+
+				do
+				{
+					b = d_data[pos++];
+					delta |= (uint)(b & 0x7f) << shift;
+					shift += 7;
+				} while ((b & 0x80) != 0);
+
+				n = i == 0 ? delta : n + delta;
+				ret[i] = n;
+			}
+
+			return ret;
+		}
+	}
+
+	/* The index of a range of rows. Entries are numbered in the order in
+	 * which they were added, the row of an entry is its number plus
+	 * @offset. Only rows from @min_row up to @max_row are still valid,
+	 * the others have been replaced by an incremental reload.
+	 */
+	private class Segment
+	{
+		public HashTable<uint, Postings> postings;
+		public uint8[] ids;
+		public uint size;
+
+		public int offset;
+		public uint min_row;
+		public uint max_row;
+
+		public Segment()
+		{
+			postings = new HashTable<uint, Postings>(direct_hash, direct_equal);
+			ids = new uint8[RAW_ID_SIZE * 64];
+			max_row = uint.MAX;
+		}
+
+		public void add(uint[] keys, uint8[] id)
+		{
+			var n = size++;
+
+			if (size * RAW_ID_SIZE > ids.length)
+			{
+				ids.resize(ids.length * 2);
+			}
+
+			Memory.copy(&ids[n * RAW_ID_SIZE], id, RAW_ID_SIZE);
+
+			foreach (var key in keys)
+			{
+				var p = postings.lookup(key);
+
+				if (p == null)
+				{
+					p = new Postings();
+					postings.insert(key, p);
+				}
+
+				p.add(n);
+			}
+		}
+
+		public bool id_has_prefix(uint n, string prefix)
+		{
+			unowned uint8[] hex = "0123456789abcdef".data;
+
+			for (var i = 0; i < prefix.length; i++)
+			{
+				var b = ids[n * RAW_ID_SIZE + i / 2];
+				var c = hex[(i % 2) == 0 ? (b >> 4) : (b & 0xf)];
+
+				if ((char)c != prefix[i])
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		public string id_to_string(uint n)
+		{
+			var s = new StringBuilder.sized(RAW_ID_SIZE * 2);
+
+			for (var i = 0; i < RAW_ID_SIZE; i++)
+			{
+				s.append_printf("%02x", ids[n * RAW_ID_SIZE + i]);
+			}
+
+			return s.str;
+		}
+
+		/* Gets the entries which have all @keys, in increasing order.
+		 * Returns null when there are no keys.
+		 */
+		public uint[]? lookup(uint[] keys)
+		{
+			if (keys.length == 0)
+			{
+				return null;
+			}
+
+			uint[]? ret = null;
+
+			foreach (var key in keys)
+			{
+				var p = postings.lookup(key);
+
+				if (p == null)
+				{
+					return new uint[0];
+				}
+
+				ret = ret == null ? p.decode() : intersect(ret, p.decode());
+
+				if (ret.length == 0)
+				{
+					break;
+				}
+			}
+
+			return ret;
+		}
+
+		private static uint[] intersect(uint[] a, uint[] b)
+		{
+			var ret = new uint[uint.min(a.length, b.length)];
+			ret.length = 0;
+
+			int i = 0;
+			int j = 0;
+
+			while (i < a.length && j < b.length)
+			{
+				if (a[i] < b[j])
+				{
+					i++;
+				}
+				else if (a[i] > b[j])
+				{
+					j++;
+				}
+				else
+				{
+					ret += a[i];
+
+					i++;
+					j++;
+				}
+			}
+
+			return ret;
+		}
+
+		public bool row_for(uint n, out uint row)
+		{
+			var r = (int64)n + offset;
+
+			row = (uint)r;
+			return r >= min_row && r < max_row;
+		}
+	}
+
+	private class Candidate
+	{
+		public uint row;
+		public string id;
+		public bool matched;
+
+		public Candidate(uint row, string id, bool matched)
+		{
+			this.row = row;
+			this.id = id;
+			this.matched = matched;
+		}
+	}
+
+	private Repository d_repository;
+	private Gee.ArrayList<Segment> d_segments;
+	private Segment? d_current;
+	private uint d_next_row;
+
+	public CommitSearchIndex(Repository repository)
+	{
+		d_repository = repository;
+		d_segments = new Gee.ArrayList<Segment>();
+
+		d_current = new Segment();
+		d_segments.add(d_current);
+	}
+
+	public static string normalize(string s)
+	{
+		return s.normalize(-1, NormalizeMode.ALL).casefold();
+	}
+
+	private static void add_trigrams(Gee.HashSet<uint> keys, string s)
+	{
+		unowned uint8[] data = s.data;
+
+		for (var i = 0; i + 2 < data.length; i++)
+		{
+			keys.add(((uint)data[i] << 16) | ((uint)data[i + 1] << 8) | data[i + 2]);
+		}
+	}
+
+	private static uint[] to_keys(Gee.HashSet<uint> set)
+	{
+		var ret = new uint[set.size];
+		var i = 0;
+
+		foreach (var key in set)
+		{
+			ret[i++] = key;
+		}
+
+		return ret;
+	}
+
+	private static uint8[] raw_id(Ggit.OId id)
+	{
+		var ret = new uint8[OIdTable.RAW_SIZE];
+
+		OIdTable.get_raw(id, ret);
+		return ret;
+	}
+
+	/* Adds @commit, shown at @row. Rows have to be added in order. */
+	public void add(uint row, Commit commit)
+	{
+		var keys = new Gee.HashSet<uint>();
+
+		// The whole message is indexed, the index rules out rows which do
+		// not match, so no part of the message may be left out
+		add_trigrams(keys, normalize(commit.get_subject()));
+		add_trigrams(keys, normalize(commit.get_message()));
+
+		var author = commit.get_author();
+		add_trigrams(keys, author.get_name().down());
+		add_trigrams(keys, author.get_email().down());
+
+		var committer = commit.get_committer();
+		add_trigrams(keys, committer.get_name().down());
+		add_trigrams(keys, committer.get_email().down());
+
+		var id = raw_id(commit.get_id());
+		keys.add(ID_KEY | ((uint)id[0] << 8) | id[1]);
+
+		var k = to_keys(keys);
+
+		lock(d_segments)
+		{
+			if (d_current == null || row < d_next_row)
+			{
+				return;
+			}
+
+			if (d_current.size == 0)
+			{
+				d_current.offset = (int)row;
+			}
+			else if (row != d_next_row)
+			{
+				// Rows were skipped, continue in a new segment so that
+				// entries keep mapping to rows by a fixed offset
+				d_current = new Segment();
+				d_current.offset = (int)row;
+
+				d_segments.add(d_current);
+			}
+
+			d_current.add(k, id);
+			d_next_row = row + 1;
+		}
+	}
+
+	/* Updates the index after the first @replaced of the @size rows of the
+	 * model were replaced by @inserted new rows, which have been indexed in
+	 * @head.
+	 */
+	public void splice(uint replaced, uint inserted, uint size, CommitSearchIndex head)
+	{
+		var delta = (int64)inserted - (int64)replaced;
+		var segments = new Gee.ArrayList<Segment>();
+
+		lock(d_segments)
+		{
+			foreach (var segment in d_segments)
+			{
+				var min_row = (int64)segment.min_row + delta;
+				var max_row = (int64)uint.min(segment.max_row, size) + delta;
+
+				segment.offset += (int)delta;
+				segment.min_row = min_row > inserted ? (uint)min_row : inserted;
+				segment.max_row = max_row > 0 ? (uint)max_row : 0;
+
+				if (segment.min_row < segment.max_row)
+				{
+					segments.add(segment);
+				}
+			}
+
+			lock(head.d_segments)
+			{
+				foreach (var segment in head.d_segments)
+				{
+					segment.max_row = uint.min(segment.max_row, inserted);
+					segments.add(segment);
+				}
+			}
+
+			d_segments = segments;
+
+			// No more rows are appended after a splice
+			d_current = null;
+		}
+	}
+
+	private static bool is_hex(string s)
+	{
+		if (s.length == 0 || s.length > RAW_ID_SIZE * 2)
+		{
+			return false;
+		}
+
+		for (var i = 0; i < s.length; i++)
+		{
+			if (!s[i].isxdigit())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/* Whether @commit matches the normalized search key @nkey. */
+	public static bool matches(Commit commit, string nkey)
+	{
+		if (normalize(commit.get_subject()).contains(nkey))
+		{
+			return true;
+		}
+
+		if (normalize(commit.get_message()).contains(nkey))
+		{
+			return true;
+		}
+
+		var author = commit.get_author();
+
+		if (author.get_name().down().contains(nkey) || author.get_email().down().contains(nkey))
+		{
+			return true;
+		}
+
+		var committer = commit.get_committer();
+
+		if (committer.get_name().down().contains(nkey) || committer.get_email().down().contains(nkey))
+		{
+			return true;
+		}
+
+		return false;
+	}
+
+	private Gee.ArrayList<Candidate> candidates(string key)
+	{
+		var ret = new Gee.ArrayList<Candidate>();
+
+		var nkey = normalize(key);
+		string? idkey = is_hex(key) ? key.down() : null;
+
+		var trigrams = new Gee.HashSet<uint>();
+		add_trigrams(trigrams, nkey);
+
+		var text_keys = to_keys(trigrams);
+		uint[] id_keys = {};
+
+		if (idkey != null && idkey.length >= 4)
+		{
+			id_keys += ID_KEY | (uint)((idkey[0].xdigit_value() << 12) |
+			                           (idkey[1].xdigit_value() << 8) |
+			                           (idkey[2].xdigit_value() << 4) |
+			                           idkey[3].xdigit_value());
+		}
+
+		lock(d_segments)
+		{
+			foreach (var segment in d_segments)
+			{
+				var matched = new Gee.HashSet<uint>();
+
+				if (idkey != null)
+				{
+					var id_entries = segment.lookup(id_keys);
+
+					for (uint i = 0; i < (id_entries != null ? id_entries.length : segment.size); i++)
+					{
+						var n = id_entries != null ? id_entries[i] : i;
+						uint row;
+
+						if (segment.row_for(n, out row) && segment.id_has_prefix(n, idkey))
+						{
+							matched.add(n);
+							ret.add(new Candidate(row, segment.id_to_string(n), true));
+						}
+					}
+				}
+
+				var entries = segment.lookup(text_keys);
+
+				for (uint i = 0; i < (entries != null ? entries.length : segment.size); i++)
+				{
+					var n = entries != null ? entries[i] : i;
+					uint row;
+
+					if (!matched.contains(n) && segment.row_for(n, out row))
+					{
+						ret.add(new Candidate(row, segment.id_to_string(n), false));
+					}
+				}
+			}
+		}
+
+		return ret;
+	}
+
+	private uint[] search_sync(string key, Cancellable? cancellable)
+	{
+		var nkey = normalize(key);
+		var rows = new Gee.ArrayList<uint>();
+
+		foreach (var candidate in candidates(key))
+		{
+			if (cancellable != null && cancellable.is_cancelled())
+			{
+				return new uint[0];
+			}
+
+			if (!candidate.matched)
+			{
+				try
+				{
+					var commit = d_repository.lookup<Commit>(new Ggit.OId.from_string(candidate.id));
+					candidate.matched = matches(commit, nkey);
+				} catch {}
+			}
+
+			if (candidate.matched)
+			{
+				rows.add(candidate.row);
+			}
+		}
+
+		rows.sort((a, b) => {
+			return a < b ? -1 : (a > b ? 1 : 0);
+		});
+
+		var ret = new uint[rows.size];
+
+		for (var i = 0; i < rows.size; i++)
+		{
+			ret[i] = rows[i];
+		}
+
+		return ret;
+	}
+
+	/* Searches for the rows of which the commit id starts with @key or of
+	 * which the subject, message, author or committer contain @key. The
+	 * rows are returned in increasing order.
+	 */
+	public async uint[] search(string key, Cancellable? cancellable = null)
+	{
+		uint[] ret = new uint[0];
+
+		yield Async.thread_try(() => {
+			ret = search_sync(key, cancellable);
+		});
+
+		return ret;
+	}
+}
+
+}
+
+// ex:set ts=4 noet
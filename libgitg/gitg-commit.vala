@@ -24,9 +24,22 @@ public class Commit : Ggit.Commit
 {
 	public LaneTag tag { get; set; }
 
+	// Protects the lanes of all commits, which get modified by the walk
+	// while being drawn
+	private static Mutex s_lanes_lock;
+
 	private uint d_mylane;
 	private SList<Lane> d_lanes;
 
+	// Location of the lanes once they have been frozen
+	private LaneStore? d_lane_store;
+	private uint d_lane_chunk;
+	private uint d_lane_first;
+	private uint d_lane_count;
+
+	/* The lanes of the commit while it is being laid out. Returns null
+	 * once the lanes have been frozen, use get_lane_records instead.
+	 */
 	public unowned SList<Lane> get_lanes()
 	{
 		return d_lanes;
@@ -42,20 +55,68 @@ public class Commit : Ggit.Commit
 		}
 	}
 
-	public Lane lane
+	public Lane? lane
 	{
-		get { return d_lanes.nth_data(d_mylane); }
+		owned get
+		{
+			if (d_lane_store == null)
+			{
+				return d_lanes.nth_data(d_mylane);
+			}
+
+			unowned uint16[] from;
+			var buffer = new LaneBuffer();
+			unowned LaneRecord[] records = get_lane_records(buffer, out from);
+
+			if (d_mylane >= records.length)
+			{
+				return null;
+			}
+
+			var color = new Color();
+			color.idx = records[d_mylane].color;
+
+			var ret = new Lane.with_color(color);
+			ret.tag = (LaneTag)records[d_mylane].tag;
+
+			for (uint i = 0; i < records[d_mylane].nfrom; i++)
+			{
+				ret.from.append(from[records[d_mylane].from + i]);
+			}
+
+			return ret;
+		}
+	}
+
+	public uint num_lanes
+	{
+		get
+		{
+			uint ret;
+
+			s_lanes_lock.lock();
+			ret = d_lane_store != null ? d_lane_count : d_lanes.length();
+			s_lanes_lock.unlock();
+
+			return ret;
+		}
 	}
 
 	public unowned SList<Lane> insert_lane(Lane lane, int idx)
 	{
+		s_lanes_lock.lock();
 		d_lanes.insert(lane, idx);
+		s_lanes_lock.unlock();
+
 		return d_lanes;
 	}
 
 	public unowned SList<Lane> remove_lane(Lane lane)
 	{
+		s_lanes_lock.lock();
 		d_lanes.remove(lane);
+		s_lanes_lock.unlock();
+
 		return d_lanes;
 	}
 
@@ -75,7 +136,12 @@ public class Commit : Ggit.Commit
 
 	public void update_lanes(owned SList<Lane> lanes, int mylane)
 	{
+		s_lanes_lock.lock();
+
 		d_lanes = (owned)lanes;
+		d_lane_store = null;
+
+		s_lanes_lock.unlock();
 
 		if (mylane >= 0)
 		{
@@ -85,6 +151,137 @@ public class Commit : Ggit.Commit
 		update_lane_tag();
 	}
 
+	/* Moves the lanes of the commit into @store. This is done once the
+	 * layout of the commit can no longer change, after which the lane
+	 * objects are released.
+	 */
+	public void freeze_lanes(LaneStore store)
+	{
+		if (d_lane_store != null)
+		{
+			return;
+		}
+
+		s_lanes_lock.lock();
+
+		store.append(d_lanes, out d_lane_chunk, out d_lane_first);
+
+		d_lane_count = d_lanes.length();
+		d_lane_store = store;
+		d_lanes = null;
+
+		s_lanes_lock.unlock();
+	}
+
+	public bool lanes_frozen
+	{
+		get { return d_lane_store != null; }
+	}
+
+	/* Gets where the frozen lanes of the commit are stored. Returns false
+	 * if the lanes have not been frozen yet.
+	 */
+	public bool get_frozen_lanes(out LaneStore? store,
+	                             out uint       chunk,
+	                             out uint       first,
+	                             out uint       count)
+	{
+		store = d_lane_store;
+		chunk = d_lane_chunk;
+		first = d_lane_first;
+		count = d_lane_count;
+
+		return store != null;
+	}
+
+	/* Restores lanes previously frozen into @store, for instance on a
+	 * commit looked up again for a row of the commit model.
+	 */
+	public void set_frozen_lanes(LaneStore store,
+	                             uint      chunk,
+	                             uint      first,
+	                             uint      count,
+	                             uint      mylane)
+	{
+		s_lanes_lock.lock();
+
+		d_lanes = null;
+		d_lane_store = store;
+		d_lane_chunk = chunk;
+		d_lane_first = first;
+		d_lane_count = count;
+
+		s_lanes_lock.unlock();
+
+		d_mylane = mylane;
+	}
+
+	/* Gets the lanes of the commit as packed records, the merge indices of
+	 * the records refer into @from. Frozen lanes are returned in place,
+	 * other lanes are packed into @buffer.
+	 */
+	public unowned LaneRecord[] get_lane_records(LaneBuffer          buffer,
+	                                             out unowned uint16[] from)
+	{
+		s_lanes_lock.lock();
+
+		if (d_lane_store != null)
+		{
+			unowned LaneRecord[] ret = d_lane_store.get_lanes(d_lane_chunk,
+			                                                  d_lane_first,
+			                                                  d_lane_count,
+			                                                  out from);
+
+			s_lanes_lock.unlock();
+			return ret;
+		}
+
+		uint nlanes = 0;
+		uint nfrom = 0;
+
+		foreach (unowned Lane lane in d_lanes)
+		{
+			nlanes++;
+			nfrom += lane.from.length();
+		}
+
+		if (buffer.lanes.length < nlanes)
+		{
+			buffer.lanes = new LaneRecord[nlanes];
+		}
+
+		if (buffer.from.length < nfrom)
+		{
+			buffer.from = new uint16[nfrom];
+		}
+
+		uint i = 0;
+		uint f = 0;
+
+		foreach (unowned Lane lane in d_lanes)
+		{
+			var rec = LaneRecord() {
+				color = (uint8)lane.color.idx,
+				tag = (uint8)lane.tag,
+				nfrom = 0,
+				from = f
+			};
+
+			foreach (var idx in lane.from)
+			{
+				buffer.from[f++] = (uint16)idx;
+				rec.nfrom++;
+			}
+
+			buffer.lanes[i++] = rec;
+		}
+
+		s_lanes_lock.unlock();
+
+		from = buffer.from;
+		return buffer.lanes[0:nlanes];
+	}
+
 	public string format_patch_name
 	{
 		owned get
@@ -112,6 +309,30 @@ public class Commit : Ggit.Commit
 	}
 
 	public Ggit.Diff get_diff(Ggit.DiffOptions? options, int parent)
+	{
+		return diff_with_parent(options, parent, null);
+	}
+
+	/**
+	 * Get the diff of the commit on the diff thread.
+	 *
+	 * @param options the diff options.
+	 * @param parent the index of the parent to get the diff with.
+	 * @param cancellable a cancellable, renames are not detected once it is
+	 *                    cancelled.
+	 *
+	 * @return the diff, or null if cancelled.
+	 */
+	public async Ggit.Diff? get_diff_async(Ggit.DiffOptions? options,
+	                                       int               parent,
+	                                       Cancellable?      cancellable = null) throws Error
+	{
+		return yield DiffWorker.get_default().run((c) => {
+			return diff_with_parent(options, parent, c);
+		}, cancellable);
+	}
+
+	private Ggit.Diff? diff_with_parent(Ggit.DiffOptions? options, int parent, Cancellable? cancellable)
 	{
 		Ggit.Diff? diff = null;
 
@@ -147,7 +368,9 @@ public class Commit : Ggit.Commit
 			stderr.printf("Error when getting diff: %s\n", e.message);
 		}
 
-		if (diff != null)
+		// Rename detection is the expensive part of large diffs, skip it if
+		// the diff is not wanted anymore
+		if (diff != null && (cancellable == null || !cancellable.is_cancelled()))
 		{
 			try
 			{
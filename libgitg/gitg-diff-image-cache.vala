@@ -0,0 +1,582 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Keeps the images of the image diffs, shared by all the image diff views
+ * and keyed by blob id. An image is never decoded at full size when shown
+ * smaller: it is decoded at one of the levels of a pyramid, each level half
+ * the size of the previous one, at the smallest level which is still at
+ * least as large as shown. Once a level is decoded, the smaller ones are
+ * scaled down from it instead of being decoded again. Difference images are
+ * computed once per level as well. Decoding and computing differences are
+ * done in a thread, and the images are kept in least recently used order
+ * within a memory budget.
+ */
+public class DiffImageCache : Object
+{
+	private const size_t MEMORY_BUDGET = 128 * 1024 * 1024;
+	private const int MAX_LEVEL = 8;
+	private const int MAX_SIZES = 1000;
+
+	// Images which failed to decode are remembered at this cost, so that
+	// they are not decoded again on every draw
+	private const size_t FAILED_COST = 1024;
+
+	// Chunks in which an image is written to the loader to read its size
+	private const int HEADER_CHUNK = 4096;
+
+	private class Entry
+	{
+		public Cairo.ImageSurface? surface;
+		public size_t cost;
+	}
+
+	private class Size
+	{
+		public int width;
+		public int height;
+	}
+
+	private class Waiter
+	{
+		public SourceFunc callback;
+
+		public Waiter(owned SourceFunc callback)
+		{
+			this.callback = (owned)callback;
+		}
+	}
+
+	private delegate Cairo.ImageSurface? SurfaceFunc();
+
+	private Gee.HashMap<string, Entry> d_entries;
+	private Gee.LinkedList<string> d_order;
+	private Gee.HashMap<string, Gee.ArrayList<Waiter>> d_loading;
+	private Gee.HashMap<string, Size?> d_sizes;
+	private size_t d_size;
+
+	private static DiffImageCache? s_default;
+
+	public static DiffImageCache get_default()
+	{
+		if (s_default == null)
+		{
+			s_default = new DiffImageCache();
+		}
+
+		return s_default;
+	}
+
+	public DiffImageCache()
+	{
+		d_entries = new Gee.HashMap<string, Entry>();
+		d_order = new Gee.LinkedList<string>();
+		d_loading = new Gee.HashMap<string, Gee.ArrayList<Waiter>>();
+		d_sizes = new Gee.HashMap<string, Size?>();
+	}
+
+	/**
+	 * The level at which an image is shown at a size.
+	 *
+	 * @param natural the width of the image.
+	 * @param size the width it is shown at, in pixels.
+	 *
+	 * @return the smallest level which is at least @size wide.
+	 */
+	public static int level_for(int natural, int size)
+	{
+		var level = 0;
+
+		while (level < MAX_LEVEL && level_size(natural, level + 1) >= size)
+		{
+			level++;
+		}
+
+		return level;
+	}
+
+	/**
+	 * The size of an image at a level.
+	 */
+	public static int level_size(int natural, int level)
+	{
+		return int.max(1, (natural + (1 << level) - 1) >> level);
+	}
+
+	private static string image_key(Ggit.OId id, int level)
+	{
+		return @"$(id.to_string()):$level";
+	}
+
+	private static string difference_key(Ggit.OId old_id, Ggit.OId new_id, int level)
+	{
+		return @"$(old_id.to_string()):$(new_id.to_string()):$level";
+	}
+
+	/**
+	 * Get the size of an image, without decoding it.
+	 *
+	 * @return false if the blob is not an image.
+	 */
+	public bool size(Repository repository, Ggit.OId id, out int width, out int height)
+	{
+		width = 0;
+		height = 0;
+
+		var k = id.to_string();
+		Size? size = null;
+
+		if (d_sizes.has_key(k))
+		{
+			size = d_sizes[k];
+		}
+		else
+		{
+			size = read_size(repository, id);
+
+			if (d_sizes.size >= MAX_SIZES)
+			{
+				d_sizes.clear();
+			}
+
+			d_sizes[k] = size;
+		}
+
+		if (size == null)
+		{
+			return false;
+		}
+
+		width = size.width;
+		height = size.height;
+
+		return true;
+	}
+
+	private Size? read_size(Repository repository, Ggit.OId id)
+	{
+		Ggit.Blob blob;
+
+		try
+		{
+			blob = repository.lookup<Ggit.Blob>(id);
+		}
+		catch (Error e)
+		{
+			stderr.printf(@"ERROR: failed to load image blob: $(e.message)\n");
+			return null;
+		}
+
+		unowned uint8[] content = blob.get_raw_content();
+
+		var loader = new Gdk.PixbufLoader();
+		Size? size = null;
+
+		loader.size_prepared.connect((l, width, height) => {
+			size = new Size() { width = width, height = height };
+		});
+
+		// Only as much as needed to know the size is written
+		try
+		{
+			for (var offset = 0; offset < content.length && size == null; offset += HEADER_CHUNK)
+			{
+				loader.write(content[offset:int.min(offset + HEADER_CHUNK, content.length)]);
+			}
+		} catch {}
+
+		try
+		{
+			loader.close();
+		} catch {}
+
+		return size;
+	}
+
+	/**
+	 * Get an image at a level if it is already available.
+	 */
+	public Cairo.ImageSurface? lookup(Ggit.OId id, int level)
+	{
+		return lookup_key(image_key(id, level));
+	}
+
+	/**
+	 * Get an image at the level closest to @level which is available, to
+	 * show while the level itself loads.
+	 */
+	public Cairo.ImageSurface? lookup_nearest(Ggit.OId id, int level)
+	{
+		return nearest((l) => image_key(id, l), level);
+	}
+
+	public Cairo.ImageSurface? lookup_difference(Ggit.OId old_id, Ggit.OId new_id, int level)
+	{
+		return lookup_key(difference_key(old_id, new_id, level));
+	}
+
+	public Cairo.ImageSurface? lookup_nearest_difference(Ggit.OId old_id, Ggit.OId new_id, int level)
+	{
+		return nearest((l) => difference_key(old_id, new_id, l), level);
+	}
+
+	private delegate string KeyFunc(int level);
+
+	private Cairo.ImageSurface? nearest(KeyFunc key, int level)
+	{
+		// Larger levels first, they look better scaled down than the
+		// smaller ones scaled up
+		for (var l = level; l >= 0; l--)
+		{
+			var surface = lookup_key(key(l));
+
+			if (surface != null)
+			{
+				return surface;
+			}
+		}
+
+		for (var l = level + 1; l <= MAX_LEVEL; l++)
+		{
+			var surface = lookup_key(key(l));
+
+			if (surface != null)
+			{
+				return surface;
+			}
+		}
+
+		return null;
+	}
+
+	private Cairo.ImageSurface? lookup_key(string k)
+	{
+		var entry = d_entries[k];
+
+		if (entry == null)
+		{
+			return null;
+		}
+
+		d_order.remove(k);
+		d_order.offer_tail(k);
+
+		return entry.surface;
+	}
+
+	/**
+	 * Load an image at a level.
+	 *
+	 * @return the image, or null if it could not be decoded.
+	 */
+	public async Cairo.ImageSurface? load(Repository repository, Ggit.OId id, int level)
+	{
+		var k = image_key(id, level);
+
+		// Scaled down from the next larger level when it is there
+		var larger = level > 0 ? lookup(id, level - 1) : null;
+		int width, height;
+
+		if (larger != null && size(repository, id, out width, out height))
+		{
+			var w = level_size(width, level);
+			var h = level_size(height, level);
+
+			yield load_key(k, () => {
+				var span = Trace.begin();
+				var ret = scale(larger, w, h);
+
+				Trace.end_detail(span, "DiffImageCache.scale", "%dx%d", w, h);
+				return ret;
+			});
+		}
+		else
+		{
+			yield load_key(k, () => {
+				var span = Trace.begin();
+				var ret = decode(repository, id, level);
+
+				Trace.end_detail(span, "DiffImageCache.decode", "level %d", level);
+				return ret;
+			});
+		}
+
+		return lookup_key(k);
+	}
+
+	/**
+	 * Load the difference of two images at a level.
+	 *
+	 * The images are aligned at their top left corner, where only one of
+	 * them covers a pixel it is taken as is.
+	 */
+	public async Cairo.ImageSurface? load_difference(Repository repository, Ggit.OId old_id, Ggit.OId new_id, int level)
+	{
+		var k = difference_key(old_id, new_id, level);
+
+		if (!d_entries.has_key(k))
+		{
+			var old_surface = yield load(repository, old_id, level);
+			var new_surface = yield load(repository, new_id, level);
+
+			yield load_key(k, () => {
+				if (old_surface == null || new_surface == null)
+				{
+					return null;
+				}
+
+				var span = Trace.begin();
+				var ret = difference(old_surface, new_surface);
+
+				Trace.end(span, "DiffImageCache.difference");
+				return ret;
+			});
+		}
+
+		return lookup_key(k);
+	}
+
+	// Runs @func in a thread and adds its result, unless the key is
+	// already there or loading
+	private async void load_key(string k, owned SurfaceFunc func)
+	{
+		while (!d_entries.has_key(k))
+		{
+			var waiters = d_loading[k];
+
+			if (waiters == null)
+			{
+				d_loading[k] = new Gee.ArrayList<Waiter>();
+
+				Cairo.ImageSurface? surface = null;
+
+				yield Async.thread_try(() => {
+					surface = func();
+				});
+
+				add(k, surface);
+				wake(k);
+
+				return;
+			}
+
+			waiters.add(new Waiter(load_key.callback));
+			yield;
+		}
+	}
+
+	// Runs in a thread
+	private static Cairo.ImageSurface? decode(Repository repository, Ggit.OId id, int level)
+	{
+		Ggit.Blob blob;
+
+		try
+		{
+			blob = repository.lookup<Ggit.Blob>(id);
+		}
+		catch
+		{
+			return null;
+		}
+
+		var loader = new Gdk.PixbufLoader();
+
+		// Loaders like the jpeg one decode at the smaller size directly,
+		// the others scale each row down as it is decoded
+		loader.size_prepared.connect((l, width, height) => {
+			l.set_size(level_size(width, level), level_size(height, level));
+		});
+
+		try
+		{
+			loader.write(blob.get_raw_content());
+			loader.close();
+		}
+		catch (Error e)
+		{
+			stderr.printf(@"ERROR: failed to create pixbuf: $(e.message)\n");
+
+			try
+			{
+				loader.close();
+			} catch {}
+
+			return null;
+		}
+
+		var pixbuf = loader.get_pixbuf();
+
+		if (pixbuf == null)
+		{
+			return null;
+		}
+
+		var surface = new Cairo.ImageSurface(Cairo.Format.ARGB32, pixbuf.get_width(), pixbuf.get_height());
+		var cr = new Cairo.Context(surface);
+
+		Gdk.cairo_set_source_pixbuf(cr, pixbuf, 0, 0);
+		cr.paint();
+
+		return surface;
+	}
+
+	// Runs in a thread
+	private static Cairo.ImageSurface scale(Cairo.ImageSurface source, int width, int height)
+	{
+		var surface = new Cairo.ImageSurface(Cairo.Format.ARGB32, width, height);
+		var cr = new Cairo.Context(surface);
+
+		cr.scale((double)width / source.get_width(), (double)height / source.get_height());
+		cr.set_source_surface(source, 0, 0);
+		cr.get_source().set_filter(Cairo.Filter.GOOD);
+		cr.paint();
+
+		return surface;
+	}
+
+	/**
+	 * Compute the difference of two images, as painting @b over @a with the
+	 * difference operator would.
+	 *
+	 * The loops work on whole pixels of each row and only do integer
+	 * arithmetic, so that they can be vectorized by the compiler.
+	 */
+	public static Cairo.ImageSurface difference(Cairo.ImageSurface a, Cairo.ImageSurface b)
+	{
+		var width = int.max(a.get_width(), b.get_width());
+		var height = int.max(a.get_height(), b.get_height());
+
+		var surface = new Cairo.ImageSurface(Cairo.Format.ARGB32, width, height);
+
+		a.flush();
+		b.flush();
+		surface.flush();
+
+		unowned uchar[] adata = a.get_data();
+		unowned uchar[] bdata = b.get_data();
+		unowned uchar[] data = surface.get_data();
+
+		var astride = a.get_stride();
+		var bstride = b.get_stride();
+		var stride = surface.get_stride();
+
+		for (var y = 0; y < height; y++)
+		{
+			uint32 *row = (uint32 *)(&data[y * stride]);
+			uint32 *arow = y < a.get_height() ? (uint32 *)(&adata[y * astride]) : null;
+			uint32 *brow = y < b.get_height() ? (uint32 *)(&bdata[y * bstride]) : null;
+
+			var aw = arow != null ? a.get_width() : 0;
+			var bw = brow != null ? b.get_width() : 0;
+			var both = int.min(aw, bw);
+
+			for (var x = 0; x < both; x++)
+			{
+				row[x] = difference_pixel(arow[x], brow[x]);
+			}
+
+			// Where only one of the images covers the row
+			for (var x = both; x < aw; x++)
+			{
+				row[x] = arow[x];
+			}
+
+			for (var x = both; x < bw; x++)
+			{
+				row[x] = brow[x];
+			}
+		}
+
+		surface.mark_dirty();
+		return surface;
+	}
+
+	// Premultiplied ARGB, see the difference operator of cairo
+	private static uint32 difference_pixel(uint32 a, uint32 b)
+	{
+		uint aa = a >> 24;
+		uint ba = b >> 24;
+
+		uint32 ret = (aa + ba - div_255(aa * ba)) << 24;
+
+		for (var shift = 0; shift < 24; shift += 8)
+		{
+			uint ac = (a >> shift) & 0xff;
+			uint bc = (b >> shift) & 0xff;
+
+			uint c = ac + bc - 2 * div_255(uint.min(ac * ba, bc * aa));
+
+			ret |= uint.min(c, 0xff) << shift;
+		}
+
+		return ret;
+	}
+
+	// x / 255, rounded, for x up to 255 * 255
+	private static uint div_255(uint x)
+	{
+		x += 0x80;
+		return (x + (x >> 8)) >> 8;
+	}
+
+	private void add(string k, Cairo.ImageSurface? surface)
+	{
+		var entry = new Entry();
+
+		entry.surface = surface;
+		entry.cost = surface != null ? (size_t)surface.get_stride() * surface.get_height() : FAILED_COST;
+
+		d_entries[k] = entry;
+		d_order.offer_tail(k);
+		d_size += entry.cost;
+
+		// Keep the most recent image, even if it exceeds the budget by
+		// itself
+		while (d_size > MEMORY_BUDGET && d_order.size > 1)
+		{
+			Entry removed;
+
+			if (d_entries.unset(d_order.poll_head(), out removed))
+			{
+				d_size -= removed.cost;
+			}
+		}
+	}
+
+	private void wake(string k)
+	{
+		Gee.ArrayList<Waiter> waiters;
+
+		if (!d_loading.unset(k, out waiters))
+		{
+			return;
+		}
+
+		foreach (var waiter in waiters)
+		{
+			Idle.add((owned)waiter.callback);
+		}
+	}
+}
+
+}
+
+// ex:set ts=4 noet
@@ -23,10 +23,7 @@ class Gitg.DiffImageComposite : Gtk.DrawingArea
 
 	private void get_natural_size(out int image_width, out int image_height)
 	{
-		var pixbuf_old = cache.old_pixbuf;
-		var pixbuf_new = cache.new_pixbuf;
-
-		if (pixbuf_old == null || pixbuf_new == null)
+		if (cache.old_width == 0 || cache.new_width == 0)
 		{
 			image_width = 0;
 			image_height = 0;
@@ -34,25 +31,11 @@ class Gitg.DiffImageComposite : Gtk.DrawingArea
 			return;
 		}
 
-		var window = get_window();
-
-		int pixbuf_old_height = pixbuf_old.get_height ();
-		int pixbuf_new_height = pixbuf_new.get_height ();
-
-		int pixbuf_old_width = pixbuf_old.get_width ();
-		int pixbuf_new_width = pixbuf_new.get_width ();
-
-		double xscale_old = 1, yscale_old = 1;
-		double xscale_new = 1, yscale_new = 1;
-
-		if (window != null)
-		{
-			cache.get_old_surface(window).get_device_scale(out xscale_old, out yscale_old);
-			cache.get_new_surface(window).get_device_scale(out xscale_new, out yscale_new);
-		}
+		// Images are shown at their size in device pixels
+		var scale = get_scale_factor();
 
-		image_width = (int) double.max (pixbuf_old_width / xscale_old, pixbuf_new_width / xscale_new);
-		image_height = (int) double.max (pixbuf_old_height / xscale_old, pixbuf_new_height / xscale_new);
+		image_width = int.max(cache.old_width, cache.new_width) / scale;
+		image_height = int.max(cache.old_height, cache.new_height) / scale;
 	}
 
 	protected void get_sizing(int width, out int image_width, out int image_height)
@@ -62,11 +45,53 @@ class Gitg.DiffImageComposite : Gtk.DrawingArea
 		// Scale down to fit in width
 		if (image_width > width)
 		{
-			image_height *= width / image_width;
+			image_height = (int)((double)image_height * width / image_width);
 			image_width = width;
 		}
 	}
 
+	/* Paints the old or the new image, scaled like the composite of both
+	 * images is to fit in @image_width.
+	 */
+	protected void paint_old(Cairo.Context cr, double x, double y, int image_width, double alpha = 1)
+	{
+		paint_image(cr, x, y, image_width, cache.old_width, cache.old_height, alpha, (w) => {
+			return cache.get_old_surface(w);
+		});
+	}
+
+	protected void paint_new(Cairo.Context cr, double x, double y, int image_width, double alpha = 1)
+	{
+		paint_image(cr, x, y, image_width, cache.new_width, cache.new_height, alpha, (w) => {
+			return cache.get_new_surface(w);
+		});
+	}
+
+	private delegate Cairo.ImageSurface? SurfaceFunc(int width);
+
+	private void paint_image(Cairo.Context cr,
+	                         double        x,
+	                         double        y,
+	                         int           image_width,
+	                         int           width,
+	                         int           height,
+	                         double        alpha,
+	                         SurfaceFunc   surface_func)
+	{
+		var natural = int.max(cache.old_width, cache.new_width);
+
+		if (natural == 0 || width == 0)
+		{
+			return;
+		}
+
+		var w = (double)width * image_width / natural;
+		var h = (double)height * image_width / natural;
+
+		var surface = surface_func((int)Math.ceil(w * get_scale_factor()));
+		DiffImageSurfaceCache.paint(cr, surface, x, y, w, h, alpha);
+	}
+
 	protected override void get_preferred_width(out int minimum_width, out int natural_width)
 	{
 		int natural_height;
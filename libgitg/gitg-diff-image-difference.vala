@@ -23,36 +23,18 @@ class Gitg.DiffImageDifference : DiffImageComposite
 	{
 		base.draw(cr);
 
-		var window = get_window();
-
 		Gtk.Allocation alloc;
 		get_allocation(out alloc);
 
 		int image_width, image_height;
 		get_sizing(alloc.width, out image_width, out image_height);
 
-		var old_surface = cache.get_old_surface(window);
-		var new_surface = cache.get_new_surface(window);
-
 		int x = (alloc.width - image_width) / 2;
 		int y = 0;
 
-		if (old_surface != null)
-		{
-			cr.set_source_surface(old_surface, x, y);
-			cr.paint();
-		}
-
-		if (new_surface != null)
-		{
-			cr.save();
-			{
-				cr.set_operator(Cairo.Operator.DIFFERENCE);
-				cr.set_source_surface(new_surface, x, y);
-				cr.paint();
-			}
-			cr.restore();
-		}
+		// Computed once for both images, instead of on every draw
+		var surface = cache.get_difference_surface(image_width * get_scale_factor());
+		DiffImageSurfaceCache.paint(cr, surface, x, y, image_width, image_height);
 
 		return true;
 	}
@@ -46,30 +46,23 @@ class Gitg.DiffImageOverlay : DiffImageComposite
 	{
 		base.draw(cr);
 
-		var window = get_window();
-
 		Gtk.Allocation alloc;
 		get_allocation(out alloc);
 
 		int image_width, image_height;
 		get_sizing(alloc.width, out image_width, out image_height);
 
-		var old_surface = cache.get_old_surface(window);
-		var new_surface = cache.get_new_surface(window);
-
 		int x = (alloc.width - image_width) / 2;
 		int y = 0;
 
-		if (old_surface != null && d_alpha != 1)
+		if (d_alpha != 1)
 		{
-			cr.set_source_surface(old_surface, x, y);
-			cr.paint_with_alpha(1 - d_alpha);
+			paint_old(cr, x, y, image_width, 1 - d_alpha);
 		}
 
-		if (new_surface != null && d_alpha != 0)
+		if (d_alpha != 0)
 		{
-			cr.set_source_surface(new_surface, x, y);
-			cr.paint_with_alpha(d_alpha);
+			paint_new(cr, x, y, image_width, d_alpha);
 		}
 
 		return true;
@@ -28,11 +28,11 @@ class Gitg.DiffImageSideBySide : Gtk.DrawingArea
 	{
 		get
 		{
-			if (d_old_size_layout == null && cache.old_pixbuf != null)
+			if (d_old_size_layout == null && cache.old_width != 0)
 			{
-				string message = @"$(cache.old_pixbuf.get_width()) × $(cache.old_pixbuf.get_height())";
+				string message = @"$(cache.old_width) × $(cache.old_height)";
 
-				if (cache.new_pixbuf != null)
+				if (cache.new_width != 0)
 				{
 					// Translators: this label is displayed below the image diff, %s
 					// is substituted with the size of the image
@@ -54,11 +54,11 @@ class Gitg.DiffImageSideBySide : Gtk.DrawingArea
 	{
 		get
 		{
-			if (d_new_size_layout == null && cache.new_pixbuf != null)
+			if (d_new_size_layout == null && cache.new_width != 0)
 			{
-				string message = @"$(cache.new_pixbuf.get_width()) × $(cache.new_pixbuf.get_height())";
+				string message = @"$(cache.new_width) × $(cache.new_height)";
 
-				if (cache.old_pixbuf != null)
+				if (cache.old_width != 0)
 				{
 					// Translators: this label is displayed below the image diff, %s
 					// is substituted with the size of the image
@@ -97,36 +97,14 @@ class Gitg.DiffImageSideBySide : Gtk.DrawingArea
 	{
 		double ow = 0, oh = 0, nw = 0, nh = 0;
 
-		var old_pixbuf = cache.old_pixbuf;
-		var new_pixbuf = cache.new_pixbuf;
+		// Images are shown at their size in device pixels
+		var scale = get_scale_factor();
 
-		var window = get_window();
+		ow = (double)cache.old_width / scale;
+		oh = (double)cache.old_height / scale;
 
-		if (old_pixbuf != null)
-		{
-			double xscale = 1, yscale = 1;
-
-			if (window != null)
-			{
-				cache.get_old_surface(get_window()).get_device_scale(out xscale, out yscale);
-			}
-
-			ow = (double)old_pixbuf.get_width() / xscale;
-			oh = (double)old_pixbuf.get_height() / yscale;
-		}
-
-		if (new_pixbuf != null)
-		{
-			double xscale = 1, yscale = 1;
-
-			if (window != null)
-			{
-				cache.get_new_surface(get_window()).get_device_scale(out xscale, out yscale);
-			}
-
-			nw = (double)new_pixbuf.get_width() / xscale;
-			nh = (double)new_pixbuf.get_height() / yscale;
-		}
+		nw = (double)cache.new_width / scale;
+		nh = (double)cache.new_height / scale;
 
 		var tw = ow + nw;
 
@@ -218,15 +196,14 @@ class Gitg.DiffImageSideBySide : Gtk.DrawingArea
 
 	protected override bool draw(Cairo.Context cr)
 	{
-		var window = get_window();
-
 		Gtk.Allocation alloc;
 		get_allocation(out alloc);
 
 		var sizing = get_sizing(alloc.width);
+		var scale = get_scale_factor();
 
-		var old_surface = cache.get_old_surface(window);
-		var new_surface = cache.get_new_surface(window);
+		var old_surface = cache.get_old_surface(sizing.old_size.image_width * scale);
+		var new_surface = cache.get_new_surface(sizing.new_size.image_width * scale);
 
 		var ctx = get_style_context();
 
@@ -235,18 +212,22 @@ class Gitg.DiffImageSideBySide : Gtk.DrawingArea
 		double max_height = double.max(sizing.old_size.image_height, sizing.new_size.image_height);
 		double spread_factor = 0.5;
 
-		if (old_surface != null && new_surface != null)
+		if (cache.old_width != 0 && cache.new_width != 0)
 		{
 			spread_factor = 2.0 / 3.0;
 		}
 
-		if (old_surface != null)
+		if (cache.old_width != 0)
 		{
 			var x = (sizing.old_size.width - sizing.old_size.image_width) * spread_factor;
 			var y = (max_height - sizing.old_size.image_height) / 2;
 
-			cr.set_source_surface(old_surface, x, y);
-			cr.paint();
+			DiffImageSurfaceCache.paint(cr,
+			                            old_surface,
+			                            x,
+			                            y,
+			                            sizing.old_size.image_width,
+			                            sizing.old_size.image_height);
 
 			Pango.Rectangle rect;
 
@@ -258,18 +239,22 @@ class Gitg.DiffImageSideBySide : Gtk.DrawingArea
 			                  old_size_layout);
 		}
 
-		if (new_surface != null)
+		if (cache.new_width != 0)
 		{
 			var x = (sizing.new_size.width - sizing.new_size.image_width) * (1.0 - spread_factor);
 			var y = (max_height - sizing.new_size.image_height) / 2;
 
-			if (cache.old_pixbuf != null)
+			if (cache.old_width != 0)
 			{
 				x += sizing.old_size.width + spacing;
 			}
 
-			cr.set_source_surface(new_surface, x, y);
-			cr.paint();
+			DiffImageSurfaceCache.paint(cr,
+			                            new_surface,
+			                            x,
+			                            y,
+			                            sizing.new_size.image_width,
+			                            sizing.new_size.image_height);
 
 			Pango.Rectangle rect;
 
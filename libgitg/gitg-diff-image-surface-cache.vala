@@ -17,13 +17,54 @@
  * along with gitg. If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* The images of an image diff, shared by its views. The surfaces are asked
+ * for at the size they are shown at, in pixels, and may be smaller or larger
+ * while the surface at that size loads, changed is emitted once it is there.
+ */
 interface Gitg.DiffImageSurfaceCache : Object
 {
-	public abstract Gdk.Pixbuf? old_pixbuf { get; construct set; }
-	public abstract Gdk.Pixbuf? new_pixbuf { get; construct set; }
+	// The size of the images, 0 if there is none
+	public abstract int old_width { get; }
+	public abstract int old_height { get; }
+
+	public abstract int new_width { get; }
+	public abstract int new_height { get; }
+
+	public signal void changed();
+
+	public abstract Cairo.ImageSurface? get_old_surface(int width);
+	public abstract Cairo.ImageSurface? get_new_surface(int width);
+	public abstract Cairo.ImageSurface? get_difference_surface(int width);
+
+	// Paints @surface scaled to fill the rectangle
+	public static void paint(Cairo.Context       cr,
+	                         Cairo.ImageSurface? surface,
+	                         double              x,
+	                         double              y,
+	                         double              width,
+	                         double              height,
+	                         double              alpha = 1)
+	{
+		if (surface == null || width <= 0 || height <= 0)
+		{
+			return;
+		}
 
-	public abstract Gdk.Window window { get; construct set; }
+		cr.save();
+		{
+			cr.translate(x, y);
+			cr.scale(width / surface.get_width(), height / surface.get_height());
+			cr.set_source_surface(surface, 0, 0);
 
-	public abstract Cairo.Surface? get_old_surface(Gdk.Window window);
-	public abstract Cairo.Surface? get_new_surface(Gdk.Window window);
+			if (alpha < 1)
+			{
+				cr.paint_with_alpha(alpha);
+			}
+			else
+			{
+				cr.paint();
+			}
+		}
+		cr.restore();
+	}
 }
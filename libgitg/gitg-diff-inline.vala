@@ -0,0 +1,311 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Finds the parts of a removed line and the added line replacing it which
+ * differ, by diffing the words of both lines. Lines longer than
+ * MAX_LINE_LENGTH are not diffed, and lines with too many words are only
+ * trimmed of their common prefix and suffix.
+ */
+public class DiffInline
+{
+	public const int MAX_LINE_LENGTH = 1000;
+
+	private const int MAX_TOKENS = 400;
+
+	public class Pair
+	{
+		public string old_text;
+		public string new_text;
+
+		// The lines showing the texts, or -1 if not shown
+		public int old_line;
+		public int new_line;
+
+		// Character offsets of the changed parts, as start and end pairs
+		public int[] old_ranges;
+		public int[] new_ranges;
+
+		public Pair(string old_text, int old_line, string new_text, int new_line)
+		{
+			this.old_text = old_text;
+			this.old_line = old_line;
+			this.new_text = new_text;
+			this.new_line = new_line;
+
+			old_ranges = new int[0];
+			new_ranges = new int[0];
+		}
+	}
+
+	private struct Token
+	{
+		public int start;
+		public int end;
+		public string text;
+	}
+
+	private enum CharClass
+	{
+		WORD,
+		SPACE,
+		OTHER
+	}
+
+	private static CharClass char_class(unichar c)
+	{
+		if (c.isalnum() || c == '_')
+		{
+			return CharClass.WORD;
+		}
+		else if (c.isspace())
+		{
+			return CharClass.SPACE;
+		}
+
+		return CharClass.OTHER;
+	}
+
+	/* Splits @text in runs of word characters, runs of spaces and single
+	 * other characters, with their character offsets.
+	 */
+	private static Token[] tokenize(string text)
+	{
+		var ret = new Token[0];
+
+		int idx = 0;
+		int offset = 0;
+		unichar c;
+
+		int start_idx = 0;
+		int start = 0;
+		CharClass? cls = null;
+
+		while (true)
+		{
+			var prev_idx = idx;
+			var has_next = text.get_next_char(ref idx, out c);
+			var ccls = has_next ? char_class(c) : CharClass.OTHER;
+
+			if (cls != null && (!has_next || ccls != cls || cls == CharClass.OTHER))
+			{
+				ret += Token() {
+					start = start,
+					end = offset,
+					text = text.substring(start_idx, prev_idx - start_idx)
+				};
+
+				cls = null;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (cls == null)
+			{
+				cls = ccls;
+				start = offset;
+				start_idx = prev_idx;
+			}
+
+			offset++;
+		}
+
+		return ret;
+	}
+
+	private static void add_range(ref int[] ranges, int start, int end)
+	{
+		if (start >= end)
+		{
+			return;
+		}
+
+		var n = ranges.length;
+
+		if (n > 0 && ranges[n - 1] == start)
+		{
+			ranges[n - 1] = end;
+		}
+		else
+		{
+			ranges += start;
+			ranges += end;
+		}
+	}
+
+	/* Marks everything between the common prefix and suffix as changed. */
+	private static void diff_trimmed(Pair pair)
+	{
+		var o = pair.old_text.char_count();
+		var n = pair.new_text.char_count();
+
+		var old_chars = new unichar[o];
+		var new_chars = new unichar[n];
+
+		int idx = 0;
+		unichar c;
+
+		for (var i = 0; pair.old_text.get_next_char(ref idx, out c); i++)
+		{
+			old_chars[i] = c;
+		}
+
+		idx = 0;
+
+		for (var i = 0; pair.new_text.get_next_char(ref idx, out c); i++)
+		{
+			new_chars[i] = c;
+		}
+
+		var prefix = 0;
+
+		while (prefix < o && prefix < n && old_chars[prefix] == new_chars[prefix])
+		{
+			prefix++;
+		}
+
+		var suffix = 0;
+
+		while (suffix < o - prefix && suffix < n - prefix && old_chars[o - suffix - 1] == new_chars[n - suffix - 1])
+		{
+			suffix++;
+		}
+
+		var old_ranges = new int[0];
+		var new_ranges = new int[0];
+
+		add_range(ref old_ranges, prefix, o - suffix);
+		add_range(ref new_ranges, prefix, n - suffix);
+
+		pair.old_ranges = old_ranges;
+		pair.new_ranges = new_ranges;
+	}
+
+	/* Computes the changed ranges of @pair. */
+	public static void diff(Pair pair)
+	{
+		pair.old_ranges = new int[0];
+		pair.new_ranges = new int[0];
+
+		if (pair.old_text.length > MAX_LINE_LENGTH || pair.new_text.length > MAX_LINE_LENGTH)
+		{
+			return;
+		}
+
+		var a = tokenize(pair.old_text);
+		var b = tokenize(pair.new_text);
+
+		if (a.length > MAX_TOKENS || b.length > MAX_TOKENS)
+		{
+			diff_trimmed(pair);
+			return;
+		}
+
+		// Longest common subsequence of the tokens, lcs[i, j] is the length
+		// of the one of a[i:] and b[j:]
+		var w = b.length + 1;
+		var lcs = new int[(a.length + 1) * w];
+
+		for (var i = a.length - 1; i >= 0; i--)
+		{
+			for (var j = b.length - 1; j >= 0; j--)
+			{
+				if (a[i].text == b[j].text)
+				{
+					lcs[i * w + j] = lcs[(i + 1) * w + j + 1] + 1;
+				}
+				else
+				{
+					lcs[i * w + j] = int.max(lcs[(i + 1) * w + j], lcs[i * w + j + 1]);
+				}
+			}
+		}
+
+		if (lcs[0] == 0)
+		{
+			// Nothing in common, marking the whole lines does not tell
+			// anything more than the line colors do
+			return;
+		}
+
+		var old_ranges = new int[0];
+		var new_ranges = new int[0];
+
+		var ai = 0;
+		var bi = 0;
+
+		while (ai < a.length || bi < b.length)
+		{
+			if (ai < a.length && bi < b.length && a[ai].text == b[bi].text)
+			{
+				ai++;
+				bi++;
+			}
+			else if (bi == b.length || (ai < a.length && lcs[(ai + 1) * w + bi] >= lcs[ai * w + bi + 1]))
+			{
+				add_range(ref old_ranges, a[ai].start, a[ai].end);
+				ai++;
+			}
+			else
+			{
+				add_range(ref new_ranges, b[bi].start, b[bi].end);
+				bi++;
+			}
+		}
+
+		pair.old_ranges = old_ranges;
+		pair.new_ranges = new_ranges;
+	}
+
+	/* Computes the changed ranges of @pairs on a background thread, in
+	 * order. Stops after @budget microseconds or once cancelled, and returns
+	 * the number of pairs which were diffed.
+	 */
+	public static async int diff_all(Pair[] pairs, int64 budget, Cancellable? cancellable)
+	{
+		var done = 0;
+
+		yield Async.thread_try(() => {
+			var start = get_monotonic_time();
+
+			foreach (var pair in pairs)
+			{
+				if ((cancellable != null && cancellable.is_cancelled()) ||
+				    get_monotonic_time() - start > budget)
+				{
+					break;
+				}
+
+				diff(pair);
+				done++;
+			}
+		});
+
+		return done;
+	}
+}
+
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,100 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Queries file infos with a bounded number of queries running at the same
+ * time, so that a large diff does not open a stream for each of its files
+ * at once. Infos are queried in the order they were added, except for the
+ * infos which were prioritized (e.g. because their file is in view).
+ */
+public class DiffViewFileInfoQueue : Object
+{
+	private const uint DEFAULT_MAX_RUNNING = 4;
+
+	private Gee.LinkedList<DiffViewFileInfo> d_pending;
+	private uint d_running;
+
+	public Cancellable? cancellable { get; construct set; }
+	public uint max_running { get; construct set; default = DEFAULT_MAX_RUNNING; }
+
+	public signal void queried(DiffViewFileInfo info);
+
+	public DiffViewFileInfoQueue(Cancellable? cancellable)
+	{
+		Object(cancellable: cancellable);
+	}
+
+	construct
+	{
+		d_pending = new Gee.LinkedList<DiffViewFileInfo>();
+	}
+
+	public void add(DiffViewFileInfo info)
+	{
+		d_pending.offer_tail(info);
+		start();
+	}
+
+	/* Moves @infos to the front of the queue, keeping their order. Infos
+	 * which are already queried, or are being queried, are ignored.
+	 */
+	public void prioritize(DiffViewFileInfo[] infos)
+	{
+		for (var i = infos.length - 1; i >= 0; i--)
+		{
+			if (d_pending.remove(infos[i]))
+			{
+				d_pending.offer_head(infos[i]);
+			}
+		}
+	}
+
+	private void start()
+	{
+		while (d_running < max_running && !d_pending.is_empty)
+		{
+			if (cancellable != null && cancellable.is_cancelled())
+			{
+				d_pending.clear();
+				return;
+			}
+
+			var info = d_pending.poll_head();
+			d_running++;
+
+			info.query.begin(cancellable, (obj, res) => {
+				info.query.end(res);
+				d_running--;
+
+				if (cancellable == null || !cancellable.is_cancelled())
+				{
+					queried(info);
+				}
+
+				start();
+			});
+		}
+	}
+}
+
+}
+
+// ex:set ts=4 noet
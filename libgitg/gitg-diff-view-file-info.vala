@@ -7,6 +7,9 @@ class Gitg.DiffViewFileInfo : Object
 	public InputStream? new_file_input_stream { get; set; }
 	public string? new_file_content_type { get; private set; }
 
+	// Whether query has finished, successfully or not
+	public bool queried { get; private set; }
+
 	public DiffViewFileInfo(Repository? repository, Ggit.DiffDelta delta, bool from_workdir)
 	{
 		Object(repository: repository, delta: delta, from_workdir: from_workdir);
@@ -15,6 +18,7 @@ class Gitg.DiffViewFileInfo : Object
 	public async void query(Cancellable? cancellable)
 	{
 		yield query_content(cancellable);
+		queried = true;
 	}
 
 	private async void query_content(Cancellable? cancellable)
@@ -53,15 +53,23 @@ class Gitg.DiffViewFileRendererImage : Gtk.Grid, DiffViewFileRenderer
 
 	construct
 	{
-		d_cache = new SurfaceCache(pixbuf_for_file(delta.get_old_file()),
-		                           pixbuf_for_file(delta.get_new_file()));
+		d_cache = new SurfaceCache(repository,
+		                           blob_id_for_file(delta.get_old_file()),
+		                           blob_id_for_file(delta.get_new_file()));
 
 		d_diff_image_side_by_side.cache = d_cache;
 		d_diff_image_slider.cache = d_cache;
 		d_diff_image_overlay.cache = d_cache;
 		d_diff_image_difference.cache = d_cache;
 
-		if (d_cache.old_pixbuf == null || d_cache.new_pixbuf == null)
+		d_cache.changed.connect(() => {
+			d_diff_image_side_by_side.queue_draw();
+			d_diff_image_slider.queue_draw();
+			d_diff_image_overlay.queue_draw();
+			d_diff_image_difference.queue_draw();
+		});
+
+		if (d_cache.old_width == 0 || d_cache.new_width == 0)
 		{
 			d_stack_switcher.sensitive = false;
 		}
@@ -70,79 +78,130 @@ class Gitg.DiffViewFileRendererImage : Gtk.Grid, DiffViewFileRenderer
 		d_scale_overlay_adjustment.bind_property("value", d_diff_image_overlay, "alpha", BindingFlags.DEFAULT | BindingFlags.SYNC_CREATE);
 	}
 
-	private Gdk.Pixbuf? pixbuf_for_file(Ggit.DiffFile file)
+	private Ggit.OId? blob_id_for_file(Ggit.DiffFile file)
 	{
 		if ((file.get_flags() & Ggit.DiffFlag.VALID_ID) == 0 || file.get_oid().is_zero())
 		{
 			return null;
 		}
 
-		Ggit.Blob blob;
+		return file.get_oid();
+	}
+
+	public void add_hunk(Ggit.DiffHunk hunk, Gee.ArrayList<Ggit.DiffLine> lines)
+	{
+	}
+
+	/* The images are decoded through the shared DiffImageCache, at the size
+	 * they are shown at. Only their size is read when the diff is shown.
+	 */
+	private class SurfaceCache : Object, Gitg.DiffImageSurfaceCache {
+		private Repository d_repository;
+		private Ggit.OId? d_old_id;
+		private Ggit.OId? d_new_id;
+
+		private int d_old_width;
+		private int d_old_height;
+		private int d_new_width;
+		private int d_new_height;
 
-		try
+		public int old_width
 		{
-			blob = repository.lookup<Ggit.Blob>(file.get_oid());
+			get { return d_old_width; }
 		}
-		catch (Error e)
+
+		public int old_height
 		{
-			stderr.printf(@"ERROR: failed to load image blob: $(e.message)\n");
-			return null;
+			get { return d_old_height; }
 		}
 
-		var stream = new MemoryInputStream.from_data(blob.get_raw_content(), null);
-
-		try
+		public int new_width
 		{
-			return new Gdk.Pixbuf.from_stream(stream);
+			get { return d_new_width; }
 		}
-		catch (Error e)
+
+		public int new_height
 		{
-			stderr.printf(@"ERROR: failed to create pixbuf: $(e.message)\n");
-			return null;
+			get { return d_new_height; }
 		}
-	}
 
-	public void add_hunk(Ggit.DiffHunk hunk, Gee.ArrayList<Ggit.DiffLine> lines)
-	{
-	}
+		public SurfaceCache(Repository repository, Ggit.OId? old_id, Ggit.OId? new_id)
+		{
+			var cache = DiffImageCache.get_default();
 
-	private class SurfaceCache : Object, Gitg.DiffImageSurfaceCache {
-		private Cairo.Surface? d_old_surface;
-		private Cairo.Surface? d_new_surface;
+			d_repository = repository;
 
-		public Gdk.Pixbuf? old_pixbuf { get; construct set; }
-		public Gdk.Pixbuf? new_pixbuf { get; construct set; }
+			if (old_id != null && cache.size(repository, old_id, out d_old_width, out d_old_height))
+			{
+				d_old_id = old_id;
+			}
 
-		public Gdk.Window window { get; construct set; }
+			if (new_id != null && cache.size(repository, new_id, out d_new_width, out d_new_height))
+			{
+				d_new_id = new_id;
+			}
+		}
 
-		public SurfaceCache(Gdk.Pixbuf? old_pixbuf, Gdk.Pixbuf? new_pixbuf)
+		public Cairo.ImageSurface? get_old_surface(int width)
 		{
-			Object(old_pixbuf: old_pixbuf, new_pixbuf: new_pixbuf);
+			return get_surface(d_old_id, d_old_width, width);
 		}
 
-		public Cairo.Surface? get_old_surface(Gdk.Window window)
+		public Cairo.ImageSurface? get_new_surface(int width)
 		{
-			return get_cached_surface(window, old_pixbuf, ref d_old_surface);
+			return get_surface(d_new_id, d_new_width, width);
 		}
 
-		public Cairo.Surface? get_new_surface(Gdk.Window window)
+		private Cairo.ImageSurface? get_surface(Ggit.OId? id, int natural, int width)
 		{
-			return get_cached_surface(window, new_pixbuf, ref d_new_surface);
+			if (id == null || width <= 0)
+			{
+				return null;
+			}
+
+			var cache = DiffImageCache.get_default();
+			var level = DiffImageCache.level_for(natural, width);
+			var surface = cache.lookup(id, level);
+
+			if (surface != null)
+			{
+				return surface;
+			}
+
+			cache.load.begin(d_repository, id, level, (obj, res) => {
+				if (cache.load.end(res) != null)
+				{
+					changed();
+				}
+			});
+
+			return cache.lookup_nearest(id, level);
 		}
 
-		private Cairo.Surface? get_cached_surface(Gdk.Window window, Gdk.Pixbuf? pixbuf, ref Cairo.Surface? cached)
+		public Cairo.ImageSurface? get_difference_surface(int width)
 		{
-			if (pixbuf == null)
+			if (d_old_id == null || d_new_id == null || width <= 0)
 			{
 				return null;
 			}
 
-			if (cached == null)
+			var cache = DiffImageCache.get_default();
+			var level = DiffImageCache.level_for(int.max(d_old_width, d_new_width), width);
+			var surface = cache.lookup_difference(d_old_id, d_new_id, level);
+
+			if (surface != null)
 			{
-				cached = Gdk.cairo_surface_create_from_pixbuf(pixbuf, 0, window);
+				return surface;
 			}
 
-			return cached;
+			cache.load_difference.begin(d_repository, d_old_id, d_new_id, level, (obj, res) => {
+				if (cache.load_difference.end(res) != null)
+				{
+					changed();
+				}
+			});
+
+			return cache.lookup_nearest_difference(d_old_id, d_new_id, level);
 		}
 	}
 }
@@ -98,6 +98,16 @@ class Gitg.DiffViewFileRendererTextSplit : Gtk.Box, DiffSelectable, DiffViewFile
 		}
 	}
 
+	public bool changes_inline
+	{
+		get { return d_renderer_left.changes_inline; }
+		set
+		{
+			d_renderer_left.changes_inline = value;
+			d_renderer_right.changes_inline = value;
+		}
+	}
+
 	public DiffViewFileRendererTextSplit(DiffViewFileInfo info, bool handle_selection)
 	{
 		Object(info: info);
@@ -47,7 +47,44 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 
 	private int64 d_doffset;
 
-	private Gee.HashMap<int, PatchSet.Patch?> d_lines;
+	// Consecutive changed lines of the same type, which are contiguous in
+	// the patch. The offsets of the lines in a run are computed from the
+	// offset of the run and d_line_offsets, so that no data is needed per
+	// line apart from its offset.
+	private struct LineRun
+	{
+		public int buffer_line;
+		public int count;
+		public PatchSet.Type type;
+		public size_t old_offset;
+		public size_t new_offset;
+
+		// Index in d_line_offsets of the offset of the first line, relative
+		// to the run. The run has count + 1 offsets, the last being its end.
+		public int offsets_index;
+	}
+
+	private LineRun[] d_line_runs;
+	private uint32[] d_line_offsets;
+
+	private class PendingHunk
+	{
+		public Ggit.DiffHunk hunk;
+		public Gee.ArrayList<Ggit.DiffLine> lines;
+		public int start;
+		public int line_hunk_start;
+	}
+
+	// Files with more lines than this are shown this many lines at a time,
+	// the remaining hunks are kept until more lines are requested
+	private const int WINDOW_LINES = 5000;
+
+	private int d_window_left;
+	private Gee.ArrayList<PendingHunk> d_pending_hunks;
+	private int d_pending_lines;
+	private Gtk.TextMark? d_more_lines_mark;
+	private Gtk.Button? d_more_lines_button;
+	private int d_regions_highlighted;
 
 	private DiffViewFileSelectable d_selectable;
 	private DiffViewLinesRenderer d_old_lines;
@@ -61,10 +98,47 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 	private Gtk.SourceBuffer? d_new_highlight_buffer;
 	private bool d_old_highlight_ready;
 	private bool d_new_highlight_ready;
+	private Gee.HashMap<Gtk.TextTag, Gtk.TextTag> d_highlight_tags;
+
+	// The properties a style scheme sets on the tags of a highlight buffer,
+	// each followed by the property telling whether it is set
+	private const string[] HIGHLIGHT_TAG_PROPERTIES = {
+		"foreground-rgba", "foreground-set",
+		"background-rgba", "background-set",
+		"paragraph-background-rgba", "paragraph-background-set",
+		"style", "style-set",
+		"weight", "weight-set",
+		"underline", "underline-set",
+		"underline-rgba", "underline-rgba-set",
+		"strikethrough", "strikethrough-set",
+		"scale", "scale-set"
+	};
 
 	private Region[] d_regions;
 	private bool d_constructed;
 
+	private bool d_changes_inline;
+	private Gtk.TextTag d_inline_added_tag;
+	private Gtk.TextTag d_inline_removed_tag;
+
+	// Removed lines of the current block of changes, waiting for the added
+	// lines they pair up with
+	private Gee.ArrayList<DiffInline.Pair> d_inline_block;
+	private int d_inline_block_added;
+
+	// Pairs which still need to be diffed, and the ones which were
+	private Gee.ArrayList<DiffInline.Pair> d_inline_pending;
+	private Gee.ArrayList<DiffInline.Pair> d_inline_done;
+	private Cancellable? d_inline_cancellable;
+	private uint d_inline_id;
+	private bool d_inline_running;
+
+	// Time spent diffing the changed lines of a renderer, in microseconds,
+	// after which the remaining lines are left without inline changes
+	private const int64 INLINE_BUDGET = 250000;
+	private int64 d_inline_spent;
+	private const int INLINE_CHUNK = 64;
+
 	private Settings? d_stylesettings;
 
 	private FontManager d_font_manager;
@@ -110,6 +184,20 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 		get { return info.repository; }
 	}
 
+	public bool changes_inline
+	{
+		get { return d_changes_inline; }
+
+		set
+		{
+			if (d_changes_inline != value)
+			{
+				d_changes_inline = value;
+				update_inline();
+			}
+		}
+	}
+
 	public bool highlight
 	{
 		get { return d_highlight; }
@@ -155,10 +243,14 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 
 			for (var i = 0; i < selected.length; i++)
 			{
-				var line = selected[i];
-				var pset = d_lines[line];
+				PatchSet.Patch pset;
+
+				if (!patch_for_line(selected[i], out pset))
+				{
+					continue;
+				}
 
-				if (i == 0)
+				if (patches.length == 0)
 				{
 					patches += pset;
 					continue;
@@ -255,7 +347,20 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 			});
 		}
 
-		d_lines = new Gee.HashMap<int, PatchSet.Patch?>();
+		d_line_runs = new LineRun[0];
+		d_line_offsets = new uint32[0];
+
+		d_pending_hunks = new Gee.ArrayList<PendingHunk>();
+		d_window_left = WINDOW_LINES;
+		d_highlight_tags = new Gee.HashMap<Gtk.TextTag, Gtk.TextTag>();
+
+		d_inline_block = new Gee.ArrayList<DiffInline.Pair>();
+		d_inline_pending = new Gee.ArrayList<DiffInline.Pair>();
+		d_inline_done = new Gee.ArrayList<DiffInline.Pair>();
+
+		d_inline_added_tag = this.buffer.create_tag(null);
+		d_inline_removed_tag = this.buffer.create_tag(null);
+		update_inline_tags();
 
 		highlight = true;
 	}
@@ -269,6 +374,269 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 			d_higlight_cancellable.cancel();
 			d_higlight_cancellable = null;
 		}
+
+		// Keeps a running diff from queuing the lines it did not get to
+		d_changes_inline = false;
+
+		if (d_inline_cancellable != null)
+		{
+			d_inline_cancellable.cancel();
+			d_inline_cancellable = null;
+		}
+
+		if (d_inline_id != 0)
+		{
+			Source.remove(d_inline_id);
+			d_inline_id = 0;
+		}
+	}
+
+	/* Collects a changed line for inline diffing. Removed lines are paired
+	 * with the added lines following them, in order.
+	 */
+	private void add_inline_line(bool removed, string text, int line)
+	{
+		if (text.has_suffix("\n"))
+		{
+			text = text.slice(0, text.length - 1);
+		}
+
+		if (removed)
+		{
+			if (d_inline_block_added > 0)
+			{
+				flush_inline_block();
+			}
+
+			d_inline_block.add(new DiffInline.Pair(text, line, "", -1));
+		}
+		else if (d_inline_block_added < d_inline_block.size)
+		{
+			var pair = d_inline_block[d_inline_block_added++];
+
+			pair.new_text = text;
+			pair.new_line = line;
+		}
+	}
+
+	private void flush_inline_block()
+	{
+		for (var i = 0; i < d_inline_block_added; i++)
+		{
+			var pair = d_inline_block[i];
+
+			// Lines which are not shown by this renderer do not need to be
+			// diffed
+			if (pair.old_line >= 0 || pair.new_line >= 0)
+			{
+				d_inline_pending.add(pair);
+			}
+		}
+
+		d_inline_block.clear();
+		d_inline_block_added = 0;
+	}
+
+	private void update_inline()
+	{
+		if (d_changes_inline)
+		{
+			d_inline_pending.add_all(d_inline_done);
+			d_inline_done.clear();
+			d_inline_spent = 0;
+
+			queue_inline();
+		}
+		else
+		{
+			if (d_inline_cancellable != null)
+			{
+				d_inline_cancellable.cancel();
+				d_inline_cancellable = null;
+			}
+
+			Gtk.TextIter start, end;
+
+			buffer.get_bounds(out start, out end);
+			buffer.remove_tag(d_inline_added_tag, start, end);
+			buffer.remove_tag(d_inline_removed_tag, start, end);
+		}
+	}
+
+	private void queue_inline()
+	{
+		if (!d_changes_inline || d_inline_running || d_inline_id != 0 ||
+		    d_inline_pending.size == 0 || d_inline_spent >= INLINE_BUDGET)
+		{
+			return;
+		}
+
+		d_inline_id = Idle.add(() => {
+			d_inline_id = 0;
+			diff_inline.begin((obj, res) => {
+				diff_inline.end(res);
+			});
+
+			return false;
+		});
+	}
+
+	/* The range of buffer lines which are in view of the scrolled window
+	 * the renderer is in, or false if it is not in one.
+	 */
+	private bool visible_lines(out int first, out int last)
+	{
+		first = 0;
+		last = 0;
+
+		Gtk.ScrolledWindow? sw = null;
+
+		// The vertical scrolling happens in the outermost scrolled window
+		for (var w = get_parent(); w != null; w = w.get_parent())
+		{
+			if (w is Gtk.ScrolledWindow)
+			{
+				sw = (Gtk.ScrolledWindow)w;
+			}
+		}
+
+		if (sw == null || sw.get_child() == null)
+		{
+			return false;
+		}
+
+		int x, y;
+
+		if (!translate_coordinates(sw.get_child(), 0, 0, out x, out y))
+		{
+			return false;
+		}
+
+		var adj = sw.get_vadjustment();
+		var top = (int)adj.get_value() - y;
+
+		Gtk.TextIter iter;
+		int line_top;
+
+		get_line_at_y(out iter, top, out line_top);
+		first = iter.get_line();
+
+		get_line_at_y(out iter, top + (int)adj.get_page_size(), out line_top);
+		last = iter.get_line();
+
+		return true;
+	}
+
+	/* Diffs the pending changed lines in chunks on a background thread,
+	 * starting with the lines in view, and applies the results of each
+	 * chunk as it comes in. Lines which were not diffed, because the run was
+	 * cancelled or ran out of budget, stay pending.
+	 */
+	private async void diff_inline()
+	{
+		d_inline_running = true;
+
+		var cancellable = new Cancellable();
+		d_inline_cancellable = cancellable;
+
+		var pairs = d_inline_pending.to_array();
+		d_inline_pending.clear();
+
+		int first, last;
+
+		if (visible_lines(out first, out last))
+		{
+			var visible = new DiffInline.Pair[0];
+			var rest = new DiffInline.Pair[0];
+
+			foreach (var pair in pairs)
+			{
+				var line = pair.new_line >= 0 ? pair.new_line : pair.old_line;
+
+				if (line >= first && line <= last)
+				{
+					visible += pair;
+				}
+				else
+				{
+					rest += pair;
+				}
+			}
+
+			foreach (var pair in rest)
+			{
+				visible += pair;
+			}
+
+			pairs = visible;
+		}
+
+		var i = 0;
+
+		while (i < pairs.length && d_inline_spent < INLINE_BUDGET && !cancellable.is_cancelled())
+		{
+			var chunk = pairs[i:int.min(i + INLINE_CHUNK, pairs.length)];
+			var start = get_monotonic_time();
+
+			var done = yield DiffInline.diff_all(chunk, INLINE_BUDGET - d_inline_spent, cancellable);
+
+			d_inline_spent += get_monotonic_time() - start;
+
+			if (cancellable.is_cancelled())
+			{
+				break;
+			}
+
+			for (var j = 0; j < done; j++)
+			{
+				apply_inline(chunk[j]);
+				d_inline_done.add(chunk[j]);
+			}
+
+			i += done;
+		}
+
+		for (; i < pairs.length; i++)
+		{
+			d_inline_pending.add(pairs[i]);
+		}
+
+		if (d_inline_cancellable == cancellable)
+		{
+			d_inline_cancellable = null;
+		}
+
+		d_inline_running = false;
+
+		// Lines may have been added, or the inline changes turned off and
+		// on again, while running
+		queue_inline();
+	}
+
+	private void apply_inline(DiffInline.Pair pair)
+	{
+		if (pair.old_line >= 0)
+		{
+			apply_inline_ranges(d_inline_removed_tag, pair.old_line, pair.old_ranges);
+		}
+
+		if (pair.new_line >= 0)
+		{
+			apply_inline_ranges(d_inline_added_tag, pair.new_line, pair.new_ranges);
+		}
+	}
+
+	private void apply_inline_ranges(Gtk.TextTag tag, int line, int[] ranges)
+	{
+		for (var i = 0; i + 1 < ranges.length; i += 2)
+		{
+			Gtk.TextIter start, end;
+
+			buffer.get_iter_at_line_offset(out start, line, ranges[i]);
+			buffer.get_iter_at_line_offset(out end, line, ranges[i + 1]);
+
+			buffer.apply_tag(tag, start, end);
+		}
 	}
 
 	private void update_highlight()
@@ -289,6 +657,7 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 
 		d_old_highlight_ready = false;
 		d_new_highlight_ready = false;
+		d_regions_highlighted = 0;
 
 		if (highlight && repository != null && delta != null)
 		{
@@ -357,6 +726,7 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 			                                                    get_file_location(file),
 			                                                    stream,
 			                                                    info.new_file_content_type,
+			                                                    !info.from_workdir && !TextConv.has_textconv_command(repository, file),
 			                                                    cancellable);
 		}
 		else
@@ -423,43 +793,128 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 		bool uncertain;
 		var content_type = GLib.ContentType.guess(location.get_basename(), content, out uncertain);
 
-		var stream = new GLib.MemoryInputStream.from_bytes(new Bytes(content));
+		var is_blob = !from_workdir && !TextConv.has_textconv_command(repository, file);
+
+		if (is_blob)
+		{
+			var stream = new GLib.MemoryInputStream.from_bytes(new Bytes(content));
+			return yield load_highlighting_buffer(file, location, content_type, stream, null, cancellable);
+		}
 
-		return yield init_highlighting_buffer_from_stream(file, location, stream, content_type, cancellable);
+		return yield load_highlighting_buffer(file, location, content_type, null, new Bytes(content), cancellable);
 	}
 
-	private async Gtk.SourceBuffer? init_highlighting_buffer_from_stream(Ggit.DiffFile file, File location, InputStream stream, string content_type, Cancellable cancellable)
+	private async Gtk.SourceBuffer? init_highlighting_buffer_from_stream(Ggit.DiffFile file, File? location, InputStream stream, string? content_type, bool is_blob, Cancellable cancellable)
 	{
-		var manager = Gtk.SourceLanguageManager.get_default();
-		var language = manager.guess_language(location != null ? location.get_basename() : null, content_type);
+		if (is_blob)
+		{
+			return yield load_highlighting_buffer(file, location, content_type, stream, null, cancellable);
+		}
 
-		var buffer = new Gtk.SourceBuffer(this.buffer.tag_table);
+		// The content is needed to find the buffer in the cache
+		var output = new MemoryOutputStream.resizable();
 
-		if (language != null)
+		try
 		{
-			buffer.language = language;
+			yield output.splice_async(stream,
+			                          OutputStreamSpliceFlags.CLOSE_SOURCE | OutputStreamSpliceFlags.CLOSE_TARGET,
+			                          GLib.Priority.LOW,
+			                          cancellable);
+		}
+		catch (Error e)
+		{
+			if (!cancellable.is_cancelled())
+			{
+				stderr.printf(@"ERROR: failed to read $(file.get_path()) for highlighting: $(e.message)\n");
+			}
+
+			return null;
 		}
 
-		var style_scheme_manager = Gtk.SourceStyleSchemeManager.get_default();
+		return yield load_highlighting_buffer(file, location, content_type, null, output.steal_as_bytes(), cancellable);
+	}
 
-		buffer.highlight_syntax = true;
+	private Gtk.SourceStyleScheme? highlight_style_scheme()
+	{
+		var manager = Gtk.SourceStyleSchemeManager.get_default();
+		Gtk.SourceStyleScheme? scheme = null;
 
-		d_stylesettings = try_settings(Gitg.Config.APPLICATION_ID + ".preferences.interface");
 		if (d_stylesettings != null)
 		{
-			d_stylesettings.changed["style-scheme"].connect((s, k) => {
+			scheme = manager.get_scheme(d_stylesettings.get_string("style-scheme"));
+		}
+
+		return scheme != null ? scheme : manager.get_scheme("classic");
+	}
+
+	/* Gets the highlighted buffer of @file from the shared highlight cache,
+	 * loading it from @stream or @content if it is not cached yet. Blobs
+	 * (@content is null) are cached by their id, other content by its
+	 * checksum.
+	 */
+	private async Gtk.SourceBuffer? load_highlighting_buffer(Ggit.DiffFile file,
+	                                                         File?          location,
+	                                                         string?        content_type,
+	                                                         InputStream?   stream,
+	                                                         Bytes?         content,
+	                                                         Cancellable    cancellable)
+	{
+		var manager = Gtk.SourceLanguageManager.get_default();
+		var language = manager.guess_language(location != null ? location.get_basename() : null, content_type);
+
+		if (d_stylesettings == null)
+		{
+			d_stylesettings = try_settings(Gitg.Config.APPLICATION_ID + ".preferences.interface");
+
+			if (d_stylesettings != null)
+			{
+				d_stylesettings.changed["style-scheme"].connect((s, k) => {
+					update_style();
+				});
+
 				update_style();
-			});
+			}
+		}
+
+		var scheme = highlight_style_scheme();
+		var cache = HighlightCache.get_default();
+
+		string key;
 
-			update_style();
-		} else {
-			buffer.style_scheme = style_scheme_manager.get_scheme("classic");
+		if (content == null)
+		{
+			key = HighlightCache.key_for_blob(file.get_oid(), language, scheme);
 		}
+		else
+		{
+			key = HighlightCache.key_for_content(content, language, scheme);
+		}
+
+		bool load;
+		var cached = yield cache.lookup(key, out load);
+
+		if (!load)
+		{
+			return cached;
+		}
+
+		// Cached buffers have a tag table of their own, their tags are
+		// copied to the tag table of each renderer using them, see
+		// highlight_tag
+		var buffer = new Gtk.SourceBuffer(null);
+
+		if (language != null)
+		{
+			buffer.language = language;
+		}
+
+		buffer.style_scheme = scheme;
+		buffer.highlight_syntax = true;
 
 		var sfile = new Gtk.SourceFile();
 		sfile.location = location;
 
-		var loader = new Gtk.SourceFileLoader.from_stream(buffer, sfile, stream);
+		var loader = new Gtk.SourceFileLoader.from_stream(buffer, sfile, stream != null ? stream : new MemoryInputStream.from_bytes(content));
 
 		try
 		{
@@ -472,11 +927,51 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 			{
 				stderr.printf(@"ERROR: failed to load $(file.get_path()) for highlighting: $(e.message)\n");
 			}
+
+			cache.cancel_load(key);
+			return buffer;
 		}
 
+		cache.add(key, buffer);
 		return buffer;
 	}
 
+	/* Gets the tag of this renderer's buffer which looks like @tag of a
+	 * cached highlight buffer.
+	 */
+	private Gtk.TextTag highlight_tag(Gtk.TextTag tag)
+	{
+		var ret = d_highlight_tags[tag];
+
+		if (ret != null)
+		{
+			return ret;
+		}
+
+		ret = new Gtk.TextTag();
+
+		for (var i = 0; i < HIGHLIGHT_TAG_PROPERTIES.length; i += 2)
+		{
+			var prop = HIGHLIGHT_TAG_PROPERTIES[i];
+			bool isset;
+
+			tag.get(HIGHLIGHT_TAG_PROPERTIES[i + 1], out isset);
+
+			if (isset)
+			{
+				var val = Value(tag.get_class().find_property(prop).value_type);
+
+				tag.get_property(prop, ref val);
+				ret.set_property(prop, val);
+			}
+		}
+
+		this.buffer.tag_table.add(ret);
+		d_highlight_tags[tag] = ret;
+
+		return ret;
+	}
+
 	private void update_style()
 	{
 		var scheme = d_stylesettings.get_string("style-scheme");
@@ -538,7 +1033,12 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 
 		// Go over all the source chunks and match up to old/new buffer. Then,
 		// apply the tags that are applied to the highlighted source buffers.
-		foreach (var region in d_regions)
+		// Regions added after the highlighting was applied (when showing
+		// more lines of a large file) are applied as they come.
+		var regions = d_regions[d_regions_highlighted:d_regions.length];
+		d_regions_highlighted = d_regions.length;
+
+		foreach (var region in regions)
 		{
 			Gtk.SourceBuffer? source;
 
@@ -579,7 +1079,7 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 
 				foreach (var tag in tags)
 				{
-					buffer.apply_tag(tag, buffer_iter, buffer_next_iter);
+					buffer.apply_tag(highlight_tag(tag), buffer_iter, buffer_next_iter);
 				}
 
 				source_iter = source_next_iter;
@@ -590,7 +1090,7 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 
 			foreach (var tag in tags)
 			{
-				buffer.apply_tag(tag, buffer_iter, buffer_end_iter);
+				buffer.apply_tag(highlight_tag(tag), buffer_iter, buffer_end_iter);
 			}
 		}
 	}
@@ -671,6 +1171,27 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 		this.set_mark_attributes("header", header_attributes, 0);
 		this.set_mark_attributes("added", added_attributes, 0);
 		this.set_mark_attributes("removed", removed_attributes, 0);
+
+		update_inline_tags();
+	}
+
+	private void update_inline_tags()
+	{
+		if (d_inline_added_tag == null)
+		{
+			return;
+		}
+
+		if (new Theme().is_theme_dark())
+		{
+			d_inline_added_tag.background_rgba = Gdk.RGBA() { red = 52.0 / 255.0, green = 114.0 / 255.0, blue = 35.0 / 255.0, alpha = 1.0 };
+			d_inline_removed_tag.background_rgba = Gdk.RGBA() { red = 182.0 / 255.0, green = 76.0 / 255.0, blue = 73.0 / 255.0, alpha = 1.0 };
+		}
+		else
+		{
+			d_inline_added_tag.background_rgba = Gdk.RGBA() { red = 170.0 / 255.0, green = 240.0 / 255.0, blue = 170.0 / 255.0, alpha = 1.0 };
+			d_inline_removed_tag.background_rgba = Gdk.RGBA() { red = 1.0, green = 175.0 / 255.0, blue = 175.0 / 255.0, alpha = 1.0 };
+		}
 	}
 
 	protected override void constructed()
@@ -681,38 +1202,294 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 		update_highlight();
 	}
 
-	public void add_hunk(Ggit.DiffHunk hunk, Gee.ArrayList<Ggit.DiffLine> lines)
+	private void add_changed_line(int buffer_line, PatchSet.Patch pset)
 	{
-		var buffer = this.buffer as Gtk.SourceBuffer;
+		var n = d_line_runs.length;
+
+		if (n > 0)
+		{
+			var run = d_line_runs[n - 1];
+			var end = d_line_offsets[run.offsets_index + run.count];
+
+			bool contiguous;
+
+			if (pset.type == PatchSet.Type.ADD)
+			{
+				contiguous = run.old_offset == pset.old_offset && run.new_offset + end == pset.new_offset;
+			}
+			else
+			{
+				contiguous = run.new_offset == pset.new_offset && run.old_offset + end == pset.old_offset;
+			}
+
+			if (contiguous && run.type == pset.type && run.buffer_line + run.count == buffer_line)
+			{
+				d_line_offsets += end + (uint32)pset.length;
+				d_line_runs[n - 1].count++;
+				return;
+			}
+		}
+
+		d_line_runs += LineRun() {
+			buffer_line = buffer_line,
+			count = 1,
+			type = pset.type,
+			old_offset = pset.old_offset,
+			new_offset = pset.new_offset,
+			offsets_index = d_line_offsets.length
+		};
+
+		d_line_offsets += 0;
+		d_line_offsets += (uint32)pset.length;
+	}
+
+	/* Computes the patch of the changed line @buffer_line from its run,
+	 * returns false if the line is not a changed line.
+	 */
+	private bool patch_for_line(int buffer_line, out PatchSet.Patch pset)
+	{
+		pset = PatchSet.Patch();
+
+		int lo = 0;
+		int hi = d_line_runs.length;
 
-		/* Diff hunk */
-		var h = hunk.get_header();
-		var pos = h.last_index_of("@@");
+		while (lo < hi)
+		{
+			var mid = (lo + hi) / 2;
 
-		if (pos >= 0)
+			if (d_line_runs[mid].buffer_line + d_line_runs[mid].count <= buffer_line)
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+
+		if (lo == d_line_runs.length || d_line_runs[lo].buffer_line > buffer_line)
 		{
-			h = h.substring(pos + 2).chug();
+			return false;
 		}
 
-		h = h.chomp();
+		var run = d_line_runs[lo];
+		var idx = run.offsets_index + buffer_line - run.buffer_line;
+		var rel = (size_t)d_line_offsets[idx];
+
+		pset.type = run.type;
+		pset.length = (size_t)(d_line_offsets[idx + 1] - d_line_offsets[idx]);
+
+		if (run.type == PatchSet.Type.ADD)
+		{
+			pset.old_offset = run.old_offset;
+			pset.new_offset = run.new_offset + rel;
+		}
+		else
+		{
+			pset.old_offset = run.old_offset + rel;
+			pset.new_offset = run.new_offset;
+		}
+
+		return true;
+	}
+
+	/* Shows, or removes, the button at the end of the buffer to show more
+	 * lines of a large file.
+	 */
+	private void update_more_lines()
+	{
+		var buffer = this.buffer as Gtk.SourceBuffer;
+
+		if (d_more_lines_mark != null)
+		{
+			Gtk.TextIter start, end;
+
+			buffer.get_iter_at_mark(out start, d_more_lines_mark);
+			buffer.get_end_iter(out end);
+			buffer.delete(ref start, ref end);
+
+			buffer.delete_mark(d_more_lines_mark);
+			d_more_lines_mark = null;
+			d_more_lines_button = null;
+		}
+
+		if (d_pending_hunks.size == 0)
+		{
+			return;
+		}
 
 		Gtk.TextIter iter;
 		buffer.get_end_iter(out iter);
 
-		if (!iter.is_start())
+		d_more_lines_mark = buffer.create_mark(null, iter, true);
+
+		if (!iter.starts_line())
 		{
 			buffer.insert(ref iter, "\n", 1);
 		}
 
-		iter.set_line_offset(0);
-		buffer.create_source_mark(null, "header", iter);
+		buffer.create_source_mark(null, "empty", iter);
+
+		var anchor = buffer.create_child_anchor(iter);
+
+		var n = int.min(d_pending_lines, WINDOW_LINES);
+
+		d_more_lines_button = new Gtk.Button.with_label(ngettext("Show %d more line (%d hidden)",
+		                                                         "Show %d more lines (%d hidden)",
+		                                                         n).printf(n, d_pending_lines));
+
+		d_more_lines_button.relief = Gtk.ReliefStyle.NONE;
+		d_more_lines_button.clicked.connect(show_more_lines);
+		d_more_lines_button.show();
+
+		add_child_at_anchor(d_more_lines_button, anchor);
+	}
+
+	private void show_more_lines()
+	{
+		d_window_left = WINDOW_LINES;
+
+		// Removes the button, the lines are added where it was
+		var pending = d_pending_hunks;
+		d_pending_hunks = new Gee.ArrayList<PendingHunk>();
+		d_pending_lines = 0;
+
+		update_more_lines();
+
+		var i = 0;
+
+		for (; i < pending.size && d_window_left > 0; i++)
+		{
+			var p = pending[i];
+			add_hunk_lines(p.hunk, p.lines, p.start, p.line_hunk_start, true);
+
+			if (d_pending_hunks.size > 0)
+			{
+				// The window was filled in the middle of this hunk
+				i++;
+				break;
+			}
+		}
+
+		for (; i < pending.size; i++)
+		{
+			d_pending_hunks.add(pending[i]);
+			d_pending_lines += pending[i].lines.size - pending[i].start;
+		}
+
+		update_more_lines();
+		update_highlighting_ready();
+	}
 
-		var header = @"@@ -$(hunk.get_old_start()),$(hunk.get_old_lines()) +$(hunk.get_new_start()),$(hunk.get_new_lines()) @@ $h\n";
-		buffer.insert(ref iter, header, -1);
+	public void add_hunk(Ggit.DiffHunk hunk, Gee.ArrayList<Ggit.DiffLine> lines)
+	{
+		if (d_pending_hunks.size > 0)
+		{
+			// Only shown once the lines before it are
+			queue_hunk(hunk, lines, 0, -1, false, false);
+			update_more_lines();
+			return;
+		}
+
+		add_hunk_lines(hunk, lines, 0, -1, false);
+	}
+
+	private void count_changes(Gee.ArrayList<Ggit.DiffLine> lines, int start)
+	{
+		for (var i = start; i < lines.size; i++)
+		{
+			var origin = lines[i].get_origin();
+
+			if (origin == Ggit.DiffLineType.ADDITION)
+			{
+				this.added++;
+			}
+			else if (origin == Ggit.DiffLineType.DELETION)
+			{
+				this.removed++;
+			}
+		}
+	}
+
+	private void queue_hunk(Ggit.DiffHunk hunk, Gee.ArrayList<Ggit.DiffLine> lines, int start, int line_hunk_start, bool counted, bool first)
+	{
+		// The changes are counted right away, so that the statistics of the
+		// file include the lines which are not shown yet
+		if (!counted)
+		{
+			count_changes(lines, start);
+		}
+
+		var pending = new PendingHunk() {
+			hunk = hunk,
+			lines = lines,
+			start = start,
+			line_hunk_start = line_hunk_start
+		};
+
+		if (first)
+		{
+			d_pending_hunks.insert(0, pending);
+		}
+		else
+		{
+			d_pending_hunks.add(pending);
+		}
+
+		d_pending_lines += lines.size - start;
+	}
+
+	/* Adds the lines of @hunk from @start on, up to the number of lines left
+	 * in the window. The remaining lines are queued. @line_hunk_start is the
+	 * first line of the hunk in the buffer if its first lines were added
+	 * before, or -1 to add the hunk header. @counted is whether the changes
+	 * of the lines were counted already, when they were queued.
+	 */
+	private void add_hunk_lines(Ggit.DiffHunk hunk, Gee.ArrayList<Ggit.DiffLine> lines, int start, int line_hunk_start, bool counted)
+	{
+		var buffer = this.buffer as Gtk.SourceBuffer;
+
+		Gtk.TextIter iter;
+		buffer.get_end_iter(out iter);
+
+		if (line_hunk_start < 0)
+		{
+			/* Diff hunk */
+			var h = hunk.get_header();
+			var pos = h.last_index_of("@@");
+
+			if (pos >= 0)
+			{
+				h = h.substring(pos + 2).chug();
+			}
+
+			h = h.chomp();
+
+			if (!iter.is_start())
+			{
+				buffer.insert(ref iter, "\n", 1);
+			}
+
+			iter.set_line_offset(0);
+			buffer.create_source_mark(null, "header", iter);
+
+			var header = @"@@ -$(hunk.get_old_start()),$(hunk.get_old_lines()) +$(hunk.get_new_start()),$(hunk.get_new_lines()) @@ $h\n";
+			buffer.insert(ref iter, header, -1);
+
+			line_hunk_start = iter.get_line();
+		}
 
 		int buffer_line = iter.get_line();
 
-		int line_hunk_start = iter.get_line();
+		// Large files are shown a window of lines at a time
+		var stop = lines.size;
+
+		if (stop - start > d_window_left)
+		{
+			stop = start + d_window_left;
+		}
+
+		d_window_left -= stop - start;
 
 		var region = Region() {
 			type = RegionType.CONTEXT,
@@ -726,7 +1503,7 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 		var add_line_num = 0;
 		var remove_line_num = 0;
 		var in_change_line = false;
-		for (var i = 0; i < lines.size; i++)
+		for (var i = start; i < stop; i++)
 		{
 			var line = lines[i];
 			var text = line.get_text().replace("\r", "");
@@ -740,13 +1517,21 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 			{
 				case Ggit.DiffLineType.ADDITION:
 					added = true;
-					this.added++;
+
+					if (!counted)
+					{
+						this.added++;
+					}
 
 					rtype = RegionType.ADDED;
 					break;
 				case Ggit.DiffLineType.DELETION:
 					removed = true;
-					this.removed++;
+
+					if (!counted)
+					{
+						this.removed++;
+					}
 
 					rtype = RegionType.REMOVED;
 					break;
@@ -762,9 +1547,9 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 					break;
 			}
 
-			if (i == 0 || rtype != region.type)
+			if (i == start || rtype != region.type)
 			{
-				if (i != 0)
+				if (i != start)
 				{
 					d_regions += region;
 				}
@@ -812,7 +1597,11 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 					pset.new_offset = (size_t)((int64)pset.new_offset + d_doffset);
 				}
 
-				d_lines[buffer_line] = pset;
+				// Only lines shown by this renderer can be selected
+				if (d_style == Style.ONE || (d_style == Style.OLD) == removed)
+				{
+					add_changed_line(buffer_line, pset);
+				}
 				d_doffset += added ? (int64)bytes.length : -(int64)bytes.length;
 			}
 
@@ -823,6 +1612,8 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 
 			if (rtype == RegionType.CONTEXT)
 			{
+				flush_inline_block();
+
 				if (d_style == Style.OLD || d_style == Style.NEW)
 				{
 					if (in_change_line == true)
@@ -879,6 +1670,8 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 				buffer.get_end_iter(out t_iter);
 				buffer.create_source_mark(null, mark, t_iter);
 
+				add_inline_line(rtype == RegionType.REMOVED, text, buffer_line);
+
 				buffer.insert(ref iter, text, -1);
 				buffer_line++;
 				if (d_style == Style.OLD || d_style == Style.NEW)
@@ -912,11 +1705,15 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 					else
 						remove_line_num++;
 					in_change_line = true;
+
+					add_inline_line(rtype == RegionType.REMOVED, text, -1);
 				} else if (d_style == Style.ONE) {
 					Gtk.TextIter t_iter;
 					buffer.get_end_iter(out t_iter);
 					buffer.create_source_mark(null, "added", t_iter);
 
+					add_inline_line(false, text, buffer_line);
+
 					buffer.insert(ref iter, text, -1);
 					buffer_line++;
 				}
@@ -928,6 +1725,9 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 			d_regions += region;
 		}
 
+		flush_inline_block();
+		queue_inline();
+
 		if (d_style == Style.ONE || d_style == Style.OLD)
 		{
 			d_old_lines.add_hunk(line_hunk_start, iter.get_line(), hunk, buffer);
@@ -941,6 +1741,12 @@ class Gitg.DiffViewFileRendererText : Gtk.SourceView, DiffSelectable, DiffViewFi
 		this.thaw_notify();
 
 		sensitive = true;
+
+		if (stop < lines.size)
+		{
+			queue_hunk(hunk, lines, stop, line_hunk_start, counted, true);
+			update_more_lines();
+		}
 	}
 }
 
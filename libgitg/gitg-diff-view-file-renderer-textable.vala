@@ -23,6 +23,7 @@ interface Gitg.DiffViewFileRendererTextable : DiffSelectable, DiffViewFileRender
 	public abstract new int tab_width { get; set; }
 	public abstract int maxlines { get; set; }
 	public abstract bool highlight { get; construct set; }
+	public abstract bool changes_inline { get; set; }
 }
 
 // ex:ts=4 noet
@@ -39,6 +39,7 @@ class Gitg.DiffViewFile : Gtk.Grid
 	private unowned Gtk.Stack? d_stack_file_renderer;
 
 	private bool d_expanded;
+	private bool d_populated;
 
 	public Gee.ArrayList<DiffViewFileRenderer> renderer_list {get; private set;}
 
@@ -57,12 +58,7 @@ class Gitg.DiffViewFile : Gtk.Grid
 			{
 				d_expanded = value;
 				d_revealer_content.reveal_child = d_expanded;
-				bool visible = false;
-				if (d_expanded)
-				{
-					visible = d_stack_file_renderer.get_children().length() > 1;
-				}
-				d_stack_switcher.set_visible(visible);
+				update_stack_switcher();
 
 
 				var ctx = get_style_context();
@@ -79,6 +75,17 @@ class Gitg.DiffViewFile : Gtk.Grid
 		}
 	}
 
+	/* Emitted when the content of the file is needed, which is when the
+	 * file is expanded and scrolled into view. Handlers add the renderers
+	 * and the hunks of the file.
+	 */
+	public signal void populate();
+
+	public bool populated
+	{
+		get { return d_populated; }
+	}
+
 	public DiffViewFileInfo? info {get; construct set;}
 	private Gee.HashMap<Gtk.Widget, bool> d_diff_stat_visible_map = new Gee.HashMap<Gtk.Widget, bool>();
 
@@ -134,10 +141,91 @@ class Gitg.DiffViewFile : Gtk.Grid
 	private void page_changed()
 	{
 		var visible_child = d_stack_file_renderer.get_visible_child();
+
+		if (visible_child == null)
+		{
+			return;
+		}
+
 		var visible = d_diff_stat_visible_map.get(visible_child);
 		d_diff_stat_file.set_visible(visible);
 	}
 
+	private void update_stack_switcher()
+	{
+		bool visible = false;
+
+		if (d_expanded)
+		{
+			visible = d_stack_file_renderer.get_children().length() > 1;
+		}
+
+		d_stack_switcher.set_visible(visible);
+	}
+
+	public void ensure_populated()
+	{
+		if (d_populated)
+		{
+			return;
+		}
+
+		d_populated = true;
+		d_stack_file_renderer.set_size_request(-1, -1);
+
+		populate();
+		update_stack_switcher();
+	}
+
+	/* Destroys the renderers of the file, they are created again when the
+	 * file needs to be shown. The file keeps its current height so that the
+	 * view does not jump.
+	 */
+	public void release()
+	{
+		if (!d_populated)
+		{
+			return;
+		}
+
+		Gtk.Allocation alloc;
+		d_stack_file_renderer.get_allocation(out alloc);
+
+		d_populated = false;
+
+		foreach (var child in d_stack_file_renderer.get_children())
+		{
+			child.destroy();
+		}
+
+		renderer_list.clear();
+		d_diff_stat_visible_map.clear();
+
+		d_stack_file_renderer.set_size_request(-1, alloc.height);
+	}
+
+	/* Reserves the height of about @lines lines of text for the content
+	 * of a file which has not been populated yet.
+	 */
+	public void set_placeholder_lines(int lines)
+	{
+		if (d_populated)
+		{
+			return;
+		}
+
+		var metrics = get_pango_context().get_metrics(null, null);
+		var height = (metrics.get_ascent() + metrics.get_descent()) / Pango.SCALE;
+
+		d_stack_file_renderer.set_size_request(-1, lines * height);
+	}
+
+	public void set_stats(uint added, uint removed)
+	{
+		d_diff_stat_file.added = added;
+		d_diff_stat_file.removed = removed;
+	}
+
 	public void add_renderer(DiffViewFileRenderer renderer, Gtk.Widget widget, string name, string title, bool show_stats)
 	{
 		d_diff_stat_visible_map.set(widget, show_stats);
@@ -296,7 +296,18 @@ class Gitg.DiffViewLinesRenderer : Gtk.SourceGutterRendererText
 		info.hunk = hunk;
 		info.line_infos = precalculate_line_strings(hunk, buffer, buffer_line_start);
 
-		d_hunks_list.add(info);
+		// The lines of a hunk of a large file can be added in parts, each
+		// part replaces the info of the previous ones
+		var n = d_hunks_list.size;
+
+		if (n > 0 && d_hunks_list[n - 1].hunk_line == info.hunk_line)
+		{
+			d_hunks_list[n - 1] = info;
+		}
+		else
+		{
+			d_hunks_list.add(info);
+		}
 
 		recalculate_size();
 	}
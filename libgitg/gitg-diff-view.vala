@@ -56,6 +56,11 @@ public class Gitg.DiffView : Gtk.Grid
 
 	private uint d_reveal_options_timeout;
 	private uint d_unreveal_options_timeout;
+	private uint d_populate_visible_id;
+	private DiffViewFileInfoQueue? d_info_queue;
+
+	// Files further than this many pages out of view release their content
+	private const int RELEASE_PAGES = 4;
 
 	private static Gee.HashSet<string> s_image_mime_types;
 
@@ -182,9 +187,6 @@ public class Gitg.DiffView : Gtk.Grid
 			if (d_changes_inline != value)
 			{
 				d_changes_inline = value;
-
-				// TODO
-				//options_changed();
 			}
 		}
 	}
@@ -231,6 +233,12 @@ public class Gitg.DiffView : Gtk.Grid
 			d_cancellable.cancel();
 		}
 
+		if (d_populate_visible_id != 0)
+		{
+			Source.remove(d_populate_visible_id);
+			d_populate_visible_id = 0;
+		}
+
 		base.dispose();
 	}
 
@@ -272,6 +280,9 @@ public class Gitg.DiffView : Gtk.Grid
 	construct
 	{
 		context_lines = 3;
+
+		d_scrolledwindow.get_vadjustment().value_changed.connect(queue_populate_visible);
+		d_grid_files.size_allocate.connect_after(queue_populate_visible);
 	}
 
 	private string message_without_subject(Commit commit)
@@ -566,7 +577,7 @@ public class Gitg.DiffView : Gtk.Grid
 				}
 			}
 
-			d_diff = d_commit.get_diff(options, parent);
+			load_commit_diff(d_commit, parent, preserve_expanded, d_cancellable);
 			d_commit_details.show();
 
 			var message = message_without_subject(d_commit);
@@ -586,14 +597,51 @@ public class Gitg.DiffView : Gtk.Grid
 			d_commit_details.hide();
 
 			d_text_view_message.hide();
-		}
 
-		if (d_diff != null)
-		{
+			d_grid_files.sensitive = true;
 			update_diff(d_diff, preserve_expanded, d_cancellable);
 		}
 	}
 
+	/* Computes the diff of @commit on the diff thread. The files of the
+	 * previous diff stay in place, insensitive, until it is done, so that
+	 * moving quickly through the history does not flicker. Diffs which are
+	 * not needed anymore are cancelled through @cancellable.
+	 */
+	private void load_commit_diff(Commit       commit,
+	                              int          parent,
+	                              bool         preserve_expanded,
+	                              Cancellable? cancellable)
+	{
+		d_grid_files.sensitive = false;
+
+		commit.get_diff_async.begin(options, parent, cancellable, (obj, res) => {
+			Ggit.Diff? diff = null;
+
+			try
+			{
+				diff = commit.get_diff_async.end(res);
+			}
+			catch (Error e)
+			{
+				stderr.printf("Error when getting diff: %s\n", e.message);
+			}
+
+			if (cancellable.is_cancelled() || d_commit != commit)
+			{
+				return;
+			}
+
+			d_diff = diff;
+			d_grid_files.sensitive = true;
+
+			if (d_diff != null)
+			{
+				update_diff(d_diff, preserve_expanded, cancellable);
+			}
+		});
+	}
+
 	private void parse_smart_text(Gtk.TextBuffer buffer)
 	{
 		if (repository != null)
@@ -670,330 +718,277 @@ public class Gitg.DiffView : Gtk.Grid
 		return path;
 	}
 
-	private delegate void Anon();
-
-	private string key_for_delta(Ggit.DiffDelta delta)
+	private void update_diff(Ggit.Diff diff, bool preserve_expanded, Cancellable? cancellable)
 	{
-		var new_file = delta.get_new_file();
-		var new_path = new_file.get_path();
+		var span = Trace.begin();
+		var infos = new DiffViewFileInfo[diff.get_num_deltas()];
 
-		if (new_path != null)
+		for (var i = 0; i < infos.length; i++)
 		{
-			return @"path:$(new_path)";
+			infos[i] = new DiffViewFileInfo(repository, diff.get_delta(i), new_is_workdir);
 		}
 
-		var old_file = delta.get_old_file();
-		var old_path = old_file.get_path();
+		// The files are shown right away, and each is populated once its
+		// info has been queried in the background
+		d_info_queue = new DiffViewFileInfoQueue(cancellable);
+		d_info_queue.queried.connect(queue_populate_visible);
+
+		update_diff_hunks(diff, preserve_expanded, infos, cancellable);
 
-		if (old_path != null)
+		foreach (var info in infos)
 		{
-			return @"path:$(old_path)";
+			d_info_queue.add(info);
 		}
 
-		return "";
+		Trace.end_detail(span, "DiffView.update_diff", "%d files", infos.length);
 	}
 
-	private void update_diff(Ggit.Diff diff, bool preserve_expanded, Cancellable? cancellable)
+	private bool is_known_binary(DiffViewFileInfo? info)
 	{
-		var nqueries = 0;
-		var finished = false;
-		var infomap = new Gee.HashMap<string, DiffViewFileInfo>();
+		// List of known binary file types that may be wrongly classified by
+		// libgit2 because it does not contain any null bytes in the first N
+		// bytes. E.g. PDF
+		var known_binary_files_types = new string[] {"application/pdf"};
+
+		return info != null && info.new_file_content_type in known_binary_files_types;
+	}
 
-		Anon check_finish = () => {
-			if (nqueries == 0 && finished && (cancellable == null || !cancellable.is_cancelled()))
+	private string? mime_type_for_delta(Ggit.DiffDelta delta, DiffViewFileInfo? info)
+	{
+		if (info != null && info.new_file_content_type != null)
+		{
+			return ContentType.get_mime_type(info.new_file_content_type);
+		}
+
+		// Guess mime type from old file name in the case of a deleted file
+		var oldpath = delta.get_old_file().get_path();
+
+		if (oldpath != null)
+		{
+			bool uncertain;
+			var ctype = ContentType.guess(Path.get_basename(oldpath), null, out uncertain);
+
+			if (ctype != null)
 			{
-				finished = false;
-				update_diff_hunks(diff, preserve_expanded, infomap, cancellable);
+				return ContentType.get_mime_type(ctype);
 			}
-		};
+		}
 
-		// Collect file info asynchronously first
-		for (var i = 0; i < diff.get_num_deltas(); i++)
+		return null;
+	}
+
+	private void add_patch_hunks(DiffViewFile file, Ggit.Patch patch) throws Error
+	{
+		for (size_t i = 0; i < patch.get_num_hunks(); i++)
 		{
-			var delta = diff.get_delta(i);
-			var info = new DiffViewFileInfo(repository, delta, new_is_workdir);
+			var hunk = patch.get_hunk(i);
+			var lines = new Gee.ArrayList<Ggit.DiffLine>();
+			var n = patch.get_num_lines_in_hunk(i);
 
-			nqueries++;
+			for (var l = 0; l < n; l++)
+			{
+				lines.add(patch.get_line_in_hunk(i, l));
+			}
 
-			info.query.begin(cancellable, (obj, res) => {
-				info.query.end(res);
+			file.add_hunk(hunk, lines);
+		}
+	}
 
-				infomap[key_for_delta(delta)] = info;
+	private void add_text_renderer(DiffViewFile file, int maxlines)
+	{
+		file.add_text_renderer(handle_selection);
 
-				nqueries--;
+		foreach (DiffViewFileRenderer renderer in file.renderer_list)
+		{
+			var renderer_text = renderer as DiffViewFileRendererTextable;
 
-				check_finish();
-			});
+			if (renderer_text != null)
+			{
+				bind_property("highlight", renderer_text, "highlight", BindingFlags.SYNC_CREATE);
+				bind_property("wrap-lines", renderer_text, "wrap-lines", BindingFlags.DEFAULT | BindingFlags.SYNC_CREATE);
+				bind_property("tab-width", renderer_text, "tab-width", BindingFlags.DEFAULT | BindingFlags.SYNC_CREATE);
+				bind_property("changes-inline", renderer_text, "changes-inline", BindingFlags.SYNC_CREATE);
+				renderer_text.maxlines = maxlines;
+				renderer_text.notify["has-selection"].connect(on_selection_changed);
+			}
 		}
 
-		finished = true;
-		check_finish();
+		on_selection_changed();
 	}
 
-	private void update_diff_hunks(Ggit.Diff diff, bool preserve_expanded, Gee.HashMap<string, DiffViewFileInfo> infomap, Cancellable? cancellable)
+	/* Shows a binary file through its textconv filter, if it has one.
+	 * Returns false if the file should be shown as binary.
+	 */
+	private bool populate_textconv(DiffViewFile file, Ggit.DiffDelta delta, int maxlines)
 	{
-		var files = new Gee.ArrayList<Gitg.DiffViewFile>();
+		var new_file = delta.get_new_file();
+		var old_file = delta.get_old_file();
 
-		Gitg.DiffViewFile? current_file = null;
-		Ggit.DiffHunk? current_hunk = null;
-		Gee.ArrayList<Ggit.DiffLine>? current_lines = null;
-		var current_is_binary = false;
+		if (!TextConv.has_textconv_command(repository, old_file) && !TextConv.has_textconv_command(repository, new_file))
+		{
+			return false;
+		}
 
-		var maxlines = 0;
+		try
+		{
+			uint8[] n_textconv = TextConv.get_textconv_content(repository, new_file);
+			uint8[] o_textconv = TextConv.get_textconv_content(repository, old_file);
 
-		Anon add_hunk = () => {
-			if (current_hunk != null)
-			{
-				current_file.add_hunk(current_hunk, current_lines);
+			var opts = new Ggit.DiffOptions();
+			opts.flags = Ggit.DiffOption.INCLUDE_UNTRACKED |
+			             Ggit.DiffOption.IGNORE_WHITESPACE |
+			             Ggit.DiffOption.DISABLE_PATHSPEC_MATCH |
+			             Ggit.DiffOption.RECURSE_UNTRACKED_DIRS;
+			opts.n_context_lines = 3;
+			opts.n_interhunk_lines = 3;
 
-				current_lines = null;
-				current_hunk = null;
-			}
-		};
+			var bdiff = new Ggit.Diff.buffers(o_textconv, old_file.get_path(), n_textconv, new_file.get_path(), opts);
 
-		Anon add_file = () => {
-			add_hunk();
+			add_text_renderer(file, maxlines);
 
-			if (current_file != null)
+			if (bdiff.get_num_deltas() > 0)
 			{
-				current_file.show();
-
-				files.add(current_file);
-
-				current_file = null;
+				add_patch_hunks(file, new Ggit.Patch.from_diff(bdiff, 0));
 			}
-		};
-
-		try
+		}
+		catch (Error error)
 		{
-			diff.foreach(
-				(delta, progress) => {
-					if (cancellable != null && cancellable.is_cancelled())
-					{
-						return 1;
-					}
+			stderr.printf (@"Error: $(error.message)\n");
+		}
 
-					add_file();
+		return true;
+	}
 
-					DiffViewFileInfo? info = null;
-					var deltakey = key_for_delta(delta);
+	private void populate_file(DiffViewFile file,
+	                           Ggit.Diff    diff,
+	                           int          idx,
+	                           bool         is_binary,
+	                           int          maxlines)
+	{
+		var info = file.info;
 
-					if (infomap.has_key(deltakey))
-					{
-						info = infomap[deltakey];
-					}
-					else
-					{
-						info = new DiffViewFileInfo(repository, delta, new_is_workdir);
-					}
+		is_binary = is_binary || is_known_binary(info);
 
-					current_is_binary = ((delta.get_flags() & Ggit.DiffFlag.BINARY) != 0);
+		string? mime_type_for_image = mime_type_for_delta(info.delta, info);
 
-					// List of known binary file types that may be wrongly classified by
-					// libgit2 because it does not contain any null bytes in the first N
-					// bytes. E.g. PDF
-					var known_binary_files_types = new string[] {"application/pdf"};
+		bool as_image = mime_type_for_image != null && s_image_mime_types.contains(mime_type_for_image);
+		bool as_text = ContentType.is_mime_type(mime_type_for_image, "text/plain");
 
-					// Ignore binary based on content type
-					if (info != null && info.new_file_content_type in known_binary_files_types)
-					{
-						current_is_binary = true;
-					}
+		if (!as_image && !is_binary && !as_text)
+		{
+			//force diff as text if no other diff is possible
+			as_text = true;
+		}
 
-					string? mime_type_for_image = null;
+		// Binary files with a textconv filter are shown as the text diff of
+		// the filtered content only
+		if (is_binary && populate_textconv(file, file.info.delta, maxlines))
+		{
+			return;
+		}
 
-					if (info == null || info.new_file_content_type == null)
-					{
-						// Guess mime type from old file name in the case of a deleted file
-						var oldpath = delta.get_old_file().get_path();
+		if (as_image)
+		{
+			file.add_image_renderer();
+		}
 
-						if (oldpath != null)
-						{
-							bool uncertain;
-							var ctype = ContentType.guess(Path.get_basename(oldpath), null, out uncertain);
+		if (as_text)
+		{
+			add_text_renderer(file, maxlines);
 
-							if (ctype != null)
-							{
-								mime_type_for_image = ContentType.get_mime_type(ctype);
-							}
-						}
-					}
-					else
-					{
-						mime_type_for_image = ContentType.get_mime_type(info.new_file_content_type);
-					}
+			try
+			{
+				add_patch_hunks(file, new Ggit.Patch.from_diff(diff, idx));
+			}
+			catch (Error e)
+			{
+				stderr.printf("Failed to get patch: %s\n", e.message);
+			}
+		}
 
-					bool can_diff_as_image = mime_type_for_image != null && s_image_mime_types.contains(mime_type_for_image);
-					bool can_diff_as_text = ContentType.is_mime_type(mime_type_for_image, "text/plain");
+		if (is_binary)
+		{
+			file.add_binary_renderer();
+		}
+	}
 
-					current_file = new Gitg.DiffViewFile(info);
+	/* Creates the file widgets, but not their content. The content of a file
+	 * is only created once it is expanded and scrolled into view, see
+	 * populate_visible.
+	 */
+	private void update_diff_hunks(Ggit.Diff diff, bool preserve_expanded, DiffViewFileInfo[] infos, Cancellable? cancellable)
+	{
+		var span = Trace.begin();
+		var files = new Gee.ArrayList<Gitg.DiffViewFile>();
+		var placeholders = new Gee.ArrayList<int>();
+		var maxlines = 0;
 
-					if (can_diff_as_image)
-					{
-						current_file.add_image_renderer();
-					}
-					if (!can_diff_as_image && !current_is_binary && !can_diff_as_text)
-					{
-							//force diff as text if no other diff is possible
-							can_diff_as_text = true;
-					}
-					if (can_diff_as_text)
-					{
-						current_file.add_text_renderer(handle_selection);
-						var renderer_list = current_file.renderer_list;
-						foreach (DiffViewFileRenderer renderer in renderer_list)
-						{
-							var renderer_text = renderer as DiffViewFileRendererTextable;
-							if (renderer_text != null)
-							{
-								bind_property("highlight", renderer_text, "highlight", BindingFlags.SYNC_CREATE);
-								bind_property("wrap-lines", renderer_text, "wrap-lines", BindingFlags.DEFAULT | BindingFlags.SYNC_CREATE);
-								bind_property("tab-width", renderer_text, "tab-width", BindingFlags.DEFAULT | BindingFlags.SYNC_CREATE);
-								renderer_text.maxlines = maxlines;
-								renderer_text.notify["has-selection"].connect(on_selection_changed);
-							}
-						}
-						on_selection_changed();
-					}
-					if (current_is_binary)
-					{
-						try {
-							var new_file = delta.get_new_file();
-							var old_file = delta.get_old_file();
-
-							if (TextConv.has_textconv_command(repository, old_file) || TextConv.has_textconv_command(repository, new_file))
-							{
-								uint8[] n_textconv = TextConv.get_textconv_content(repository, new_file);
-								uint8[] o_textconv = TextConv.get_textconv_content(repository, old_file);
-
-								current_is_binary = false;
-								var opts = new Ggit.DiffOptions();
-								opts.flags = Ggit.DiffOption.INCLUDE_UNTRACKED |
-											Ggit.DiffOption.IGNORE_WHITESPACE |
-											Ggit.DiffOption.DISABLE_PATHSPEC_MATCH |
-											Ggit.DiffOption.RECURSE_UNTRACKED_DIRS;
-								opts.n_context_lines = 3;
-								opts.n_interhunk_lines = 3;
-
-
-								var bdiff = new Ggit.Diff.buffers(o_textconv, old_file.get_path(), n_textconv, new_file.get_path(), opts);
-								bdiff.foreach(
-									(delta, progress) => {
-											if (cancellable != null && cancellable.is_cancelled())
-											{
-												return 1;
-											}
-											deltakey = key_for_delta(delta);
-
-											if (infomap.has_key(deltakey))
-											{
-												info = infomap[deltakey];
-											}
-											else
-											{
-												info = new DiffViewFileInfo(repository, delta, new_is_workdir);
-											}
-												current_file = new Gitg.DiffViewFile(info);
-												current_file.add_text_renderer(handle_selection);
-												return 0;
-											},
-									(delta, binary) => {
-											if (cancellable != null && cancellable.is_cancelled())
-											{
-												return 1;
-											}
-											return 0;
-									},
-									(delta, hunk) => {
-											if (cancellable != null && cancellable.is_cancelled())
-											{
-												return 1;
-											}
-											if (!current_is_binary)
-											{
-												maxlines = int.max(maxlines, hunk.get_old_start() + hunk.get_old_lines());
-												maxlines = int.max(maxlines, hunk.get_new_start() + hunk.get_new_lines());
-
-												add_hunk();
-
-												current_hunk = hunk;
-												current_lines = new Gee.ArrayList<Ggit.DiffLine>();
-											}
-
-											return 0;
-									},
-									(delta, hunk, line) => {
-											if (cancellable != null && cancellable.is_cancelled())
-											{
-												return 1;
-											}
-											if (!current_is_binary)
-											{
-												current_lines.add(line);
-											}
-											return 0;
-									}
-								);
-								add_hunk();
-								add_file();
-							}
-						} catch (Error error) {
-							stderr.printf (@"Error: $(error.message)\n");
-						}
-						if (current_is_binary)
-							current_file.add_binary_renderer();
-					}
-					return 0;
-				},
+		for (var i = 0; i < diff.get_num_deltas(); i++)
+		{
+			if (cancellable != null && cancellable.is_cancelled())
+			{
+				return;
+			}
 
-				(delta, binary) => {
-					// FIXME: do we want to handle binary data?
-					if (cancellable != null && cancellable.is_cancelled())
-					{
-						return 1;
-					}
+			// Generating the patch loads the content of the file, which is
+			// when libgit2 determines whether the file is binary. Only the
+			// statistics of the patch are kept, its hunks are generated
+			// again when the file is populated.
+			Ggit.Patch? patch = null;
 
-					return 0;
-				},
+			try
+			{
+				patch = new Ggit.Patch.from_diff(diff, i);
+			}
+			catch (Error e)
+			{
+				stderr.printf("Failed to get patch: %s\n", e.message);
+			}
 
-				(delta, hunk) => {
-					if (cancellable != null && cancellable.is_cancelled())
-					{
-						return 1;
-					}
+			// How the file is shown depends on its content type as well,
+			// which is only known once its info has been queried
+			var delta = diff.get_delta(i);
+			var is_binary = (delta.get_flags() & Ggit.DiffFlag.BINARY) != 0;
 
-					if (!current_is_binary)
-					{
-						maxlines = int.max(maxlines, hunk.get_old_start() + hunk.get_old_lines());
-						maxlines = int.max(maxlines, hunk.get_new_start() + hunk.get_new_lines());
+			var file = new Gitg.DiffViewFile(infos[i]);
+			var lines = 0;
 
-						add_hunk();
+			if (!is_binary && patch != null)
+			{
+				try
+				{
+					size_t context;
+					size_t added;
+					size_t removed;
 
-						current_hunk = hunk;
-						current_lines = new Gee.ArrayList<Ggit.DiffLine>();
-					}
+					patch.get_line_stats(out context, out added, out removed);
+					file.set_stats((uint)added, (uint)removed);
 
-					return 0;
-				},
+					lines = (int)(context + added + removed + patch.get_num_hunks());
 
-				(delta, hunk, line) => {
-					if (cancellable != null && cancellable.is_cancelled())
+					for (size_t h = 0; h < patch.get_num_hunks(); h++)
 					{
-						return 1;
-					}
+						var hunk = patch.get_hunk(h);
 
-					if (!current_is_binary)
-					{
-						current_lines.add(line);
+						maxlines = int.max(maxlines, hunk.get_old_start() + hunk.get_old_lines());
+						maxlines = int.max(maxlines, hunk.get_new_start() + hunk.get_new_lines());
 					}
+				} catch {}
+			}
 
-					return 0;
-				}
-			);
-		} catch {}
+			// Files are populated after all files have been added, by which
+			// time maxlines is final
+			var idx = i;
+
+			file.populate.connect((f) => {
+				populate_file(f, diff, idx, is_binary, maxlines);
+			});
 
-		add_hunk();
-		add_file();
+			file.show();
+
+			files.add(file);
+			placeholders.add(lines);
+		}
 
 		var file_widgets = d_grid_files.get_children();
 		var was_expanded = new Gee.HashSet<string>();
@@ -1024,6 +1019,7 @@ public class Gitg.DiffView : Gtk.Grid
 			var path = primary_path(file.info.delta);
 
 			file.expanded = d_commit_details.expanded || (path != null && was_expanded.contains(path));
+			file.set_placeholder_lines(placeholders[i]);
 
 			if (i == files.size - 1)
 			{
@@ -1033,6 +1029,79 @@ public class Gitg.DiffView : Gtk.Grid
 			d_grid_files.add(file);
 
 			file.notify["expanded"].connect(auto_update_expanded);
+			file.notify["expanded"].connect(queue_populate_visible);
+		}
+
+		queue_populate_visible();
+
+		Trace.end_detail(span, "DiffView.update_diff_hunks", "%d files", files.size);
+	}
+
+	private void queue_populate_visible()
+	{
+		if (d_populate_visible_id == 0)
+		{
+			d_populate_visible_id = Idle.add(() => {
+				d_populate_visible_id = 0;
+				populate_visible();
+				return false;
+			});
+		}
+	}
+
+	/* Populates the expanded files which are in view (or close to it), and
+	 * releases the files which are far out of view. Files in view whose info
+	 * is still being queried are moved to the front of the query queue.
+	 */
+	private void populate_visible()
+	{
+		var adj = d_scrolledwindow.get_vadjustment();
+		var page = adj.get_page_size();
+
+		var top = adj.get_value() - page;
+		var bottom = adj.get_value() + page * 2;
+
+		var release_top = adj.get_value() - page * RELEASE_PAGES;
+		var release_bottom = adj.get_value() + page * (RELEASE_PAGES + 1);
+
+		var content = ((Gtk.Bin)d_scrolledwindow.get_child()).get_child();
+		var waiting = new DiffViewFileInfo[0];
+
+		foreach (var child in d_grid_files.get_children())
+		{
+			var file = (DiffViewFile)child;
+			int x, y;
+
+			if (!file.translate_coordinates(content, 0, 0, out x, out y))
+			{
+				continue;
+			}
+
+			var height = file.get_allocated_height();
+
+			if (!file.populated)
+			{
+				if (file.expanded && y + height >= top && y <= bottom)
+				{
+					if (file.info.queried)
+					{
+						file.ensure_populated();
+					}
+					else
+					{
+						waiting += file.info;
+					}
+				}
+			}
+			else if ((y + height < release_top || y > release_bottom) && !file.has_selection())
+			{
+				file.release();
+			}
+		}
+
+		if (waiting.length > 0 && d_info_queue != null)
+		{
+			d_info_queue.prioritize(waiting);
 		}
 	}
 
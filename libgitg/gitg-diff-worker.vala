@@ -0,0 +1,168 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Computes diffs on a background thread, one at a time and in the order
+ * they were requested. A diff which is cancelled before it starts is not
+ * computed at all, and a cancelled run returns right away without waiting
+ * for the diff being computed. When moving quickly through the history,
+ * only the diff being computed and the latest one are ever worked on.
+ */
+public class DiffWorker : Object
+{
+	public delegate Ggit.Diff? DiffFunc(Cancellable? cancellable) throws Error;
+
+	private class Job
+	{
+		public DiffFunc func;
+		public Cancellable? cancellable;
+		public SourceFunc? callback;
+
+		public Ggit.Diff? diff;
+		public Error? error;
+
+		public Job(owned DiffFunc func, Cancellable? cancellable)
+		{
+			this.func = (owned)func;
+			this.cancellable = cancellable;
+		}
+
+		public void run()
+		{
+			if (cancellable == null || !cancellable.is_cancelled())
+			{
+				try
+				{
+					diff = func(cancellable);
+				}
+				catch (Error e)
+				{
+					error = e;
+				}
+			}
+
+			finish();
+		}
+
+		// Resumes the waiting run, either when done or when cancelled,
+		// whichever comes first
+		public void finish()
+		{
+			lock (callback)
+			{
+				if (callback != null)
+				{
+					Idle.add((owned)callback);
+					callback = null;
+				}
+			}
+		}
+	}
+
+	private static DiffWorker? s_default;
+
+	private ThreadPool<Job>? d_pool;
+
+	public static DiffWorker get_default()
+	{
+		if (s_default == null)
+		{
+			s_default = new DiffWorker();
+		}
+
+		return s_default;
+	}
+
+	public DiffWorker()
+	{
+		try
+		{
+			d_pool = new ThreadPool<Job>.with_owned_data((job) => {
+				job.run();
+			}, 1, false);
+		}
+		catch (ThreadError e)
+		{
+			stderr.printf("Failed to start diff thread: %s\n", e.message);
+			d_pool = null;
+		}
+	}
+
+	/**
+	 * Compute a diff on the diff thread.
+	 *
+	 * @param func computes the diff, it should check @cancellable between
+	 *             expensive steps.
+	 * @param cancellable a cancellable.
+	 *
+	 * @return the diff, or null if cancelled.
+	 */
+	public async Ggit.Diff? run(owned DiffFunc func, Cancellable? cancellable = null) throws Error
+	{
+		if (cancellable != null && cancellable.is_cancelled())
+		{
+			return null;
+		}
+
+		var job = new Job((owned)func, cancellable);
+
+		if (d_pool == null)
+		{
+			return job.func(cancellable);
+		}
+
+		job.callback = run.callback;
+
+		ulong cancelled_id = 0;
+
+		if (cancellable != null)
+		{
+			cancelled_id = cancellable.connect(() => {
+				job.finish();
+			});
+		}
+
+		d_pool.add(job);
+		yield;
+
+		if (cancellable != null)
+		{
+			cancellable.disconnect(cancelled_id);
+
+			if (cancellable.is_cancelled())
+			{
+				return null;
+			}
+		}
+
+		// Resumed by the job itself, its result is set
+		if (job.error != null)
+		{
+			throw job.error;
+		}
+
+		return job.diff;
+	}
+}
+
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,212 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* A process wide cache of syntax highlighted buffers, shared by all diff
+ * renderers. Buffers are kept in least recently used order and evicted
+ * once their total size exceeds the budget. Concurrent lookups of a buffer
+ * which is still being loaded wait for that load instead of loading it
+ * again.
+ */
+public class HighlightCache : Object
+{
+	private const size_t DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+	private class Entry
+	{
+		public Gtk.SourceBuffer buffer;
+		public size_t cost;
+	}
+
+	private class Waiter
+	{
+		public SourceFunc callback;
+
+		public Waiter(owned SourceFunc callback)
+		{
+			this.callback = (owned)callback;
+		}
+	}
+
+	private static HighlightCache? s_default;
+
+	private Gee.HashMap<string, Entry> d_entries;
+	private Gee.LinkedList<string> d_order;
+	private Gee.HashMap<string, Gee.ArrayList<Waiter>> d_loading;
+	private size_t d_size;
+	private size_t d_budget;
+
+	public static HighlightCache get_default()
+	{
+		if (s_default == null)
+		{
+			s_default = new HighlightCache();
+		}
+
+		return s_default;
+	}
+
+	construct
+	{
+		d_entries = new Gee.HashMap<string, Entry>();
+		d_order = new Gee.LinkedList<string>();
+		d_loading = new Gee.HashMap<string, Gee.ArrayList<Waiter>>();
+		d_budget = DEFAULT_BUDGET;
+	}
+
+	/* The approximate memory used by the cached buffers, in bytes. */
+	public size_t size
+	{
+		get { return d_size; }
+	}
+
+	public size_t budget
+	{
+		get { return d_budget; }
+		set
+		{
+			d_budget = value;
+			evict();
+		}
+	}
+
+	private static string key_suffix(Gtk.SourceLanguage? language, Gtk.SourceStyleScheme? scheme)
+	{
+		return "%s:%s".printf(language != null ? language.id : "",
+		                      scheme != null ? scheme.id : "");
+	}
+
+	public static string key_for_blob(Ggit.OId id, Gtk.SourceLanguage? language, Gtk.SourceStyleScheme? scheme)
+	{
+		return "blob:%s:%s".printf(id.to_string(), key_suffix(language, scheme));
+	}
+
+	public static string key_for_content(Bytes content, Gtk.SourceLanguage? language, Gtk.SourceStyleScheme? scheme)
+	{
+		var checksum = Checksum.compute_for_bytes(ChecksumType.SHA1, content);
+		return "content:%s:%s".printf(checksum, key_suffix(language, scheme));
+	}
+
+	/* Gets the buffer of @key. If it is not cached, @load is set to true
+	 * and the caller is expected to load the buffer and pass it to add, or
+	 * call cancel_load if that failed. Lookups of @key from others wait
+	 * until then.
+	 */
+	public async Gtk.SourceBuffer? lookup(string key, out bool load)
+	{
+		load = false;
+
+		while (true)
+		{
+			var entry = d_entries[key];
+
+			if (entry != null)
+			{
+				d_order.remove(key);
+				d_order.offer_tail(key);
+
+				return entry.buffer;
+			}
+
+			var waiters = d_loading[key];
+
+			if (waiters == null)
+			{
+				d_loading[key] = new Gee.ArrayList<Waiter>();
+				load = true;
+
+				return null;
+			}
+
+			waiters.add(new Waiter(lookup.callback));
+			yield;
+		}
+	}
+
+	/* Adds the loaded @buffer of @key and wakes up the lookups waiting for
+	 * it.
+	 */
+	public void add(string key, Gtk.SourceBuffer buffer)
+	{
+		if (!d_entries.has_key(key))
+		{
+			// A rough estimate of the text and the line and tag data of the
+			// buffer
+			var cost = (size_t)buffer.get_char_count() * 4 + (size_t)buffer.get_line_count() * 64;
+
+			d_entries[key] = new Entry() { buffer = buffer, cost = cost };
+			d_order.offer_tail(key);
+			d_size += cost;
+
+			evict();
+		}
+
+		wake(key);
+	}
+
+	/* Gives up loading @key, one of the waiting lookups will load it
+	 * instead.
+	 */
+	public void cancel_load(string key)
+	{
+		wake(key);
+	}
+
+	private void wake(string key)
+	{
+		Gee.ArrayList<Waiter> waiters;
+
+		if (!d_loading.unset(key, out waiters))
+		{
+			return;
+		}
+
+		foreach (var waiter in waiters)
+		{
+			Idle.add((owned)waiter.callback);
+		}
+	}
+
+	private void evict()
+	{
+		// Keep the most recent buffer, even if it exceeds the budget by
+		// itself
+		while (d_size > d_budget && d_order.size > 1)
+		{
+			var key = d_order.poll_head();
+			var entry = d_entries[key];
+
+			d_entries.unset(key);
+			d_size -= entry.cost;
+		}
+	}
+
+	public void clear()
+	{
+		d_entries.clear();
+		d_order.clear();
+		d_size = 0;
+	}
+}
+
+}
+
+// ex:set ts=4 noet
@@ -24,6 +24,11 @@ namespace Gitg
 		private const int margin = 2;
 		private const int padding = 6;
 
+		// Rendered labels, keyed by the label and everything affecting its
+		// style, shared by all label renderers
+		private const uint MAX_LABEL_SURFACES = 512;
+		private static Gee.HashMap<string, Cairo.ImageSurface>? s_label_surfaces;
+
 		private static string label_text(Ref r)
 		{
 			var escaped = Markup.escape_text(r.parsed_name.shortname);
@@ -168,30 +173,105 @@ namespace Gitg
 				pos = area.x + area.width - margin - 0.5;
 			}
 
-			context.save();
-			context.set_line_width(1.0);
-
 			var ctx = widget.get_pango_context();
 			var layout = new Pango.Layout(ctx);
 
 			layout.set_font_description(font);
 
+			var scale = widget.get_scale_factor();
+			var style_key = label_style_key(widget, font, scale);
+
 			foreach (Ref r in labels)
 			{
-				var w = render_label(widget,
-				                     context,
-				                     layout,
-				                     r,
-				                     (int)pos,
-				                     area.y,
-				                     area.height,
-				                     true);
-
-				var o = w + padding * 2 + margin;
+				var surface = label_surface(widget,
+				                            layout,
+				                            style_key,
+				                            r,
+				                            0,
+				                            area.height,
+				                            scale);
+
+				var w = surface.get_width() / scale;
+				var x = rtl ? (int)pos - w : (int)pos;
+
+				context.set_source_surface(surface, x, area.y);
+				context.paint();
+
+				var o = w + margin;
 				pos += rtl ? -o : o;
 			}
+		}
 
-			context.restore();
+		private static string label_style_key(Gtk.Widget            widget,
+		                                      Pango.FontDescription font,
+		                                      int                   scale)
+		{
+			var settings = widget.get_settings();
+
+			return "%s:%s:%d:%d:%d".printf(font.to_string(),
+			                               settings.gtk_theme_name,
+			                               settings.gtk_application_prefer_dark_theme ? 1 : 0,
+			                               (int)widget.get_style_context().get_state(),
+			                               scale);
+		}
+
+		private static Cairo.ImageSurface label_surface(Gtk.Widget   widget,
+		                                                Pango.Layout layout,
+		                                                string       style_key,
+		                                                Ref          r,
+		                                                int          minwidth,
+		                                                int          height,
+		                                                int          scale)
+		{
+			if (s_label_surfaces == null)
+			{
+				s_label_surfaces = new Gee.HashMap<string, Cairo.ImageSurface>();
+			}
+
+			var key = "%s:%d:%s:%d:%d".printf(style_key,
+			                                  (int)r.parsed_name.rtype,
+			                                  r.parsed_name.shortname,
+			                                  minwidth,
+			                                  height);
+
+			var surface = s_label_surfaces[key];
+
+			if (surface != null)
+			{
+				return surface;
+			}
+
+			int width = int.max(get_label_width(layout, r), minwidth);
+
+			surface = new Cairo.ImageSurface(Cairo.Format.ARGB32,
+			                                 width * scale,
+			                                 height * scale);
+
+			surface.set_device_scale(scale, scale);
+
+			var context = new Cairo.Context(surface);
+			context.set_line_width(1.0);
+
+			// Labels are rendered left to right on the surface, also for
+			// right to left widgets
+			var rtl = (widget.get_style_context().get_state() & Gtk.StateFlags.DIR_RTL) != 0;
+
+			render_label(widget,
+			             context,
+			             layout,
+			             r,
+			             rtl ? width : 0,
+			             0,
+			             height,
+			             true);
+
+			if (s_label_surfaces.size >= MAX_LABEL_SURFACES)
+			{
+				s_label_surfaces.clear();
+			}
+
+			s_label_surfaces[key] = surface;
+			return surface;
 		}
 
 		public static Ref? get_ref_at_pos(Gtk.Widget            widget,
@@ -233,33 +313,6 @@ namespace Gitg
 			return ret;
 		}
 
-		private static uchar convert_color_channel(uchar color,
-		                                           uchar alpha)
-		{
-			return (uchar)((alpha != 0) ? (color / (alpha / 255.0)) : 0);
-		}
-
-		private static void convert_bgra_to_rgba(uchar[] src,
-		                                         uchar[] dst,
-		                                         int     width,
-		                                         int     height)
-		{
-			int i = 0;
-
-			for (int y = 0; y < height; ++y)
-			{
-				for (int x = 0; x < width; ++x)
-				{
-					dst[i] = convert_color_channel(src[i + 2], src[i + 3]);
-					dst[i + 1] = convert_color_channel(src[i + 1], src[i + 3]);
-					dst[i + 2] = convert_color_channel(src[i], src[i + 3]);
-					dst[i + 3] = src[i + 3];
-
-					i += 4;
-				}
-			}
-		}
-
 		public static Gdk.Pixbuf render_ref(Gtk.Widget            widget,
 		                                    Pango.FontDescription font,
 		                                    Ref                   r,
@@ -271,28 +324,19 @@ namespace Gitg
 
 			layout.set_font_description(font);
 
-			int width = int.max(get_label_width(layout, r), minwidth);
-
-			var surface = new Cairo.ImageSurface(Cairo.Format.ARGB32,
-			                                     width + 2,
-			                                     height + 2);
-
-			var context = new Cairo.Context(surface);
-			context.set_line_width(1);
-
-			render_label(widget, context, layout, r, 1, 1, height, false);
-			var data = surface.get_data();
-
-			Gdk.Pixbuf ret = new Gdk.Pixbuf(Gdk.Colorspace.RGB,
-			                                true,
-			                                8,
-			                                width + 2,
-			                                height + 2);
-
-			var pixdata = ret.get_pixels();
-			convert_bgra_to_rgba(data, pixdata, width + 2, height + 2);
-
-			return ret;
+			var surface = label_surface(widget,
+			                            layout,
+			                            label_style_key(widget, font, 1),
+			                            r,
+			                            minwidth,
+			                            height,
+			                            1);
+
+			return Gdk.pixbuf_get_from_surface(surface,
+			                                   0,
+			                                   0,
+			                                   surface.get_width(),
+			                                   surface.get_height());
 		}
 	}
 }
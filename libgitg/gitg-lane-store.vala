@@ -0,0 +1,168 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* A lane of a commit in packed form. The merge indices of the lane are
+ * stored in the merge index array of the store, @nfrom of them starting
+ * at @from.
+ */
+public struct LaneRecord
+{
+	public uint8 color;
+	public uint8 tag;
+	public uint16 nfrom;
+	public uint32 from;
+}
+
+/* Scratch space used to pack the lanes of commits which are still being
+ * laid out, see Commit.get_lane_records.
+ */
+public class LaneBuffer : Object
+{
+	public LaneRecord[] lanes;
+	public uint16[] from;
+
+	public LaneBuffer()
+	{
+		lanes = new LaneRecord[16];
+		from = new uint16[16];
+	}
+}
+
+/* Packed storage for the lanes of commits which are no longer being laid
+ * out. The lanes of all commits of a walk are appended to a few large
+ * chunks instead of being kept as lists of lane objects per commit. Chunks
+ * are never reallocated once created, so the lanes of a commit can be read
+ * in place while other commits are being appended.
+ */
+public class LaneStore : Object
+{
+	private const uint CHUNK_SIZE = 16384;
+
+	private class Chunk
+	{
+		public LaneRecord[] lanes;
+		public uint16[] from;
+		public uint n_lanes;
+		public uint n_from;
+
+		public Chunk(uint lanes_size, uint from_size)
+		{
+			lanes = new LaneRecord[lanes_size];
+			from = new uint16[from_size];
+		}
+
+		public bool has_room(uint nlanes, uint nfrom)
+		{
+			return n_lanes + nlanes <= lanes.length &&
+			       n_from + nfrom <= from.length;
+		}
+	}
+
+	private Chunk[] d_chunks;
+
+	public LaneStore()
+	{
+		d_chunks = new Chunk[0];
+	}
+
+	/* Appends @lanes to the store. The lanes can be retrieved again using
+	 * the returned @chunk and @first.
+	 */
+	public void append(SList<Lane> lanes, out uint chunk, out uint first)
+	{
+		uint nlanes = 0;
+		uint nfrom = 0;
+
+		foreach (unowned Lane lane in lanes)
+		{
+			nlanes++;
+			nfrom += lane.from.length();
+		}
+
+		Chunk? c = null;
+
+		lock(d_chunks)
+		{
+			if (d_chunks.length != 0)
+			{
+				c = d_chunks[d_chunks.length - 1];
+			}
+
+			if (c == null || !c.has_room(nlanes, nfrom))
+			{
+				c = new Chunk(uint.max(CHUNK_SIZE, nlanes),
+				              uint.max(CHUNK_SIZE * 2, nfrom));
+
+				d_chunks += c;
+			}
+
+			chunk = d_chunks.length - 1;
+		}
+
+		// Only the walk appends lanes, so the chunk can be filled without
+		// holding the lock. Readers never look past the lanes they were
+		// handed out.
+		first = c.n_lanes;
+
+		foreach (unowned Lane lane in lanes)
+		{
+			var rec = LaneRecord() {
+				color = (uint8)lane.color.idx,
+				tag = (uint8)lane.tag,
+				nfrom = 0,
+				from = c.n_from
+			};
+
+			foreach (var from in lane.from)
+			{
+				c.from[c.n_from++] = (uint16)from;
+				rec.nfrom++;
+			}
+
+			c.lanes[c.n_lanes++] = rec;
+		}
+	}
+
+	/* Gets the @count lanes starting at @first in @chunk. The merge
+	 * indices of the lanes refer into @from. Both arrays stay valid for
+	 * as long as the store is alive.
+	 */
+	public unowned LaneRecord[] get_lanes(uint                chunk,
+	                                      uint                first,
+	                                      uint                count,
+	                                      out unowned uint16[] from)
+	{
+		unowned Chunk c;
+
+		lock(d_chunks)
+		{
+			c = d_chunks[chunk];
+		}
+
+		from = c.from;
+		return c.lanes[first:first + count];
+	}
+}
+
+}
+
+// ex:set ts=4 noet
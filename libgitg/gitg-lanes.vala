@@ -26,9 +26,15 @@ public class Lanes : Object
 	public int inactive_collapse { get; set; default = 10; }
 	public int inactive_gap { get; set; default = 10; }
 	public bool inactive_enabled { get; set; default = true; }
-	public Gee.LinkedList<Commit> miss_commits {get; set; }
 
-	private SList<weak Commit> d_previous;
+	private SList<Commit> d_previous;
+	private LaneStore d_store;
+
+	// Commits for which no lane was found yet, by id. A missed commit can
+	// be laid out once one of its children has been.
+	private Gee.HashMap<Ggit.OId, Miss> d_misses;
+	private Gee.ArrayQueue<Miss> d_unmissed;
+	private uint d_miss_seq;
 	private Gee.LinkedList<LaneContainer> d_lanes;
 	private HashTable<Ggit.OId, CollapsedLane> d_collapsed;
 	private Gee.HashSet<Ggit.OId>? d_roots;
@@ -94,6 +100,19 @@ public class Lanes : Object
 		}
 	}
 
+	class Miss
+	{
+		public Commit commit;
+		public uint seq;
+		public bool queued;
+
+		public Miss(Commit commit, uint seq)
+		{
+			this.commit = commit;
+			this.seq = seq;
+		}
+	}
+
 	[Compact]
 	class CollapsedLane
 	{
@@ -115,17 +134,25 @@ public class Lanes : Object
 		d_collapsed = new HashTable<Ggit.OId, CollapsedLane>(Ggit.OId.hash,
 		                                                     Ggit.OId.equal);
 
-		var settings = new Settings(Gitg.Config.APPLICATION_ID + ".preferences.history");
+		var schema_id = Gitg.Config.APPLICATION_ID + ".preferences.history";
+		var source = SettingsSchemaSource.get_default();
+
+		// Allow lanes to be used without installed schemas, for instance
+		// from tests, using the default settings
+		if (source != null && source.lookup(schema_id, true) != null)
+		{
+			var settings = new Settings(schema_id);
 
-		settings.bind("collapse-inactive-lanes-enabled",
-		              this,
-		              "inactive-enabled",
-		              SettingsBindFlags.GET | SettingsBindFlags.SET);
+			settings.bind("collapse-inactive-lanes-enabled",
+			              this,
+			              "inactive-enabled",
+			              SettingsBindFlags.GET | SettingsBindFlags.SET);
 
-		settings.bind("collapse-inactive-lanes",
-		              this,
-		              "inactive-collapse",
-		              SettingsBindFlags.GET | SettingsBindFlags.SET);
+			settings.bind("collapse-inactive-lanes",
+			              this,
+			              "inactive-collapse",
+			              SettingsBindFlags.GET | SettingsBindFlags.SET);
+		}
 
 		reset();
 	}
@@ -134,9 +161,12 @@ public class Lanes : Object
 	                  Gee.HashSet<Ggit.OId>? roots    = null)
 	{
 		d_lanes = new Gee.LinkedList<LaneContainer>();
-		miss_commits = new Gee.LinkedList<Commit>();
 		d_roots = roots;
 
+		d_misses = new Gee.HashMap<Ggit.OId, Miss>((i) => { return i.hash(); }, (a, b) => { return a.equal(b); });
+		d_unmissed = new Gee.ArrayQueue<Miss>();
+		d_miss_seq = 0;
+
 		Color.reset();
 
 		if (reserved != null)
@@ -152,7 +182,29 @@ public class Lanes : Object
 		}
 
 		d_collapsed.remove_all();
-		d_previous = new SList<weak Commit>();
+		d_previous = new SList<Commit>();
+		d_store = new LaneStore();
+	}
+
+	/* The store in which the lanes of commits are frozen once they can no
+	 * longer change.
+	 */
+	public LaneStore store
+	{
+		get { return d_store; }
+	}
+
+	/* Freezes the lanes of the commits which are still being tracked. Call
+	 * this when no more commits are going to be laid out.
+	 */
+	public void finish()
+	{
+		foreach (var commit in d_previous)
+		{
+			commit.freeze_lanes(d_store);
+		}
+
+		d_previous = new SList<Commit>();
 	}
 
 	public bool next(Commit           next,
@@ -160,6 +212,7 @@ public class Lanes : Object
 	                 out int         nextpos,
 	                 bool save_miss = false)
 	{
+		var span = Trace.begin();
 		var myoid = next.get_id();
 
 		if (inactive_enabled)
@@ -173,14 +226,19 @@ public class Lanes : Object
 		if (mylane == null && d_roots != null && !d_roots.contains(myoid))
 		{
 			lanes = null;
-			if (save_miss) {
+			if (save_miss && !d_misses.has_key(myoid)) {
 				debug ("saving miss %s %s", next.get_id().to_string(), next.get_id().to_string());
-				miss_commits.add(next);
+				d_misses.set(myoid, new Miss(next, d_miss_seq++));
 			}
 
 			return false;
 		}
 
+		if (d_misses.size != 0)
+		{
+			d_misses.unset(myoid);
+		}
+
 		if (mylane == null)
 		{
 			// there is no lane reserved for this commit, add a new lane
@@ -214,9 +272,133 @@ public class Lanes : Object
 		lanes = lanes_list();
 		prepare_lanes(next, nextpos, hidden);
 
+		// Laying out a commit takes microseconds, only the slow ones are
+		// worth recording
+		Trace.end_slow(span, "Lanes.next", 100);
+
 		return !hidden;
 	}
 
+	/* Gets the next missed commit which may now be laid out, because a
+	 * lane for it has been added since it was missed. Commits are returned
+	 * only once for every time this happens.
+	 */
+	public Commit? next_unmissed()
+	{
+		Miss? miss;
+
+		while ((miss = d_unmissed.poll()) != null)
+		{
+			miss.queued = false;
+
+			if (d_misses.has_key(miss.commit.get_id()))
+			{
+				return miss.commit;
+			}
+		}
+
+		return null;
+	}
+
+	/* The number of missed commits which have not been laid out yet. */
+	public uint num_missed
+	{
+		get { return d_misses.size; }
+	}
+
+	/* The most recently laid out commits, newest first. The lanes of these
+	 * commits can still change when lanes get collapsed or expanded.
+	 */
+	public unowned SList<Commit> get_previous()
+	{
+		return d_previous;
+	}
+
+	/* Digest of everything that determines how the next commits are laid
+	 * out: the settings, the active and collapsed lanes, the commits that
+	 * may still be modified and the pending misses. Laying out the same
+	 * commits from two states with the same digest gives the same result.
+	 */
+	public string state_digest()
+	{
+		var s = new StringBuilder();
+
+		s.append_printf("%d,%d,%d,%d,%u;",
+		                inactive_max,
+		                inactive_collapse,
+		                inactive_gap,
+		                inactive_enabled ? 1 : 0,
+		                Color.current());
+
+		foreach (var container in d_lanes)
+		{
+			s.append_printf("l%s,%s,%d,",
+			                oid_to_string(container.from),
+			                oid_to_string(container.to),
+			                container.inactive);
+
+			append_lane_digest(s, container.lane);
+		}
+
+		var collapsed = new Gee.ArrayList<string>();
+
+		d_collapsed.foreach((id, lane) => {
+			collapsed.add("c%s,%u,%u,%s,%s;".printf(oid_to_string(id),
+			                                        lane.color.idx,
+			                                        lane.index,
+			                                        oid_to_string(lane.from),
+			                                        oid_to_string(lane.to)));
+		});
+
+		collapsed.sort();
+
+		foreach (var c in collapsed)
+		{
+			s.append(c);
+		}
+
+		foreach (unowned Commit commit in d_previous)
+		{
+			s.append_printf("p%s,%u;", commit.get_id().to_string(), commit.mylane);
+
+			foreach (unowned Lane lane in commit.get_lanes())
+			{
+				append_lane_digest(s, lane);
+			}
+		}
+
+		var misses = new Gee.ArrayList<Miss>();
+		misses.add_all(d_misses.values);
+
+		misses.sort((a, b) => {
+			return a.seq < b.seq ? -1 : (a.seq > b.seq ? 1 : 0);
+		});
+
+		foreach (var miss in misses)
+		{
+			s.append_printf("m%s;", miss.commit.get_id().to_string());
+		}
+
+		return Checksum.compute_for_string(ChecksumType.SHA1, s.str);
+	}
+
+	private void append_lane_digest(StringBuilder s, Lane lane)
+	{
+		s.append_printf("%u,%d,%s", lane.color.idx, (int)lane.tag, oid_to_string(lane.boundary_id));
+
+		foreach (var from in lane.from)
+		{
+			s.append_printf(",%d", from);
+		}
+
+		s.append_c(';');
+	}
+
+	private static string oid_to_string(Ggit.OId? id)
+	{
+		return id != null ? id.to_string() : "-";
+	}
+
 	private void prepare_lanes(Commit next, int pos, bool hidden)
 	{
 		var parents = next.get_parents();
@@ -234,6 +416,11 @@ public class Lanes : Object
 			int lnpos;
 			var poid = parents.get_id(i);
 
+			if (d_misses.size != 0)
+			{
+				unmiss(poid);
+			}
+
 			var container = find_lane_by_oid(poid, out lnpos);
 
 			if (container != null)
@@ -315,12 +502,29 @@ public class Lanes : Object
 		// store new commit in track list
 		if (d_previous.length() == inactive_collapse + inactive_gap + 1)
 		{
-			d_previous.delete_link(d_previous.last());
+			unowned SList<Commit> last = d_previous.last();
+			Commit commit = (owned)last.data;
+
+			d_previous.delete_link(last);
+
+			// The lanes of the commit will not be touched anymore
+			commit.freeze_lanes(d_store);
 		}
 
 		d_previous.prepend(next);
 	}
 
+	private void unmiss(Ggit.OId id)
+	{
+		var miss = d_misses.get(id);
+
+		if (miss != null && !miss.queued)
+		{
+			miss.queued = true;
+			d_unmissed.offer(miss);
+		}
+	}
+
 	private void add_collapsed(LaneContainer container,
 	                           int           index)
 	{
@@ -335,7 +539,7 @@ public class Lanes : Object
 	{
 		add_collapsed(container, index);
 
-		unowned SList<weak Commit> item = d_previous;
+		unowned SList<Commit> item = d_previous;
 
 		while (item != null)
 		{
@@ -477,7 +681,7 @@ public class Lanes : Object
 		index = next;
 		uint cnt = 0;
 
-		unowned SList<weak Commit> ptr = d_previous;
+		unowned SList<Commit> ptr = d_previous;
 
 		while (ptr != null)
 		{
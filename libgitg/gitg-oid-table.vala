@@ -0,0 +1,200 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Maps object ids to indices. The ids are stored in raw form in a single
+ * flat array using open addressing (linear probing), so that a table of a
+ * large history does not need an allocation per entry.
+ */
+public class OIdTable : Object
+{
+	public const int RAW_SIZE = 20;
+
+	private const uint MIN_CAPACITY = 1024;
+
+	private uint8[] d_keys;
+
+	// Index + 1 of each slot, 0 for empty slots
+	private uint32[] d_values;
+
+	private uint d_mask;
+	private uint d_size;
+
+	// Whether the raw id can be read from the memory of a Ggit.OId, 1 if
+	// it can, 0 if not and -1 until checked
+	private static int s_raw_direct = -1;
+
+	public OIdTable(uint capacity = MIN_CAPACITY)
+	{
+		uint n = MIN_CAPACITY;
+
+		// Keep the load factor below one half
+		while (n < capacity * 2)
+		{
+			n *= 2;
+		}
+
+		allocate(n);
+	}
+
+	public uint size
+	{
+		get { return d_size; }
+	}
+
+	private void allocate(uint n)
+	{
+		d_keys = new uint8[n * RAW_SIZE];
+		d_values = new uint32[n];
+		d_mask = n - 1;
+		d_size = 0;
+	}
+
+	/* Writes the raw form of @id to @raw, which must be RAW_SIZE bytes.
+	 *
+	 * A Ggit.OId wraps a git_oid, which starts with the raw id, so it is
+	 * copied from there without allocating. This is checked once against
+	 * the hex form of the id, which is used instead if it does not match.
+	 */
+	public static void get_raw(Ggit.OId id, uint8[] raw)
+	{
+		if (s_raw_direct == 0)
+		{
+			get_raw_from_string(id, raw);
+			return;
+		}
+
+		Memory.copy(raw, (void *)id, RAW_SIZE);
+
+		if (s_raw_direct < 0)
+		{
+			uint8 check[RAW_SIZE];
+			get_raw_from_string(id, check);
+
+			s_raw_direct = Memory.cmp(raw, check, RAW_SIZE) == 0 ? 1 : 0;
+
+			if (s_raw_direct == 0)
+			{
+				Memory.copy(raw, check, RAW_SIZE);
+			}
+		}
+	}
+
+	private static void get_raw_from_string(Ggit.OId id, uint8[] raw)
+	{
+		var hex = id.to_string();
+
+		for (var i = 0; i < RAW_SIZE; i++)
+		{
+			raw[i] = (uint8)((hex[i * 2].xdigit_value() << 4) | hex[i * 2 + 1].xdigit_value());
+		}
+	}
+
+	private static uint hash_raw(uint8[] raw)
+	{
+		// Object ids are uniformly distributed already
+		return (uint)raw[0] | ((uint)raw[1] << 8) | ((uint)raw[2] << 16) | ((uint)raw[3] << 24);
+	}
+
+	private bool slot_equals(uint slot, uint8[] raw)
+	{
+		return Memory.cmp(&d_keys[slot * RAW_SIZE], raw, RAW_SIZE) == 0;
+	}
+
+	private uint find_slot(uint8[] raw)
+	{
+		var slot = hash_raw(raw) & d_mask;
+
+		while (d_values[slot] != 0 && !slot_equals(slot, raw))
+		{
+			slot = (slot + 1) & d_mask;
+		}
+
+		return slot;
+	}
+
+	private void grow()
+	{
+		var keys = (owned)d_keys;
+		var values = (owned)d_values;
+		uint8 raw[RAW_SIZE];
+
+		allocate(values.length * 2);
+
+		for (var i = 0; i < values.length; i++)
+		{
+			if (values[i] != 0)
+			{
+				Memory.copy(raw, &keys[i * RAW_SIZE], RAW_SIZE);
+				insert_raw(raw, values[i] - 1);
+			}
+		}
+	}
+
+	private void insert_raw(uint8[] raw, uint val)
+	{
+		var slot = find_slot(raw);
+
+		if (d_values[slot] == 0)
+		{
+			Memory.copy(&d_keys[slot * RAW_SIZE], raw, RAW_SIZE);
+			d_size++;
+		}
+
+		d_values[slot] = val + 1;
+	}
+
+	/* Maps @id to @val, replacing any previous mapping of @id. */
+	public void set(Ggit.OId id, uint val)
+	{
+		if ((d_size + 1) * 2 > d_values.length)
+		{
+			grow();
+		}
+
+		uint8 raw[RAW_SIZE];
+		get_raw(id, raw);
+
+		insert_raw(raw, val);
+	}
+
+	/* Gets the value of @id, returns false if @id is not in the table. */
+	public bool lookup(Ggit.OId id, out uint val)
+	{
+		uint8 raw[RAW_SIZE];
+		get_raw(id, raw);
+
+		var v = d_values[find_slot(raw)];
+
+		val = v != 0 ? v - 1 : 0;
+		return v != 0;
+	}
+
+	public bool contains(Ggit.OId id)
+	{
+		uint val;
+		return lookup(id, out val);
+	}
+}
+
+}
+
+// ex:set ts=4 noet
@@ -22,8 +22,42 @@ namespace Gitg
 
 public class Repository : Ggit.Repository
 {
+	private class RefEntry
+	{
+		public Gitg.Ref reference;
+		public Ggit.OId id;
+
+		// The id of the commit a tag points to
+		public Ggit.OId? tag_target;
+
+		public bool equal(RefEntry other)
+		{
+			if (!id.equal(other.id))
+			{
+				return false;
+			}
+
+			if (tag_target == null || other.tag_target == null)
+			{
+				return tag_target == other.tag_target;
+			}
+
+			return tag_target.equal(other.tag_target);
+		}
+	}
+
 	private HashTable<Ggit.OId, SList<Gitg.Ref>> d_refs;
+	private Gee.TreeMap<string, RefEntry> d_refs_by_name;
 	private Stage ?d_stage;
+	private AheadBehindCache? d_ahead_behind;
+
+	/**
+	 * Emitted when refs were invalidated with invalidate_refs.
+	 *
+	 * @param names the names of the refs which were added, removed or
+	 *              moved, or null if these are not known.
+	 */
+	public signal void refs_invalidated(string[]? names);
 
 	public string? name
 	{
@@ -42,7 +76,7 @@ public class Repository : Ggit.Repository
 		((Initable)this).init(null);
 	}
 
-	private void ensure_refs_add(Ggit.OId? id, Gitg.Ref r)
+	private void refs_add(Ggit.OId? id, Gitg.Ref r)
 	{
 		if (id == null)
 		{
@@ -64,9 +98,95 @@ public class Repository : Ggit.Repository
 		}
 	}
 
+	private void refs_remove(Ggit.OId? id, Gitg.Ref r)
+	{
+		if (id == null)
+		{
+			return;
+		}
+
+		unowned SList<Gitg.Ref> refs = d_refs.lookup(id);
+		var nrefs = new SList<Gitg.Ref>();
+
+		foreach (var other in refs)
+		{
+			if (other != r)
+			{
+				nrefs.append(other);
+			}
+		}
+
+		if (nrefs.length() == 0)
+		{
+			d_refs.remove(id);
+		}
+		else
+		{
+			d_refs.insert(id, (owned)nrefs);
+		}
+	}
+
 	public void clear_refs_cache()
 	{
 		d_refs = null;
+		d_refs_by_name = null;
+	}
+
+	private RefEntry? lookup_ref_entry(string name)
+	{
+		Gitg.Ref? r;
+
+		try
+		{
+			r = lookup_reference(name);
+		}
+		catch { return null; }
+
+		if (r == null)
+		{
+			return null;
+		}
+
+		Ggit.OId? id = r.get_target();
+
+		if (id == null)
+		{
+			return null;
+		}
+
+		var entry = new RefEntry();
+
+		entry.reference = r;
+		entry.id = id;
+
+		// if it's a 'real' tag, then we are also going to store
+		// a ref to the underlying commit the tag points to
+		try
+		{
+			var tag = lookup<Ggit.Tag>(id);
+			entry.tag_target = tag.get_target_id();
+		} catch {}
+
+		return entry;
+	}
+
+	private void index_ref(string name, RefEntry entry)
+	{
+		d_refs_by_name[name] = entry;
+
+		refs_add(entry.id, entry.reference);
+		refs_add(entry.tag_target, entry.reference);
+	}
+
+	private void unindex_ref(string name)
+	{
+		RefEntry entry;
+
+		if (d_refs_by_name.unset(name, out entry))
+		{
+			refs_remove(entry.id, entry.reference);
+			refs_remove(entry.tag_target, entry.reference);
+		}
 	}
 
 	private void ensure_refs()
@@ -79,50 +199,189 @@ public class Repository : Ggit.Repository
 		d_refs = new HashTable<Ggit.OId, SList<Gitg.Ref>>(Ggit.OId.hash,
 		                                                  Ggit.OId.equal);
 
+		d_refs_by_name = new Gee.TreeMap<string, RefEntry>();
+
 		try
 		{
 			references_foreach_name((name) => {
-				Gitg.Ref? r;
+				var entry = lookup_ref_entry(name);
 
-				try
+				if (entry != null)
 				{
-					r = lookup_reference(name);
+					index_ref(name, entry);
 				}
-				catch { return 0; }
 
-				if (r == null)
-				{
+				return 0;
+			});
+		}
+		catch {}
+	}
+
+	/**
+	 * Get the cached refs whose name starts with a prefix.
+	 *
+	 * @param prefix the prefix, e.g. "refs/remotes/origin/".
+	 */
+	public Gee.List<Gitg.Ref> refs_with_prefix(string prefix)
+	{
+		ensure_refs();
+
+		var ret = new Gee.ArrayList<Gitg.Ref>();
+
+		// Names are sorted, so the names with the prefix directly follow it
+		foreach (var entry in d_refs_by_name.tail_map(prefix).entries)
+		{
+			if (!entry.key.has_prefix(prefix))
+			{
+				break;
+			}
+
+			ret.add(entry.value.reference);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * Update the refs cache for refs which changed.
+	 *
+	 * Only the given refs are looked up again, instead of all of them as
+	 * after clear_refs_cache. A name which is a directory of refs
+	 * invalidates the refs it contains, including new ones created with the
+	 * directory. When @names is null, which refs changed is found by
+	 * comparing all refs with the cache, e.g. after the packed refs
+	 * changed. Emits refs_invalidated with the refs which actually changed.
+	 *
+	 * @param names the names of the refs which might have changed, or null.
+	 */
+	public void invalidate_refs(string[]? names)
+	{
+		if (d_refs == null)
+		{
+			// Nothing to compare to, the cache is built when used next
+			refs_invalidated(names);
+			return;
+		}
+
+		var changed = new Gee.ArrayList<string>();
+
+		if (names == null)
+		{
+			var seen = new Gee.HashSet<string>();
+
+			try
+			{
+				references_foreach_name((name) => {
+					seen.add(name);
+					update_ref(name, changed);
+
 					return 0;
+				});
+			}
+			catch
+			{
+				clear_refs_cache();
+				refs_invalidated(null);
+				return;
+			}
+
+			foreach (var name in d_refs_by_name.keys.to_array())
+			{
+				if (!seen.contains(name))
+				{
+					update_ref(name, changed);
 				}
+			}
+		}
+		else
+		{
+			var check = new Gee.TreeSet<string>();
+			var prefixes = new Gee.ArrayList<string>();
 
-				Ggit.OId? id = r.get_target();
+			foreach (var name in names)
+			{
+				check.add(name);
 
-				if (id == null)
+				foreach (var r in refs_with_prefix(name + "/"))
 				{
-					return 0;
+					check.add(r.get_name());
 				}
 
-				ensure_refs_add(id, r);
+				// A name which is not a known ref might be a new directory,
+				// whose refs are not reported on their own
+				if (name.has_prefix("refs/") && !d_refs_by_name.has_key(name))
+				{
+					prefixes.add(name + "/");
+				}
+			}
 
-				// if it's a 'real' tag, then we are also going to store
-				// a ref to the underlying commit the tag points to
+			if (prefixes.size != 0)
+			{
 				try
 				{
-					var tag = lookup<Ggit.Tag>(id);
+					references_foreach_name((name) => {
+						foreach (var prefix in prefixes)
+						{
+							if (name.has_prefix(prefix))
+							{
+								check.add(name);
+								break;
+							}
+						}
+
+						return 0;
+					});
+				}
+				catch
+				{
+					invalidate_refs(null);
+					return;
+				}
+			}
 
-					// get the target id
-					id = tag.get_target_id();
+			foreach (var name in check)
+			{
+				update_ref(name, changed);
+			}
+		}
 
-					if (id != null)
-					{
-						ensure_refs_add(id, r);
-					}
-				} catch {}
+		if (changed.size != 0)
+		{
+			refs_invalidated(changed.to_array());
+		}
+	}
 
-				return 0;
-			});
+	private void update_ref(string name, Gee.List<string> changed)
+	{
+		// Refs outside of refs/, like HEAD, are not cached but are still
+		// reported
+		if (!name.has_prefix("refs/"))
+		{
+			changed.add(name);
+			return;
 		}
-		catch {}
+
+		var old = d_refs_by_name[name];
+		var entry = lookup_ref_entry(name);
+
+		if (old == null && entry == null)
+		{
+			return;
+		}
+
+		if (old != null && entry != null && old.equal(entry))
+		{
+			return;
+		}
+
+		unindex_ref(name);
+
+		if (entry != null)
+		{
+			index_ref(name, entry);
+		}
+
+		changed.add(name);
 	}
 
 	public unowned SList<Gitg.Ref> refs_for_id(Ggit.OId id)
@@ -186,6 +445,19 @@ public class Repository : Ggit.Repository
 		}
 	}
 
+	public AheadBehindCache ahead_behind
+	{
+		owned get
+		{
+			if (d_ahead_behind == null)
+			{
+				d_ahead_behind = new AheadBehindCache(this);
+			}
+
+			return d_ahead_behind;
+		}
+	}
+
 	public Ggit.Signature get_signature_with_environment(Gee.Map<string, string> env, string envname = "COMMITER") throws Error
 	{
 		string? user = null;
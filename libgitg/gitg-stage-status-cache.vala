@@ -0,0 +1,192 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/**
+ * Keeps the status of the files in the working directory up to date.
+ *
+ * The first update walks the whole working directory. Later updates only
+ * get the status of the paths which were invalidated since the previous
+ * update and merge it into the status already known, which is a lot
+ * cheaper than a full status walk on large working directories.
+ */
+public class StageStatusCache : Object
+{
+	// Above this number of invalidated paths, matching them against every
+	// file of the working directory is not cheaper than a full walk anymore
+	private const int MAX_PATHS = 1000;
+
+	private Repository d_repository;
+	private Ggit.StatusOption d_options;
+	private Ggit.StatusShow d_show;
+
+	private Gee.HashMap<string, StageStatusItem> d_items;
+	private Gee.HashSet<string> d_paths;
+	private bool d_needs_full;
+
+	public StageStatusCache(Repository        repository,
+	                        Ggit.StatusOption options,
+	                        Ggit.StatusShow   show)
+	{
+		d_repository = repository;
+		d_options = options;
+		d_show = show;
+
+		d_items = new Gee.HashMap<string, StageStatusItem>();
+		d_paths = new Gee.HashSet<string>();
+		d_needs_full = true;
+	}
+
+	public Repository repository
+	{
+		get { return d_repository; }
+	}
+
+	/**
+	 * Mark the status of all files as changed.
+	 *
+	 * The next update walks the whole working directory.
+	 */
+	public void invalidate()
+	{
+		d_needs_full = true;
+		d_paths.clear();
+	}
+
+	/**
+	 * Mark the status of the given paths as changed.
+	 *
+	 * @param paths the paths relative to the working directory. A directory
+	 *              also invalidates all the files it contains.
+	 */
+	public void invalidate_paths(string[] paths)
+	{
+		if (d_needs_full)
+		{
+			return;
+		}
+
+		foreach (var path in paths)
+		{
+			d_paths.add(path);
+		}
+
+		if (d_paths.size > MAX_PATHS)
+		{
+			invalidate();
+		}
+	}
+
+	public delegate void FilesUpdatedFunc(StageStatusItem[] items);
+
+	/**
+	 * Update the status of the invalidated files.
+	 *
+	 * Only one update should run at a time. Paths invalidated while an
+	 * update is running are updated by the next one.
+	 *
+	 * @param files_updated called with the status of all files once the
+	 *                      files are updated, while the status of the
+	 *                      submodules is still being updated.
+	 *
+	 * @return the status of all files with changes.
+	 */
+	public async StageStatusItem[] update(owned FilesUpdatedFunc? files_updated = null)
+	{
+		string[]? paths = null;
+
+		if (!d_needs_full)
+		{
+			if (d_paths.size == 0)
+			{
+				return d_items.values.to_array();
+			}
+
+			paths = d_paths.to_array();
+		}
+
+		d_needs_full = false;
+		d_paths.clear();
+
+		var opts = d_options;
+
+		if (paths != null)
+		{
+			// The paths are literal, not patterns
+			opts |= Ggit.StatusOption.DISABLE_PATHSPEC_MATCH;
+		}
+
+		var options = new Ggit.StatusOptions(opts, d_show, paths);
+		var enumerator = d_repository.stage.file_status(options, paths);
+
+		var seen = new Gee.HashSet<string>();
+
+		// Files first, keeping the submodules of the previous update until
+		// their status is known
+		var items = yield enumerator.next_file_items();
+
+		remove_matching(paths, seen, typeof(StageStatusFile));
+		add_items(items, seen);
+
+		if (files_updated != null)
+		{
+			files_updated(d_items.values.to_array());
+		}
+
+		items = yield enumerator.next_items(-1);
+		add_items(items, seen);
+
+		remove_matching(paths, seen, typeof(StageStatusSubmodule));
+
+		return d_items.values.to_array();
+	}
+
+	private void add_items(StageStatusItem[] items, Gee.HashSet<string> seen)
+	{
+		foreach (var item in items)
+		{
+			d_items[item.path] = item;
+			seen.add(item.path);
+		}
+	}
+
+	// Removes the items of type within paths which were not seen in this update
+	private void remove_matching(string[]? paths, Gee.HashSet<string> seen, Type type)
+	{
+		var it = d_items.map_iterator();
+
+		while (it.next())
+		{
+			var item = it.get_value();
+
+			if (item.get_type().is_a(type) &&
+			    !seen.contains(item.path) &&
+			    StageStatusEnumerator.path_matches(item.path, paths))
+			{
+				it.unset();
+			}
+		}
+	}
+}
+
+}
+
+// ex:set ts=4 noet
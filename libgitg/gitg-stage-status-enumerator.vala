@@ -143,6 +143,14 @@ public class StageStatusSubmodule : Object, StageStatusItem
 		  Ggit.SubmoduleStatus.WD_INDEX_MODIFIED
 		| Ggit.SubmoduleStatus.WD_WD_MODIFIED;
 
+	internal StageStatusSubmodule.with_status(Ggit.Submodule       submodule,
+	                                          Ggit.SubmoduleStatus flags)
+	{
+		d_submodule = submodule;
+		d_path = submodule.get_path();
+		d_flags = flags;
+	}
+
 	public StageStatusSubmodule(Ggit.Submodule submodule)
 	{
 		d_submodule = submodule;
@@ -201,8 +209,186 @@ public class StageStatusSubmodule : Object, StageStatusItem
 	}
 }
 
+/* Gets the status of submodules like Ggit.Repository.get_submodule_status
+ * with Ggit.SubmoduleIgnore.UNTRACKED, but keeps the repositories of the
+ * submodules open between calls instead of opening them every time.
+ * Different submodules can be queried from different threads.
+ */
+internal class SubmoduleStatusReader : Object
+{
+	private class Handle
+	{
+		public Ggit.Repository repository;
+		public Mutex mutex;
+
+		public Handle(Ggit.Repository repository)
+		{
+			this.repository = repository;
+			mutex = Mutex();
+		}
+	}
+
+	private Gee.HashMap<string, Handle> d_handles;
+	private Mutex d_handles_mutex;
+
+	public SubmoduleStatusReader()
+	{
+		d_handles = new Gee.HashMap<string, Handle>();
+		d_handles_mutex = Mutex();
+	}
+
+	private Handle? open(Ggit.Submodule submodule)
+	{
+		var path = submodule.get_path();
+
+		d_handles_mutex.lock();
+		var handle = d_handles[path];
+		d_handles_mutex.unlock();
+
+		if (handle != null)
+		{
+			var wd = handle.repository.get_workdir();
+
+			if (wd != null && wd.get_child(".git").query_exists())
+			{
+				return handle;
+			}
+
+			handle = null;
+		}
+
+		try
+		{
+			handle = new Handle(submodule.open());
+		} catch {}
+
+		d_handles_mutex.lock();
+
+		if (handle != null)
+		{
+			d_handles[path] = handle;
+		}
+		else
+		{
+			d_handles.unset(path);
+		}
+
+		d_handles_mutex.unlock();
+
+		return handle;
+	}
+
+	private static bool id_equal(Ggit.OId? a, Ggit.OId? b)
+	{
+		return a == null ? b == null : (b != null && a.equal(b));
+	}
+
+	public Ggit.SubmoduleStatus status(Ggit.Submodule submodule)
+	{
+		var ret = Ggit.SubmoduleStatus.IN_CONFIG;
+
+		var head_id = submodule.get_head_id();
+		var index_id = submodule.get_index_id();
+
+		if (head_id != null)
+		{
+			ret |= Ggit.SubmoduleStatus.IN_HEAD;
+		}
+
+		if (index_id != null)
+		{
+			ret |= Ggit.SubmoduleStatus.IN_INDEX;
+		}
+
+		if (head_id == null && index_id != null)
+		{
+			ret |= Ggit.SubmoduleStatus.INDEX_ADDED;
+		}
+		else if (head_id != null && index_id == null)
+		{
+			ret |= Ggit.SubmoduleStatus.INDEX_DELETED;
+		}
+		else if (!id_equal(head_id, index_id))
+		{
+			ret |= Ggit.SubmoduleStatus.INDEX_MODIFIED;
+		}
+
+		var handle = open(submodule);
+
+		if (handle == null)
+		{
+			if (index_id != null)
+			{
+				var wd = submodule.get_owner().get_workdir().get_child(submodule.get_path());
+
+				ret |= wd.query_exists() ? Ggit.SubmoduleStatus.WD_UNINITIALIZED
+				                         : Ggit.SubmoduleStatus.WD_DELETED;
+			}
+
+			return ret;
+		}
+
+		ret |= Ggit.SubmoduleStatus.IN_WD;
+
+		handle.mutex.lock();
+
+		Ggit.OId? wd_id = null;
+
+		try
+		{
+			wd_id = handle.repository.get_head().get_target();
+		} catch {}
+
+		if (index_id == null)
+		{
+			ret |= Ggit.SubmoduleStatus.WD_ADDED;
+		}
+		else if (!id_equal(wd_id, index_id))
+		{
+			ret |= Ggit.SubmoduleStatus.WD_MODIFIED;
+		}
+
+		// Untracked files are ignored, find the first index and working
+		// directory modifications
+		var options = new Ggit.StatusOptions(Ggit.StatusOption.EXCLUDE_SUBMODULES,
+		                                     Ggit.StatusShow.INDEX_AND_WORKDIR,
+		                                     null);
+
+		var index_flags = Ggit.StatusFlags.INDEX_NEW
+		                | Ggit.StatusFlags.INDEX_MODIFIED
+		                | Ggit.StatusFlags.INDEX_DELETED
+		                | Ggit.StatusFlags.INDEX_RENAMED
+		                | Ggit.StatusFlags.INDEX_TYPECHANGE;
+
+		var dirty = Ggit.SubmoduleStatus.WD_INDEX_MODIFIED | Ggit.SubmoduleStatus.WD_WD_MODIFIED;
+
+		try
+		{
+			handle.repository.file_status_foreach(options, (path, flags) => {
+				if ((flags & index_flags) != 0)
+				{
+					ret |= Ggit.SubmoduleStatus.WD_INDEX_MODIFIED;
+				}
+
+				if ((flags & ~index_flags) != 0)
+				{
+					ret |= Ggit.SubmoduleStatus.WD_WD_MODIFIED;
+				}
+
+				return (ret & dirty) == dirty ? -1 : 0;
+			});
+		} catch {}
+
+		handle.mutex.unlock();
+
+		return ret;
+	}
+}
+
 public class StageStatusEnumerator : Object
 {
+	private const uint MAX_SUBMODULE_THREADS = 8;
+
 	private Repository d_repository;
 	private Thread<void *> d_thread;
 	private StageStatusItem[] d_items;
@@ -210,7 +396,11 @@ public class StageStatusEnumerator : Object
 	private int d_callback_num;
 	private Cancellable d_cancellable;
 	private SourceFunc d_callback;
+	private SourceFunc d_files_callback;
+	private bool d_files_done;
+	private SubmoduleStatusReader d_submodule_status;
 	private Ggit.StatusOptions? d_options;
+	private string[]? d_paths;
 	private Gee.HashSet<string> d_ignored_submodules;
 
 	private static Regex s_ignore_regex;
@@ -228,10 +418,13 @@ public class StageStatusEnumerator : Object
 	}
 
 	internal StageStatusEnumerator(Repository repository,
-	                               Ggit.StatusOptions? options = null)
+	                               Ggit.StatusOptions? options = null,
+	                               string[]? paths = null)
 	{
 		d_repository = repository;
 		d_options = options;
+		d_paths = paths;
+		d_submodule_status = repository.stage.submodule_status;
 
 		d_items = new StageStatusItem[100];
 		d_items.length = 0;
@@ -277,6 +470,26 @@ public class StageStatusEnumerator : Object
 
 	private delegate void AddItem(StageStatusItem item);
 
+	// Whether path is one of paths or inside one of them, all paths match
+	// when paths is null
+	internal static bool path_matches(string path, string[]? paths)
+	{
+		if (paths == null)
+		{
+			return true;
+		}
+
+		foreach (var p in paths)
+		{
+			if (path == p || (path.has_prefix(p) && path[p.length] == '/'))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	private void *run_status()
 	{
 		AddItem add = (item) => {
@@ -294,7 +507,10 @@ public class StageStatusEnumerator : Object
 			}
 		};
 
+		var span = Trace.begin();
+
 		var submodule_paths = new Gee.HashSet<string>();
+		var submodules = new Ggit.Submodule[0];
 
 		// Due to a bug in libgit2, submodule iteration crashes when performed
 		// on a bare repository
@@ -303,13 +519,17 @@ public class StageStatusEnumerator : Object
 			try
 			{
 				d_repository.submodule_foreach((submodule, name) => {
-					submodule_paths.add(submodule.get_path());
+					var path = submodule.get_path();
+
+					submodule_paths.add(path);
 
-					if (!d_ignored_submodules.contains(name))
+					// Only query the status of submodules within the
+					// requested paths, it is expensive
+					if (!d_ignored_submodules.contains(name) && path_matches(path, d_paths))
 					{
 						try
 						{
-							add(new StageStatusSubmodule(d_repository.lookup_submodule(name)));
+							submodules += d_repository.lookup_submodule(name);
 						} catch {}
 					}
 
@@ -318,6 +538,36 @@ public class StageStatusEnumerator : Object
 			} catch {}
 		}
 
+		// Get the status of the submodules on a pool of threads while
+		// walking the files, each submodule is added when it is done
+		ThreadPool<Ggit.Submodule>? pool = null;
+
+		if (submodules.length > 1)
+		{
+			var n = uint.min(uint.min(get_num_processors(), MAX_SUBMODULE_THREADS), submodules.length);
+
+			try
+			{
+				pool = new ThreadPool<Ggit.Submodule>.with_owned_data((submodule) => {
+					if (!d_cancellable.is_cancelled())
+					{
+						add(new StageStatusSubmodule.with_status(submodule, d_submodule_status.status(submodule)));
+					}
+				}, (int)n, true);
+
+				foreach (var submodule in submodules)
+				{
+					pool.add(submodule);
+				}
+
+				submodules = new Ggit.Submodule[0];
+			}
+			catch (ThreadError e)
+			{
+				stderr.printf("Failed to start submodule status threads: %s\n", e.message);
+			}
+		}
+
 		try
 		{
 			d_repository.file_status_foreach(d_options, (path, flags) => {
@@ -330,6 +580,39 @@ public class StageStatusEnumerator : Object
 			});
 		} catch {}
 
+		Trace.end(span, "StageStatusEnumerator.files");
+
+		lock (d_items)
+		{
+			d_files_done = true;
+
+			if (d_files_callback != null)
+			{
+				var cb = (owned)d_files_callback;
+				d_files_callback = null;
+
+				Idle.add((owned)cb);
+			}
+		}
+
+		// Submodules which were not handed to the pool
+		foreach (var submodule in submodules)
+		{
+			if (d_cancellable.is_cancelled())
+			{
+				break;
+			}
+
+			add(new StageStatusSubmodule.with_status(submodule, d_submodule_status.status(submodule)));
+		}
+
+		if (pool != null)
+		{
+			ThreadPool.free((owned)pool, false, true);
+		}
+
+		Trace.end_detail(span, "StageStatusEnumerator.status", "%d items", d_items.length);
+
 		lock (d_items)
 		{
 			d_cancellable = null;
@@ -375,6 +658,37 @@ public class StageStatusEnumerator : Object
 		return ret;
 	}
 
+	/**
+	 * Get the items found until the status of all files is known.
+	 *
+	 * Submodule items may still follow, get them with next_items.
+	 */
+	public async StageStatusItem[] next_file_items()
+	{
+		SourceFunc callback = next_file_items.callback;
+
+		lock (d_items)
+		{
+			if (d_files_done)
+			{
+				return fill_items(-1);
+			}
+
+			d_files_callback = (owned)callback;
+		}
+
+		yield;
+
+		StageStatusItem[] ret;
+
+		lock (d_items)
+		{
+			ret = fill_items(-1);
+		}
+
+		return ret;
+	}
+
 	public async StageStatusItem[] next_items(int num)
 	{
 		SourceFunc callback = next_items.callback;
@@ -98,13 +98,22 @@ public class Stage : Object
 {
 	private const string CONFIG_USER_SIGNINGKEY = "user.signingkey";
 
+	private static uint8[] s_empty_content = new uint8[0];
+
 	private weak Repository d_repository;
 	private Mutex d_index_mutex;
 	private Ggit.Tree? d_head_tree;
+	private SubmoduleStatusReader d_submodule_status;
 
 	internal Stage(Repository repository)
 	{
 		d_repository = repository;
+		d_submodule_status = new SubmoduleStatusReader();
+	}
+
+	internal SubmoduleStatusReader submodule_status
+	{
+		get { return d_submodule_status; }
 	}
 
 	public async void refresh() throws Error
@@ -147,9 +156,19 @@ public class Stage : Object
 		return d_head_tree;
 	}
 
-	public StageStatusEnumerator file_status(Ggit.StatusOptions? options = null)
+	/**
+	 * Enumerate the status of the files in the repository.
+	 *
+	 * @param options the status options.
+	 * @param paths the paths to get the status of, or null for all files.
+	 *
+	 * When @paths is given, submodules are only reported if they are within
+	 * @paths and @options should contain a pathspec which matches @paths.
+	 */
+	public StageStatusEnumerator file_status(Ggit.StatusOptions? options = null,
+	                                         string[]?           paths = null)
 	{
-		return new StageStatusEnumerator(d_repository, options);
+		return new StageStatusEnumerator(d_repository, options, paths);
 	}
 
 	private delegate void WithIndexFunc(Ggit.Index index) throws Error;
@@ -674,86 +693,72 @@ public class Stage : Object
 	 */
 	public async void revert_patch(PatchSet patch) throws Error
 	{
-		// new file is the current file in the working directory
-		var workdirf = d_repository.get_workdir().resolve_relative_path(patch.filename);
-		var workdirf_stream = yield workdirf.read_async();
+		yield revert_patches(new PatchSet[] {patch});
+	}
+
+	/**
+	 * Revert patches in the working directory.
+	 *
+	 * @param patches the patches to revert, at most one per file.
+	 *
+	 * Revert the provided patches from the working directory, see revert_patch.
+	 */
+	public async void revert_patches(PatchSet[] patches) throws Error
+	{
+		var wd = d_repository.get_workdir();
 
 		yield thread_index((index) => {
 			var entries = index.get_entries();
-			var entry = entries.get_by_path(workdirf, 0);
-
-			if (entry == null)
-			{
-				throw new StageError.INDEX_ENTRY_NOT_FOUND(patch.filename);
-			}
-
-			var index_blob = d_repository.lookup<Ggit.Blob>(entry.get_id());
-			unowned uchar[] index_content = index_blob.get_raw_content();
 
-			var index_stream = new MemoryInputStream.from_bytes(new Bytes(index_content));
-			var reversed = patch.reversed();
-
-			FileIOStream? out_stream = null;
-			File ?outf = null;
-
-			try
+			foreach (var patch in patches)
 			{
-				outf = File.new_tmp(null, out out_stream);
+				if (patch.patches.length == 0)
+				{
+					continue;
+				}
 
-				apply_patch_stream(workdirf_stream,
-				                   index_stream,
-				                   out_stream.output_stream,
-				                   reversed);
-			}
-			catch (Error e)
-			{
-				workdirf_stream.close();
-				index_stream.close();
+				// new file is the current file in the working directory
+				var workdirf = wd.resolve_relative_path(patch.filename);
+				var entry = entries.get_by_path(workdirf, 0);
 
-				if (outf != null)
+				if (entry == null)
 				{
-					try
-					{
-						outf.delete();
-					} catch {}
+					throw new StageError.INDEX_ENTRY_NOT_FOUND(patch.filename);
 				}
 
-				throw e;
-			}
+				var index_blob = d_repository.lookup<Ggit.Blob>(entry.get_id());
+				unowned uint8[] index_content = index_blob.get_raw_content();
 
-			workdirf_stream.close();
-			index_stream.close();
+				// The content is copied out of the mapping before the file is
+				// replaced. Replacing writes the file in place when it is a
+				// symlink or has other hard links, which truncates the mapped
+				// content
+				var workdir_map = new MappedFile(workdirf.get_path(), false);
+				var workdir_bytes = new Bytes(workdir_map.get_bytes().get_data());
 
-			if (out_stream != null)
-			{
-				out_stream.close();
-			}
+				workdir_map = null;
 
-			// Move outf to workdirf
-			try
-			{
-				var repl = workdirf.replace(null,
-				                            false,
-				                            FileCreateFlags.NONE);
+				var stream = workdirf.replace(null, false, FileCreateFlags.NONE);
 
-				repl.splice(outf.read(),
-				            OutputStreamSpliceFlags.CLOSE_SOURCE |
-				            OutputStreamSpliceFlags.CLOSE_TARGET);
-			}
-			catch (Error e)
-			{
 				try
 				{
-					outf.delete();
-				} catch {}
+					write_patched(stream,
+					              workdir_bytes.get_data(),
+					              index_content,
+					              patch.reversed());
+				}
+				catch (Error e)
+				{
+					try
+					{
+						stream.close(new Cancellable.cancelled());
+					} catch {}
 
-				throw e;
-			}
+					throw e;
+				}
 
-			try
-			{
-				outf.delete();
-			} catch {}
+				stream.close();
+			}
 		});
 	}
 
@@ -833,36 +838,64 @@ public class Stage : Object
 		});
 	}
 
-	private void copy_stream(OutputStream dest, InputStream src, ref size_t pos, size_t index, size_t length) throws Error
+	/* Writes @old_content with @patch applied to @dest. The inserted parts
+	 * are taken from @new_content. The patches must be ordered by offset.
+	 */
+	private void write_patched(OutputStream dest,
+	                           uint8[]      old_content,
+	                           uint8[]      new_content,
+	                           PatchSet     patch) throws Error
 	{
-		if (length == 0)
+		size_t old_ptr = 0;
+
+		foreach (var p in patch.patches)
 		{
-			return;
-		}
+			if (p.old_offset < old_ptr || p.old_offset > old_content.length)
+			{
+				throw new IOError.INVALID_DATA("Patch does not apply to %s", patch.filename);
+			}
 
-		var buf = new uint8[length];
+			// Copy from old_ptr until p.old_offset
+			dest.write_all(old_content[old_ptr:p.old_offset], null);
+			old_ptr = p.old_offset;
 
-		if (pos != index)
-		{
-			((Seekable)src).seek(index, SeekType.SET);
-			pos = index;
-		}
+			if (p.type == PatchSet.Type.REMOVE)
+			{
+				// Removing, just advance old content
+				old_ptr += p.length;
+			}
+			else
+			{
+				if (p.new_offset + p.length > new_content.length)
+				{
+					throw new IOError.INVALID_DATA("Patch does not apply to %s", patch.filename);
+				}
 
-		src.read_all(buf, null);
-		dest.write_all(buf, null);
+				// Inserting, copy from new content
+				dest.write_all(new_content[p.new_offset:p.new_offset + p.length], null);
+			}
+		}
 
-		pos += length;
+		// Copy remaining part of old
+		if (old_ptr < old_content.length)
+		{
+			dest.write_all(old_content[old_ptr:old_content.length], null);
+		}
 	}
 
-	private void apply_patch(Ggit.Index  index,
-	                         uint filemode,
-	                         InputStream old_stream,
-	                         InputStream new_stream,
-	                         PatchSet    patch) throws Error
+	/* Writes the blob of @old_content with @patch applied, and adds it to
+	 * @index. The index is not written.
+	 */
+	private void apply_patch(Ggit.Index index,
+	                         uint       filemode,
+	                         uint8[]    old_content,
+	                         uint8[]    new_content,
+	                         PatchSet   patch) throws Error
 	{
+		// The blob is streamed to the object database as it is written
 		var patched_stream = d_repository.create_blob();
 
-		apply_patch_stream(old_stream, new_stream, patched_stream, patch);
+		write_patched(patched_stream, old_content, new_content, patch);
 
 		patched_stream.close();
 		var new_id = patched_stream.get_id();
@@ -872,47 +905,6 @@ public class Stage : Object
 		new_entry.set_mode(filemode);
 
 		index.add(new_entry);
-		index.write();
-	}
-
-	private void apply_patch_stream(InputStream  old_stream,
-	                                InputStream  new_stream,
-	                                OutputStream patched_stream,
-	                                PatchSet     patch) throws Error
-	{
-		size_t old_ptr = 0;
-		size_t new_ptr = 0;
-
-		// Copy old_content to patched_stream while applying patches as
-		// specified in patch.patches from new_stream
-		foreach (var p in patch.patches)
-		{
-			// Copy from old_ptr until p.old_offset
-			copy_stream(patched_stream,
-			            old_stream,
-			            ref old_ptr,
-			            old_ptr,
-			            p.old_offset - old_ptr);
-
-			if (p.type == PatchSet.Type.REMOVE)
-			{
-				// Removing, just advance old stream
-				((Seekable)old_stream).seek(p.length, SeekType.CUR);
-				old_ptr += p.length;
-			}
-			else
-			{
-				// Inserting, copy from new_stream
-				copy_stream(patched_stream,
-				            new_stream,
-				            ref new_ptr,
-				            p.new_offset,
-				            p.length);
-			}
-		}
-
-		// Copy remaining part of old
-		patched_stream.splice(old_stream, OutputStreamSpliceFlags.NONE);
 	}
 
 	/**
@@ -926,30 +918,62 @@ public class Stage : Object
 	 */
 	public async void stage_patch(PatchSet patch) throws Error
 	{
-		// new file is the current file in the working directory
-		var newf = d_repository.get_workdir().resolve_relative_path(patch.filename);
-		var new_stream = yield newf.read_async();
+		yield stage_patches(new PatchSet[] {patch});
+	}
+
+	/**
+	 * Stage patches to the index.
+	 *
+	 * @param patches the patches to stage, at most one per file.
+	 *
+	 * Stage the provided patches to the index, see stage_patch. The index is
+	 * written once, after all patches were applied.
+	 */
+	public async void stage_patches(PatchSet[] patches) throws Error
+	{
+		var wd = d_repository.get_workdir();
 
 		yield thread_index((index) => {
 			var entries = index.get_entries();
-			var entry = entries.get_by_path(newf, 0);
-			uchar[] old_content = new uchar[0];
-			if (entry == null)
+
+			foreach (var patch in patches)
 			{
-				print("\npath not in index %s\n", newf.get_path());
-				index.add_file(newf);
-				index.write();
-			} else {
-				var old_blob = d_repository.lookup<Ggit.Blob>(entry.get_id());
-				old_content = old_blob.get_raw_content();
-			}
+				if (patch.patches.length == 0)
+				{
+					continue;
+				}
 
-			var old_stream = new MemoryInputStream.from_bytes(new Bytes(old_content));
+				// new file is the current file in the working directory
+				var newf = wd.resolve_relative_path(patch.filename);
+				var entry = entries.get_by_path(newf, 0);
 
-			apply_patch(index, entry.get_mode(), old_stream, new_stream, patch);
+				Ggit.Blob? old_blob = null;
+				unowned uint8[] old_content = s_empty_content;
 
-			new_stream.close();
-			old_stream.close();
+				if (entry == null)
+				{
+					// Not in the index yet, apply the patch to an empty
+					// file with the mode of the working directory file
+					index.add_file(newf);
+					entry = index.get_entries().get_by_path(newf, 0);
+				}
+				else
+				{
+					old_blob = d_repository.lookup<Ggit.Blob>(entry.get_id());
+					old_content = old_blob.get_raw_content();
+				}
+
+				var new_map = new MappedFile(newf.get_path(), false);
+				var new_bytes = new_map.get_bytes();
+
+				apply_patch(index,
+				            entry.get_mode(),
+				            old_content,
+				            new_bytes.get_data(),
+				            patch);
+			}
+
+			index.write();
 		});
 	}
 
@@ -1009,60 +1033,87 @@ public class Stage : Object
 	 */
 	public async void unstage_patch(PatchSet patch) throws Error
 	{
-		var file = d_repository.get_workdir().resolve_relative_path(patch.filename);
+		yield unstage_patches(new PatchSet[] {patch});
+	}
+
+	/**
+	 * Unstage patches from the index.
+	 *
+	 * @param patches the patches to unstage, at most one per file.
+	 *
+	 * Unstage the provided patches from the index, see unstage_patch. The
+	 * index is written once, after all patches were applied.
+	 */
+	public async void unstage_patches(PatchSet[] patches) throws Error
+	{
+		var wd = d_repository.get_workdir();
 		var tree = yield get_head_tree();
 
 		yield thread_index((index) => {
 			var entries = index.get_entries();
-			var entry = entries.get_by_path(file, 0);
 
-			if (entry == null)
+			foreach (var patch in patches)
 			{
-				index.add_file(file);
-				index.write();
-				entries = index.get_entries();
-				entry = entries.get_by_path(file, 0);
-			}
+				if (patch.patches.length == 0)
+				{
+					continue;
+				}
 
-			uchar[] head_content = new uchar[0];
-			try {
-				var head_entry = tree.get_by_path(patch.filename);
-				var head_blob = d_repository.lookup<Ggit.Blob>(head_entry.get_id());
+				var file = wd.resolve_relative_path(patch.filename);
+				var entry = entries.get_by_path(file, 0);
 
-				head_content = head_blob.get_raw_content();
-			} catch (Error e) {}
+				if (entry == null)
+				{
+					index.add_file(file);
+					entries = index.get_entries();
+					entry = entries.get_by_path(file, 0);
+				}
 
-			var index_blob = d_repository.lookup<Ggit.Blob>(entry.get_id());
-			unowned uchar[] index_content = index_blob.get_raw_content();
+				Ggit.Blob? head_blob = null;
+				unowned uint8[] head_content = s_empty_content;
 
-			var head_stream = new MemoryInputStream.from_bytes(new Bytes(head_content));
-			var index_stream = new MemoryInputStream.from_bytes(new Bytes(index_content));
+				try
+				{
+					var head_entry = tree.get_by_path(patch.filename);
+					head_blob = d_repository.lookup<Ggit.Blob>(head_entry.get_id());
+					head_content = head_blob.get_raw_content();
+				} catch {}
 
-			var reversed = patch.reversed();
+				var index_blob = d_repository.lookup<Ggit.Blob>(entry.get_id());
 
-			try {
-				apply_patch(index, entry.get_mode(), index_stream, head_stream, reversed);
-			} catch(Error e) {
-				var stage = d_repository.stage;
-				stage.delete_path.begin(file.get_path(), (obj, res) => {
-					try
-					{
-						stage.delete_path.end(res);
-					}
-					catch (Error e)
-					{
-						warning("%s\n", e.message);
-					}
-				});
+				try
+				{
+					apply_patch(index,
+					            entry.get_mode(),
+					            index_blob.get_raw_content(),
+					            head_content,
+					            patch.reversed());
+				}
+				catch
+				{
+					// Fall back to removing the file from the index
+					index.remove(file, 0);
+				}
 			}
 
-			head_stream.close();
-			index_stream.close();
+			index.write();
 		});
 	}
 
+	/**
+	 * Get the diff of files in the index with HEAD.
+	 *
+	 * @param files the files, or null for all files.
+	 * @param defopts the diff options.
+	 * @param cancellable a cancellable.
+	 *
+	 * The diff is computed on the diff thread, see DiffWorker.
+	 *
+	 * @return the diff, or null if cancelled.
+	 */
 	public async Ggit.Diff? diff_index_all(StageStatusItem[]? files,
-	                                       Ggit.DiffOptions?  defopts = null) throws Error
+	                                       Ggit.DiffOptions?  defopts = null,
+	                                       Cancellable?       cancellable = null) throws Error
 	{
 		var opts = new Ggit.DiffOptions();
 
@@ -1101,20 +1152,41 @@ public class Stage : Object
 			tree = yield get_head_tree();
 		}
 
-		return new Ggit.Diff.tree_to_index(d_repository,
-		                                   tree,
-		                                   d_repository.get_index(),
-		                                   opts);
+		return yield DiffWorker.get_default().run((c) => {
+			Ggit.Diff? diff = null;
+
+			with_index((index) => {
+				diff = new Ggit.Diff.tree_to_index(d_repository,
+				                                   tree,
+				                                   index,
+				                                   opts);
+			});
+
+			return diff;
+		}, cancellable);
 	}
 
 	public async Ggit.Diff? diff_index(StageStatusItem   f,
-	                                   Ggit.DiffOptions? defopts = null) throws Error
+	                                   Ggit.DiffOptions? defopts = null,
+	                                   Cancellable?      cancellable = null) throws Error
 	{
-		return yield diff_index_all(new StageStatusItem[] {f}, defopts);
+		return yield diff_index_all(new StageStatusItem[] {f}, defopts, cancellable);
 	}
 
+	/**
+	 * Get the diff of files in the working directory with the index.
+	 *
+	 * @param files the files, or null for all files.
+	 * @param defopts the diff options.
+	 * @param cancellable a cancellable.
+	 *
+	 * The diff is computed on the diff thread, see DiffWorker.
+	 *
+	 * @return the diff, or null if cancelled.
+	 */
 	public async Ggit.Diff? diff_workdir_all(StageStatusItem[] files,
-	                                         Ggit.DiffOptions? defopts = null) throws Error
+	                                         Ggit.DiffOptions? defopts = null,
+	                                         Cancellable?      cancellable = null) throws Error
 	{
 		var opts = new Ggit.DiffOptions();
 
@@ -1146,15 +1218,24 @@ public class Stage : Object
 			opts.new_prefix = defopts.new_prefix;
 		}
 
-		return new Ggit.Diff.index_to_workdir(d_repository,
-		                                      d_repository.get_index(),
-		                                      opts);
+		return yield DiffWorker.get_default().run((c) => {
+			Ggit.Diff? diff = null;
+
+			with_index((index) => {
+				diff = new Ggit.Diff.index_to_workdir(d_repository,
+				                                      index,
+				                                      opts);
+			});
+
+			return diff;
+		}, cancellable);
 	}
 
 	public async Ggit.Diff? diff_workdir(StageStatusItem   f,
-	                                     Ggit.DiffOptions? defopts = null) throws Error
+	                                     Ggit.DiffOptions? defopts = null,
+	                                     Cancellable?      cancellable = null) throws Error
 	{
-		return yield diff_workdir_all(new StageStatusItem[] {f}, defopts);
+		return yield diff_workdir_all(new StageStatusItem[] {f}, defopts, cancellable);
 	}
 }
 
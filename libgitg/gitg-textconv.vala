@@ -25,14 +25,16 @@ public class TextConv
 {
 	public static bool has_textconv_command(Repository repository, DiffFile file)
 	{
-		return get_textconv_command(repository, file) != null;
+		bool cache;
+		return get_textconv_command(repository, file, out cache) != null;
 	}
 
-	private static string? get_textconv_command(Repository repository, DiffFile file)
+	private static string? get_textconv_command(Repository repository, DiffFile file, out bool cache)
 	{
 		string? command = null;
 		var path = file.get_path();
 		string? diffattr = null;
+		cache = false;
 		try
 		{
 			diffattr = repository.get_attribute(path, "diff", Ggit.AttributeCheckFlags.FILE_THEN_INDEX);
@@ -44,6 +46,11 @@ public class TextConv
 			{
 				var config = repository.get_config().snapshot();
 				command = config.get_string(textconv_key);
+
+				try
+				{
+					cache = config.get_bool("diff.%s.cachetextconv".printf(diffattr));
+				} catch {}
 			}
 			catch (GLib.Error e)
 			{
@@ -76,18 +83,81 @@ public class TextConv
 		uint8[] content = "".data;
 		if (raw_content != null)
 		{
-			var command = get_textconv_command(repository, file);
+			bool cache;
+			var command = get_textconv_command(repository, file, out cache);
 			if (command != null)
 			{
-				content = textconv(command, raw_content);
+				// Like git, only cache the output of drivers which have
+				// diff.<driver>.cachetextconv set
+				var path = cache ? cache_path(command, raw_content) : null;
+				if (path != null)
+				{
+					try
+					{
+						FileUtils.get_data(path, out content);
+						return content;
+					} catch {}
+				}
+
+				bool success;
+				content = textconv(command, raw_content, out success);
+
+				if (path != null && success)
+				{
+					store_cache(path, content);
+				}
 			}
 		}
 		return content;
 	}
 
-	private static uint8[] textconv(string command, uint8[]? data)
+	/* The id git gives a blob with @data as its content. */
+	private static string blob_id(uint8[] data)
 	{
-		string lines = "";
+		var checksum = new Checksum(ChecksumType.SHA1);
+		var header = "blob %d".printf(data.length);
+
+		checksum.update(header.data, header.length + 1);
+		checksum.update(data, data.length);
+
+		return checksum.get_string();
+	}
+
+	/* The cached textconv output is keyed by the command of the driver and
+	 * the id of the blob, in the same way git caches it in a notes ref.
+	 */
+	private static string cache_path(string command, uint8[] data)
+	{
+		var key = Checksum.compute_for_string(ChecksumType.SHA1, command + "\n" + blob_id(data));
+
+		return Path.build_filename(Environment.get_user_cache_dir(),
+		                           "gitg",
+		                           "textconv",
+		                           key.substring(0, 2),
+		                           key.substring(2));
+	}
+
+	private static void store_cache(string path, uint8[] content)
+	{
+		if (DirUtils.create_with_parents(Path.get_dirname(path), 0700) != 0)
+		{
+			return;
+		}
+
+		try
+		{
+			FileUtils.set_data(path, content);
+		}
+		catch (GLib.Error e)
+		{
+			stderr.printf("Failed to cache textconv output: %s\n", e.message);
+		}
+	}
+
+	private static uint8[] textconv(string command, uint8[]? data, out bool success)
+	{
+		uint8[] content = "".data;
+		success = false;
 		try
 		{
 			string[] command_array = command.split(" ");
@@ -96,34 +166,36 @@ public class TextConv
 			}
 			command_array += "/dev/stdin";
 
+			var span = Trace.begin();
 			var subproc = new Subprocess.newv(command_array, STDIN_PIPE | STDOUT_PIPE | STDERR_PIPE);
 
-			var input = new MemoryInputStream.from_data(data, GLib.free);
-			subproc.get_stdin_pipe ().splice (input, CLOSE_TARGET);
+			// Writes the input while reading stdout and stderr at the same
+			// time, so a driver blocking on a full pipe can not deadlock
+			Bytes? out_bytes;
+			Bytes? err_bytes;
+			subproc.communicate(new Bytes(data), null, out out_bytes, out err_bytes);
 
-			var end_pipe = subproc.get_stdout_pipe ();
-			var output = new DataInputStream (end_pipe);
-			string? line = null;
-			do {
-				line = output.read_line();
-				if (line != null) {
-					lines += line+"\n";
-				}
-			} while (line != null);
-
-			var err_pipe = subproc.get_stderr_pipe ();
-			var err = new DataInputStream (err_pipe);
-			string? lineerr = null;
-			do {
-				lineerr = err.read_line();
-				if (lineerr != null) {
+			Trace.end_detail(span, "TextConv", "%s", command);
+
+			if (err_bytes != null && err_bytes.get_size() > 0)
+			{
+				var err = ((string)err_bytes.get_data()).ndup(err_bytes.get_size());
+				foreach (var lineerr in err.strip().split("\n"))
+				{
 					stderr.printf(": %s\n", lineerr);
 				}
-			} while (lineerr != null);
+			}
+
+			if (out_bytes != null)
+			{
+				content = out_bytes.get_data();
+			}
+
+			success = subproc.get_successful();
 		} catch (GLib.Error e) {
 			stderr.printf("Failed to apply texconv: %s\n", e.message);
 		}
-		return lines.data;
+		return content;
 	}
 }
 
@@ -0,0 +1,322 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace Gitg
+{
+
+/* Records where time is spent, as spans and counters in the trace event
+ * format of Chrome, which can be loaded in chrome://tracing or
+ * https://ui.perfetto.dev. Tracing is started with gitg --trace FILE, or by
+ * setting GITG_TRACE to a file name. Until then, tracing a span costs a
+ * single check:
+ *
+ *     var span = Trace.begin();
+ *     ...
+ *     Trace.end(span, "CommitModel.walk");
+ *
+ * Spans can be ended from any thread.
+ */
+public class Trace
+{
+	// Rates are emitted as counters at most this often, in microseconds
+	private const int64 RATE_INTERVAL = 1000000;
+
+	private class Rate
+	{
+		public int64 start;
+		public uint count;
+	}
+
+	private static bool s_enabled;
+	private static Mutex s_mutex;
+	private static FileStream? s_file;
+	private static bool s_first;
+	private static int64 s_epoch;
+	private static Gee.HashMap<string, Rate>? s_rates;
+
+	public static bool enabled()
+	{
+		return s_enabled;
+	}
+
+	/**
+	 * Start writing a trace.
+	 *
+	 * @param filename the file to write the trace to.
+	 */
+	public static void start(string filename)
+	{
+		s_mutex.lock();
+
+		if (s_file == null)
+		{
+			s_file = FileStream.open(filename, "w");
+
+			if (s_file == null)
+			{
+				stderr.printf("Failed to open trace file `%s'\n", filename);
+			}
+			else
+			{
+				s_file.puts("[");
+
+				s_first = true;
+				s_epoch = get_monotonic_time();
+				s_rates = new Gee.HashMap<string, Rate>();
+				s_enabled = true;
+			}
+		}
+
+		s_mutex.unlock();
+	}
+
+	/**
+	 * Finish writing the trace.
+	 */
+	public static void stop()
+	{
+		s_mutex.lock();
+
+		if (s_file != null)
+		{
+			s_enabled = false;
+
+			s_file.puts("\n]\n");
+			s_file.flush();
+
+			s_file = null;
+			s_rates = null;
+		}
+
+		s_mutex.unlock();
+	}
+
+	/**
+	 * Begin a span.
+	 *
+	 * @return the start of the span, to pass to end, or 0 when not tracing.
+	 */
+	public static int64 begin()
+	{
+		return s_enabled ? get_monotonic_time() : 0;
+	}
+
+	/**
+	 * End a span.
+	 *
+	 * @param span the start of the span, as returned by begin or
+	 *             get_monotonic_time.
+	 * @param name the name of the span.
+	 */
+	public static void end(int64 span, string name)
+	{
+		if (s_enabled && span != 0)
+		{
+			write_span(span, get_monotonic_time(), name, null);
+		}
+	}
+
+	/**
+	 * End a span, with a detail shown with it.
+	 *
+	 * The detail is only formatted when tracing.
+	 */
+	[PrintfFormat]
+	public static void end_detail(int64 span, string name, string format, ...)
+	{
+		if (s_enabled && span != 0)
+		{
+			write_span(span, get_monotonic_time(), name, format.vprintf(va_list()));
+		}
+	}
+
+	/**
+	 * End a span, only recording it if it took at least @min_duration.
+	 *
+	 * Used for spans which are too frequent to record them all, only the
+	 * slow ones are of interest.
+	 *
+	 * @param min_duration the minimum duration, in microseconds.
+	 */
+	public static void end_slow(int64 span, string name, int64 min_duration)
+	{
+		if (s_enabled && span != 0)
+		{
+			var now = get_monotonic_time();
+
+			if (now - span >= min_duration)
+			{
+				write_span(span, now, name, null);
+			}
+		}
+	}
+
+	/**
+	 * Record a milestone, e.g. of the startup.
+	 */
+	public static void mark(string name)
+	{
+		if (!s_enabled)
+		{
+			return;
+		}
+
+		var thread = (uint64)(size_t)(void *)Thread.self<bool>();
+
+		s_mutex.lock();
+
+		if (s_file != null)
+		{
+			write_event("{\"name\":\"%s\",\"cat\":\"gitg\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%s,\"pid\":1,\"tid\":%s}".printf(
+			            escape(name),
+			            (get_monotonic_time() - s_epoch).to_string(),
+			            thread.to_string()));
+		}
+
+		s_mutex.unlock();
+	}
+
+	/**
+	 * Record the value of a counter.
+	 */
+	public static void counter(string name, double value)
+	{
+		if (!s_enabled)
+		{
+			return;
+		}
+
+		s_mutex.lock();
+
+		if (s_file != null)
+		{
+			write_event("{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%s,\"pid\":1,\"args\":{\"value\":%s}}".printf(
+			            escape(name),
+			            (get_monotonic_time() - s_epoch).to_string(),
+			            value.to_string()));
+		}
+
+		s_mutex.unlock();
+	}
+
+	/**
+	 * Count @n occurrences of @name, recorded as a counter of the number
+	 * of occurrences per second, e.g. rows rendered per second.
+	 */
+	public static void rate(string name, uint n = 1)
+	{
+		if (!s_enabled)
+		{
+			return;
+		}
+
+		var now = get_monotonic_time();
+		double? value = null;
+
+		s_mutex.lock();
+
+		if (s_rates != null)
+		{
+			var rate = s_rates[name];
+
+			if (rate == null)
+			{
+				rate = new Rate() { start = now };
+				s_rates[name] = rate;
+			}
+
+			rate.count += n;
+
+			if (now - rate.start >= RATE_INTERVAL)
+			{
+				value = rate.count * 1000000.0 / (now - rate.start);
+
+				rate.start = now;
+				rate.count = 0;
+			}
+		}
+
+		s_mutex.unlock();
+
+		if (value != null)
+		{
+			counter(name, value);
+		}
+	}
+
+	private static void write_span(int64 start, int64 end, string name, string? detail)
+	{
+		var thread = (uint64)(size_t)(void *)Thread.self<bool>();
+		var args = detail != null ? ",\"args\":{\"detail\":\"%s\"}".printf(escape(detail)) : "";
+
+		var ev = "{\"name\":\"%s\",\"cat\":\"gitg\",\"ph\":\"X\",\"ts\":%s,\"dur\":%s,\"pid\":1,\"tid\":%s%s}".printf(
+		         escape(name),
+		         (start - s_epoch).to_string(),
+		         (end - start).to_string(),
+		         thread.to_string(),
+		         args);
+
+		s_mutex.lock();
+
+		if (s_file != null)
+		{
+			write_event(ev);
+		}
+
+		s_mutex.unlock();
+	}
+
+	private static void write_event(string ev)
+	{
+		s_file.puts(s_first ? "\n" : ",\n");
+		s_file.puts(ev);
+
+		s_first = false;
+	}
+
+	private static string escape(string s)
+	{
+		var ret = new StringBuilder.sized(s.length);
+
+		for (var i = 0; i < s.length; i++)
+		{
+			var c = s[i];
+
+			if (c == '"' || c == '\\')
+			{
+				ret.append_c('\\');
+				ret.append_c(c);
+			}
+			else if ((uchar)c < 0x20)
+			{
+				ret.append_printf("\\u%04x", (uchar)c);
+			}
+			else
+			{
+				ret.append_c(c);
+			}
+		}
+
+		return ret.str;
+	}
+}
+
+}
+
+// ex:set ts=4 noet
@@ -20,17 +20,56 @@
 namespace GitgFiles
 {
 
+/* Loads the tree lazily, one directory at a time when it is expanded.
+ * Directories which are not loaded yet have a single placeholder child so
+ * that they can be expanded. The entries of directories are cached by the
+ * id of their tree, and when changing to another tree only the rows of
+ * directories whose id changed are updated, so that switching between
+ * commits which share most of their tree keeps the unchanged rows, and
+ * with them what is expanded.
+ */
 public class TreeStore : Gtk.TreeStore
 {
-	struct Item
+	// Number of directories of which the entries are cached
+	private const int MAX_DIRECTORIES = 10000;
+
+	private class Entry
+	{
+		public string name;
+		public Ggit.OId id;
+		public bool isdir;
+		public Icon icon;
+	}
+
+	private class Directory
 	{
-		string root;
-		Ggit.TreeEntry entry;
+		public Entry[] entries;
 	}
 
-	private uint d_update_id;
+	private Gitg.Repository? d_repository;
 	private Ggit.Tree d_tree;
 
+	private Gee.HashMap<Ggit.OId, Directory> d_directories;
+	private Gee.LinkedList<Ggit.OId> d_directories_order;
+
+	public Gitg.Repository? repository
+	{
+		get { return d_repository; }
+		set
+		{
+			if (d_repository != value)
+			{
+				d_repository = value;
+
+				d_directories.clear();
+				d_directories_order.clear();
+
+				d_tree = null;
+				clear();
+			}
+		}
+	}
+
 	public Ggit.Tree? tree
 	{
 		get { return d_tree; }
@@ -43,7 +82,12 @@ public class TreeStore : Gtk.TreeStore
 
 	construct
 	{
-		set_column_types(new Type[] {typeof(Icon), typeof(string), typeof(bool), typeof(Ggit.OId)});
+		set_column_types(new Type[] {typeof(Icon), typeof(string), typeof(bool), typeof(Ggit.OId), typeof(bool)});
+
+		d_directories = new Gee.HashMap<Ggit.OId, Directory>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+		                                                     (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+		d_directories_order = new Gee.LinkedList<Ggit.OId>();
 
 		set_sort_func(0, (model, a, b) => {
 			string aname;
@@ -72,17 +116,6 @@ public class TreeStore : Gtk.TreeStore
 		set_sort_column_id(0, Gtk.SortType.ASCENDING);
 	}
 
-	protected override void dispose()
-	{
-		if (d_update_id != 0)
-		{
-			Source.remove(d_update_id);
-			d_update_id = 0;
-		}
-
-		base.dispose();
-	}
-
 	public Ggit.OId get_id(Gtk.TreeIter iter)
 	{
 		Ggit.OId ret;
@@ -150,85 +183,174 @@ public class TreeStore : Gtk.TreeStore
 		return icon;
 	}
 
-	private void update()
+	private bool get_loaded(Gtk.TreeIter iter)
 	{
-		if (d_update_id != 0)
-		{
-			Source.remove(d_update_id);
-			d_update_id = 0;
-		}
+		bool ret;
 
-		clear();
+		get(iter, 4, out ret);
 
-		if (d_tree == null)
+		return ret;
+	}
+
+	/**
+	 * Load the children of a directory, if not loaded yet.
+	 *
+	 * @param iter the directory, usually right before it gets expanded.
+	 */
+	public void load_children(Gtk.TreeIter iter)
+	{
+		if (!get_isdir(iter) || get_loaded(iter))
 		{
 			return;
 		}
 
-		List<Item?>? items = null;
+		set(iter, 4, true);
 
-		try
-		{
-			d_tree.walk(Ggit.TreeWalkMode.PRE, (root, entry) => {
-				var item = Item();
-				item.root = root;
-				item.entry = entry;
-				items.prepend(item);
-				return 0;
-			});
-		} catch (Error e) { }
-
-		if (items == null)
+		// Replaces the placeholder
+		sync(iter, lookup_directory(get_id(iter)));
+	}
+
+	private Directory read_directory(Ggit.Tree tree)
+	{
+		var dir = new Directory();
+		var n = tree.size();
+
+		dir.entries = new Entry[n];
+
+		for (uint i = 0; i < n; i++)
 		{
-			return;
+			var entry = tree.get(i);
+
+			dir.entries[i] = new Entry() {
+				name = entry.get_name(),
+				id = entry.get_id(),
+				isdir = entry.get_file_mode() == Ggit.FileMode.TREE,
+				icon = get_entry_icon(entry)
+			};
 		}
 
-		items.reverse();
+		return dir;
+	}
+
+	private Directory lookup_directory(Ggit.OId id, Ggit.Tree? tree = null)
+	{
+		var dir = d_directories[id];
 
-		var paths = new HashTable<string, Gtk.TreePath>(str_hash, str_equal);
-		d_update_id = Idle.add(() => {
-			if (items == null)
+		if (dir != null)
+		{
+			return dir;
+		}
+
+		if (tree == null)
+		{
+			try
+			{
+				tree = d_repository.lookup<Ggit.Tree>(id);
+			}
+			catch (Error e)
 			{
-				d_update_id = 0;
-				return false;
+				stderr.printf("Failed to lookup tree: %s\n", e.message);
+				return new Directory();
 			}
+		}
 
-			Item item = items.data;
-			items.remove_link(items);
+		dir = read_directory(tree);
 
-			var root = item.root;
-			var entry = item.entry;
-			var isdir = entry.get_file_mode() == Ggit.FileMode.TREE;
+		d_directories[id] = dir;
+		d_directories_order.offer_tail(id);
 
-			Gtk.TreeIter? parent = null;
+		while (d_directories_order.size > MAX_DIRECTORIES)
+		{
+			d_directories.unset(d_directories_order.poll_head());
+		}
+
+		return dir;
+	}
 
-			if (root != "")
+	private void append_entry(Gtk.TreeIter? parent, Entry entry)
+	{
+		Gtk.TreeIter iter;
+
+		insert_with_values(out iter,
+		                   parent,
+		                   -1,
+		                   0, entry.icon,
+		                   1, entry.name,
+		                   2, entry.isdir,
+		                   3, entry.id,
+		                   4, false);
+
+		if (entry.isdir)
+		{
+			Gtk.TreeIter placeholder;
+
+			insert_with_values(out placeholder, iter, -1, 1, "", 2, false, 4, false);
+		}
+	}
+
+	/* Updates the children of @parent to the entries of @dir, keeping the
+	 * rows of entries which did not change.
+	 */
+	private void sync(Gtk.TreeIter? parent, Directory dir)
+	{
+		var entries = new Gee.HashMap<string, Entry>();
+
+		foreach (var entry in dir.entries)
+		{
+			entries[entry.name] = entry;
+		}
+
+		Gtk.TreeIter iter;
+		var valid = iter_children(out iter, parent);
+
+		while (valid)
+		{
+			var name = get_name(iter);
+			var entry = entries[name];
+
+			if (entry == null || entry.isdir != get_isdir(iter))
 			{
-				get_iter(out parent, paths.lookup(root));
+				valid = remove(ref iter);
+				continue;
 			}
 
-			Icon icon = get_entry_icon(entry);
+			entries.unset(name);
 
-			Gtk.TreeIter iter;
-			append(out iter, parent);
-			set(iter,
-			    0, icon,
-			    1, entry.get_name(),
-			    2, isdir,
-			    3, entry.get_id());
+			var id = get_id(iter);
 
-			if (isdir)
+			if (!entry.id.equal(id))
 			{
-				string path = root + entry.get_name() + Path.DIR_SEPARATOR_S;
+				set(iter, 3, entry.id);
 
-				paths.insert(path, get_path(iter));
+				if (entry.isdir && get_loaded(iter))
+				{
+					sync(iter, lookup_directory(entry.id));
+				}
 			}
 
-			return true;
-		});
+			valid = iter_next(ref iter);
+		}
+
+		foreach (var entry in dir.entries)
+		{
+			if (entries.has_key(entry.name))
+			{
+				append_entry(parent, entry);
+			}
+		}
 	}
-}
 
+	private void update()
+	{
+		if (d_tree == null || d_repository == null)
+		{
+			clear();
+			return;
+		}
+
+		sync(null, lookup_directory(d_tree.get_id(), d_tree));
+	}
+}
 }
 
 // vi:ts=4
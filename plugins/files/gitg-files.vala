@@ -82,6 +82,7 @@ namespace GitgFiles
 		{
 			history.foreach_selected((commit) => {
 				d_whenMapped.update(() => {
+					d_model.repository = application.repository;
 					d_model.tree = commit.get_tree();
 				}, this);
 
@@ -133,6 +134,12 @@ namespace GitgFiles
 
 			tv.get_selection().changed.connect(selection_changed);
 			tv.row_activated.connect(open_file_externally);
+
+			tv.test_expand_row.connect((iter, path) => {
+				d_model.load_children(iter);
+				return false;
+			});
+
 			tv.button_press_event.connect ((event) => {
 					Gdk.Event *ev = (Gdk.Event *)(event);
 					if (ev->triggers_context_menu()) {
@@ -0,0 +1,455 @@
+/*
+ * Builds a synthetic repository of a given shape and measures how long the
+ * history takes to load in the commit model (until the first batch of rows
+ * is shown and until it is finished), the throughput of the lane layout,
+ * the time to render the lanes of a row and the peak memory use.
+ *
+ * Run with --json to get a single line of JSON, suitable for tracking the
+ * results across versions.
+ */
+class BenchmarkHistoryLoad
+{
+	private static string? s_shape = null;
+	private static int s_commits = 10000;
+	private static int s_render_rows = 2000;
+	private static bool s_json = false;
+
+	private const OptionEntry[] s_entries = {
+		{"shape", 0, 0, OptionArg.STRING, ref s_shape, "Shape of the history (linear, merges, octopus, permanent)", "SHAPE"},
+		{"commits", 0, 0, OptionArg.INT, ref s_commits, "Number of commits", "N"},
+		{"render-rows", 0, 0, OptionArg.INT, ref s_render_rows, "Number of rows to render", "N"},
+		{"json", 0, 0, OptionArg.NONE, ref s_json, "Output the results as JSON", null},
+		{null}
+	};
+
+	// Number of branches of the merges and permanent shapes
+	private const int BRANCHES = 16;
+
+	// Number of branches merged by each octopus merge
+	private const int OCTOPUS = 8;
+
+	private class Builder
+	{
+		private Gitg.Repository d_repo;
+		private Ggit.Tree d_tree;
+		private int d_count;
+
+		public Builder(Gitg.Repository repo) throws Error
+		{
+			d_repo = repo;
+
+			var treeoid = repo.get_index().write_tree();
+			d_tree = repo.lookup<Ggit.Tree>(treeoid);
+		}
+
+		public int count
+		{
+			get { return d_count; }
+		}
+
+		public Ggit.Commit commit(Ggit.Commit?[] parents) throws Error
+		{
+			var sig = new Ggit.Signature("gitg benchmark",
+			                             "gitg-benchmark@gnome.org",
+			                             new DateTime.from_unix_utc(d_count));
+
+			var p = new Ggit.Commit[0];
+
+			foreach (var parent in parents)
+			{
+				if (parent != null)
+				{
+					p += parent;
+				}
+			}
+
+			var id = d_repo.create_commit(null, sig, sig, null, "commit %d".printf(d_count), d_tree, p);
+			d_count++;
+
+			return d_repo.lookup<Ggit.Commit>(id);
+		}
+	}
+
+	/* Creates a history of at least @n commits, returning the tips to walk
+	 * from and the number of commits created in @count.
+	 */
+	private static Ggit.OId[] build(Gitg.Repository repo, string shape, int n, out int count) throws Error
+	{
+		var b = new Builder(repo);
+		var ret = build_shape(b, shape, n);
+
+		count = b.count;
+		return ret;
+	}
+
+	private static Ggit.OId[] build_shape(Builder b, string shape, int n) throws Error
+	{
+		switch (shape)
+		{
+			case "linear":
+			{
+				Ggit.Commit? tip = null;
+
+				while (b.count < n)
+				{
+					tip = b.commit(new Ggit.Commit?[] {tip});
+				}
+
+				return new Ggit.OId[] {tip.get_id()};
+			}
+			case "merges":
+			{
+				// Branches forking off the mainline and merged back in
+				// regularly, round robin
+				var main = b.commit(new Ggit.Commit?[0]);
+				var branches = new Ggit.Commit?[BRANCHES];
+
+				for (var i = 0; b.count < n; i++)
+				{
+					var idx = i % BRANCHES;
+
+					if (branches[idx] == null)
+					{
+						branches[idx] = b.commit(new Ggit.Commit?[] {main});
+					}
+					else if (i % 3 == 0)
+					{
+						main = b.commit(new Ggit.Commit?[] {main, branches[idx]});
+						branches[idx] = null;
+					}
+					else
+					{
+						branches[idx] = b.commit(new Ggit.Commit?[] {branches[idx]});
+					}
+				}
+
+				var ret = new Ggit.OId[] {main.get_id()};
+
+				foreach (var branch in branches)
+				{
+					if (branch != null)
+					{
+						ret += branch.get_id();
+					}
+				}
+
+				return ret;
+			}
+			case "octopus":
+			{
+				var main = b.commit(new Ggit.Commit?[0]);
+
+				while (b.count < n)
+				{
+					var parents = new Ggit.Commit?[] {main};
+
+					for (var i = 0; i < OCTOPUS; i++)
+					{
+						var c = b.commit(new Ggit.Commit?[] {main});
+						parents += b.commit(new Ggit.Commit?[] {c});
+					}
+
+					main = b.commit(parents);
+				}
+
+				return new Ggit.OId[] {main.get_id()};
+			}
+			case "permanent":
+			{
+				// Independent branches which are never merged
+				var root = b.commit(new Ggit.Commit?[0]);
+				var branches = new Ggit.Commit[BRANCHES];
+
+				for (var i = 0; i < BRANCHES; i++)
+				{
+					branches[i] = root;
+				}
+
+				for (var i = 0; b.count < n; i++)
+				{
+					branches[i % BRANCHES] = b.commit(new Ggit.Commit?[] {branches[i % BRANCHES]});
+				}
+
+				var ret = new Ggit.OId[0];
+
+				foreach (var branch in branches)
+				{
+					ret += branch.get_id();
+				}
+
+				return ret;
+			}
+		}
+
+		throw new OptionError.BAD_VALUE("Unknown shape `%s'".printf(shape));
+	}
+
+	private static void load(Gitg.CommitModel model, out double first_batch, out double finished)
+	{
+		var loop = new MainLoop();
+		var timer = new Timer();
+		double first = -1;
+
+		var updateid = model.update.connect((added) => {
+			if (first < 0 && added > 0)
+			{
+				first = timer.elapsed();
+			}
+		});
+
+		var finishedid = model.finished.connect(() => {
+			loop.quit();
+		});
+
+		model.reload();
+		loop.run();
+
+		finished = timer.elapsed();
+		first_batch = first < 0 ? finished : first;
+
+		model.disconnect(updateid);
+		model.disconnect(finishedid);
+	}
+
+	/* Lays out the commits of the model again, returning the number of
+	 * commits laid out per second.
+	 */
+	private static double layout(Gitg.CommitModel model, Ggit.OId[] tips, Ggit.OId[] permanent)
+	{
+		var commits = new Gitg.Commit[model.size()];
+
+		try
+		{
+			for (uint i = 0; i < commits.length; i++)
+			{
+				var c = model[i];
+
+				// Look the commit up again, the one of the model has its
+				// lanes already
+				commits[i] = model.repository.lookup<Gitg.Commit>(c.get_id());
+			}
+		}
+		catch (Error e)
+		{
+			stderr.printf("Failed to lookup commit: %s\n", e.message);
+			return 0;
+		}
+
+		var roots = new Gee.HashSet<Ggit.OId>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+		                                      (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+		foreach (var tip in tips)
+		{
+			roots.add(tip);
+		}
+
+		var lanes = new Gitg.Lanes();
+		lanes.reset(permanent, roots);
+
+		var timer = new Timer();
+
+		foreach (var commit in commits)
+		{
+			SList<Gitg.Lane> l;
+			int pos;
+
+			lanes.next(commit, out l, out pos, true);
+
+			Gitg.Commit? miss;
+
+			while ((miss = lanes.next_unmissed()) != null)
+			{
+				lanes.next(miss, out l, out pos);
+			}
+		}
+
+		lanes.finish();
+
+		return commits.length / timer.elapsed();
+	}
+
+	/* Renders the lanes of the first rows, returning the time per row in
+	 * microseconds.
+	 */
+	private static double render(Gitg.CommitModel model, int nrows)
+	{
+		var widget = new Gtk.TreeView();
+		var renderer = new Gitg.CellRendererLanes();
+
+		var surface = new Cairo.ImageSurface(Cairo.Format.ARGB32, 800, 24);
+		var context = new Cairo.Context(surface);
+
+		var area = Gdk.Rectangle() {
+			x = 0,
+			y = 0,
+			width = 800,
+			height = 24
+		};
+
+		var n = uint.min(model.size(), nrows);
+
+		if (n == 0)
+		{
+			return 0;
+		}
+
+		var timer = new Timer();
+
+		for (uint i = 0; i < n; i++)
+		{
+			renderer.commit = model[i];
+			renderer.next_commit = model[i + 1];
+			renderer.text = renderer.commit.get_subject();
+
+			renderer.render(context, widget, area, area, (Gtk.CellRendererState)0);
+		}
+
+		return timer.elapsed() * 1000000 / n;
+	}
+
+	/* Peak resident set size in kB, or -1 if not available. */
+	private static int64 peak_rss()
+	{
+		string contents;
+
+		try
+		{
+			FileUtils.get_contents("/proc/self/status", out contents);
+		}
+		catch
+		{
+			return -1;
+		}
+
+		foreach (var line in contents.split("\n"))
+		{
+			if (line.has_prefix("VmHWM:"))
+			{
+				return int64.parse(line.substring(6).strip().split(" ")[0]);
+			}
+		}
+
+		return -1;
+	}
+
+	public static int main(string[] args)
+	{
+		var ctx = new OptionContext("- benchmark history loading");
+		ctx.add_main_entries(s_entries, null);
+
+		try
+		{
+			ctx.parse(ref args);
+		}
+		catch (Error e)
+		{
+			stderr.printf("%s\n", e.message);
+			return 1;
+		}
+
+		var shape = s_shape != null ? s_shape : "linear";
+		var has_gtk = Gtk.init_check(ref args);
+
+		try
+		{
+			Gitg.init();
+		}
+		catch (Error e)
+		{
+			stderr.printf("Failed to initialize ggit: %s\n", e.message);
+			return 1;
+		}
+
+		string wd;
+		Gitg.Repository repo;
+		Ggit.OId[] tips;
+		int count;
+
+		var timer = new Timer();
+
+		try
+		{
+			wd = DirUtils.make_tmp("gitg-benchmark-XXXXXX");
+			repo = Gitg.Repository.init_repository(File.new_for_path(wd), false);
+			tips = build(repo, shape, s_commits, out count);
+		}
+		catch (Error e)
+		{
+			stderr.printf("Failed to create repository: %s\n", e.message);
+			return 1;
+		}
+
+		var build_time = timer.elapsed();
+
+		var permanent = shape == "permanent" ? tips : new Ggit.OId[0];
+		var model = new Gitg.CommitModel(repo);
+
+		model.use_graph_cache = false;
+		model.set_include(tips);
+		model.set_permanent_lanes(permanent);
+
+		double first_batch;
+		double finished;
+
+		load(model, out first_batch, out finished);
+
+		var rows = model.size();
+		var layout_rate = layout(model, tips, permanent);
+		var render_us = has_gtk ? render(model, s_render_rows) : -1;
+		var rss = peak_rss();
+
+		if (s_json)
+		{
+			stdout.printf("{\"shape\": \"%s\", \"commits\": %u, \"build_s\": %.3f, " +
+			              "\"first_batch_ms\": %.2f, \"finished_ms\": %.2f, " +
+			              "\"layout_commits_per_s\": %.0f, \"render_us_per_row\": %s, " +
+			              "\"peak_rss_kb\": %s}\n",
+			              shape,
+			              rows,
+			              build_time,
+			              first_batch * 1000,
+			              finished * 1000,
+			              layout_rate,
+			              render_us >= 0 ? "%.2f".printf(render_us) : "null",
+			              rss >= 0 ? rss.to_string() : "null");
+		}
+		else
+		{
+			stdout.printf("shape:             %s\n", shape);
+			stdout.printf("commits:           %u (built in %.2f s)\n", rows, build_time);
+			stdout.printf("first batch:       %.2f ms\n", first_batch * 1000);
+			stdout.printf("finished:          %.2f ms\n", finished * 1000);
+			stdout.printf("layout:            %.0f commits/s\n", layout_rate);
+
+			if (render_us >= 0)
+			{
+				stdout.printf("render:            %.2f us/row\n", render_us);
+			}
+			else
+			{
+				stdout.printf("render:            skipped, no display\n");
+			}
+
+			if (rss >= 0)
+			{
+				stdout.printf("peak rss:          %s kB\n", rss.to_string());
+			}
+		}
+
+		var ret = rows == count ? 0 : 1;
+
+		if (ret != 0)
+		{
+			stderr.printf("Loaded %u out of %d commits\n", rows, count);
+		}
+
+		try
+		{
+			Process.spawn_command_line_sync("rm -rf " + Shell.quote(wd));
+		} catch {}
+
+		return ret;
+	}
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,136 @@
+/*
+ * Lays out chains of commits of increasing length in the worst order for
+ * missed commits (oldest first), and prints the time per commit. The time
+ * per commit should stay the same as the number of commits grows.
+ */
+class BenchmarkLanesMisses
+{
+	private static Gitg.Commit[] create_chain(Ggit.Repository repo, int n) throws Error
+	{
+		var ret = new Gitg.Commit[0];
+		var treeoid = repo.get_index().write_tree();
+		var tree = repo.lookup(treeoid, typeof(Ggit.Tree)) as Ggit.Tree;
+
+		var parents = new Ggit.Commit[0];
+
+		for (var i = 0; i < n; i++)
+		{
+			var sig = new Ggit.Signature("gitg benchmark",
+			                             "gitg-benchmark@gnome.org",
+			                             new DateTime.from_unix_utc(i));
+
+			var id = repo.create_commit(null, sig, sig, null, "commit %d".printf(i), tree, parents);
+			var commit = repo.lookup(id, typeof(Gitg.Commit)) as Gitg.Commit;
+
+			ret += commit;
+			parents = new Ggit.Commit[] { commit };
+		}
+
+		return ret;
+	}
+
+	private static uint layout(Gitg.Commit[] commits)
+	{
+		var roots = new Gee.HashSet<Ggit.OId>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+		                                      (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+		roots.add(commits[commits.length - 1].get_id());
+
+		var lanes = new Gitg.Lanes();
+		lanes.reset(null, roots);
+
+		uint laid = 0;
+
+		foreach (var commit in commits)
+		{
+			SList<Gitg.Lane> l;
+			int pos;
+
+			if (lanes.next(commit, out l, out pos, true))
+			{
+				laid++;
+			}
+
+			Gitg.Commit? miss;
+
+			while ((miss = lanes.next_unmissed()) != null)
+			{
+				if (lanes.next(miss, out l, out pos))
+				{
+					laid++;
+				}
+			}
+		}
+
+		return laid;
+	}
+
+	public static int main(string[] args)
+	{
+		try
+		{
+			Gitg.init();
+		}
+		catch (Error e)
+		{
+			stderr.printf("Failed to initialize ggit: %s\n", e.message);
+			return 1;
+		}
+
+		string wd;
+		Ggit.Repository repo;
+
+		try
+		{
+			wd = DirUtils.make_tmp("gitg-benchmark-XXXXXX");
+			repo = Ggit.Repository.init_repository(File.new_for_path(wd), false);
+		}
+		catch (Error e)
+		{
+			stderr.printf("Failed to create repository: %s\n", e.message);
+			return 1;
+		}
+
+		var ret = 0;
+
+		for (var n = 1000; n <= 16000; n *= 2)
+		{
+			Gitg.Commit[] commits;
+
+			try
+			{
+				commits = create_chain(repo, n);
+			}
+			catch (Error e)
+			{
+				stderr.printf("Failed to create commits: %s\n", e.message);
+				ret = 1;
+				break;
+			}
+
+			var timer = new Timer();
+			var laid = layout(commits);
+			var elapsed = timer.elapsed();
+
+			if (laid != n)
+			{
+				stderr.printf("Laid out %u out of %d commits\n", laid, n);
+				ret = 1;
+			}
+
+			stdout.printf("%6d commits: %8.2f ms, %6.2f us/commit\n",
+			              n,
+			              elapsed * 1000,
+			              elapsed * 1000000 / n);
+		}
+
+		try
+		{
+			Process.spawn_command_line_sync("rm -rf " + Shell.quote(wd));
+		} catch {}
+
+		return ret;
+	}
+}
+
+// ex:set ts=4 noet
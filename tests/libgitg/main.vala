@@ -26,7 +26,17 @@ class LibGitg.Test.Main
 		m.add(new Stage(),
 		      new Date(),
 		      new Commit(),
-		      new Encoding());
+		      new Encoding(),
+		      new Lanes(),
+		      new CommitSearchIndex(),
+		      new CommitDecoder(),
+		      new OIdTable(),
+		      new AheadBehindCache(),
+		      new DiffImageCache(),
+		      new DiffInline(),
+		      new Repository(),
+		      new CommitModel(),
+		      new CommitGraphCache());
 
 		m.run();
 	}
@@ -0,0 +1,157 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.AheadBehindCache : Gitg.Test.Repository
+{
+	protected override void set_up()
+	{
+		base.set_up();
+
+		commit("a", "a\n");
+		create_branch("topic");
+
+		commit("b", "b\n");
+		commit("c", "c\n");
+
+		checkout_branch("topic");
+		commit("d", "d\n");
+	}
+
+	private Ggit.OId? commit_at(int64 time, Ggit.OId[] parents)
+	{
+		try
+		{
+			var sig = new Ggit.Signature("gitg tester", "gitg-tester@gnome.org", new DateTime.from_unix_utc(time));
+			var tree = lookup_commit("master").get_tree();
+
+			var commits = new Ggit.Commit[parents.length];
+
+			for (var i = 0; i < parents.length; i++)
+			{
+				commits[i] = d_repository.lookup<Ggit.Commit>(parents[i]);
+			}
+
+			return d_repository.create_commit(null, sig, sig, null, "commit", tree, commits);
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+			return null;
+		}
+	}
+
+	protected virtual signal void test_lookup()
+	{
+		var cache = d_repository.ahead_behind;
+		var loop = new MainLoop();
+
+		var master = lookup_commit("master").get_id();
+		var topic = lookup_commit("topic").get_id();
+
+		size_t expected_ahead;
+		size_t expected_behind;
+
+		try
+		{
+			d_repository.get_ahead_behind(topic, master, out expected_ahead, out expected_behind);
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+		}
+
+		var remaining = 2;
+
+		// Both are computed in the same walk
+		cache.lookup.begin(topic, master, (obj, res) => {
+			size_t ahead;
+			size_t behind;
+
+			assert(cache.lookup.end(res, out ahead, out behind));
+
+			assert_uinteq((uint)ahead, (uint)expected_ahead);
+			assert_uinteq((uint)behind, (uint)expected_behind);
+			assert_uinteq((uint)ahead, 1);
+			assert_uinteq((uint)behind, 2);
+
+			if (--remaining == 0)
+			{
+				loop.quit();
+			}
+		});
+
+		cache.lookup.begin(master, master, (obj, res) => {
+			size_t ahead;
+			size_t behind;
+
+			assert(cache.lookup.end(res, out ahead, out behind));
+
+			assert_uinteq((uint)ahead, 0);
+			assert_uinteq((uint)behind, 0);
+
+			if (--remaining == 0)
+			{
+				loop.quit();
+			}
+		});
+
+		loop.run();
+
+		size_t ahead;
+		size_t behind;
+
+		assert_booleq(cache.cached(master, topic, out ahead, out behind), false);
+		assert(cache.cached(topic, master, out ahead, out behind));
+
+		assert_uinteq((uint)ahead, 1);
+		assert_uinteq((uint)behind, 2);
+	}
+
+	protected virtual signal void test_lookup_skewed()
+	{
+		var cache = d_repository.ahead_behind;
+		var loop = new MainLoop();
+
+		// The upstream only reaches the merge base through a commit dated
+		// older than all the others, which is walked last
+		var root = commit_at(1000, new Ggit.OId[] {});
+		var base_id = commit_at(2000, new Ggit.OId[] { root });
+		var local = commit_at(3000, new Ggit.OId[] { base_id });
+		var skewed = commit_at(500, new Ggit.OId[] { base_id });
+		var upstream = commit_at(4000, new Ggit.OId[] { skewed });
+
+		cache.lookup.begin(local, upstream, (obj, res) => {
+			size_t ahead;
+			size_t behind;
+
+			assert(cache.lookup.end(res, out ahead, out behind));
+
+			assert_uinteq((uint)ahead, 1);
+			assert_uinteq((uint)behind, 2);
+
+			loop.quit();
+		});
+
+		loop.run();
+	}
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,93 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.CommitDecoder : Gitg.Test.Repository
+{
+	protected virtual signal void test_order()
+	{
+		var ids = new Ggit.OId[0];
+
+		try
+		{
+			var treeoid = d_repository.get_index().write_tree();
+			var tree = d_repository.lookup<Ggit.Tree>(treeoid);
+			var parents = new Ggit.Commit[0];
+
+			for (var i = 0; i < 1000; i++)
+			{
+				var sig = get_verified_committer();
+				var id = d_repository.create_commit(null, sig, sig, null, "commit %d".printf(i), tree, parents);
+
+				ids += id;
+				parents = new Ggit.Commit[] { d_repository.lookup<Ggit.Commit>(id) };
+			}
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+		}
+
+		var decoder = new Gitg.CommitDecoder(d_repository);
+
+		// Interleave pushing and popping like the walk does
+		var popped = 0;
+
+		for (var i = 0; i < ids.length; i++)
+		{
+			decoder.push(ids[i]);
+
+			if (i % 3 == 0)
+			{
+				Ggit.OId? id;
+				Gitg.Commit? commit;
+
+				assert(decoder.pop(out id, out commit));
+				assert(commit != null);
+				assert_streq(commit.get_subject(), "commit %d".printf(popped));
+				assert(id.equal(ids[popped]));
+
+				popped++;
+			}
+		}
+
+		while (true)
+		{
+			Ggit.OId? id;
+			Gitg.Commit? commit;
+
+			if (!decoder.pop(out id, out commit))
+			{
+				break;
+			}
+
+			assert(commit != null);
+			assert_streq(commit.get_subject(), "commit %d".printf(popped));
+			popped++;
+		}
+
+		assert_inteq(popped, ids.length);
+		assert_uinteq(decoder.queued, 0);
+
+		decoder.close();
+	}
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,276 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.CommitGraphCache : Gitg.Test.Repository
+{
+	private const int NUM_ROWS = 3;
+
+	private Gitg.LaneStore d_store;
+	private uint[] d_chunks;
+	private uint[] d_firsts;
+	private uint[] d_nlanes;
+
+	private Ggit.OId oid(int i)
+	{
+		return new Ggit.OId.from_string("%040x".printf(i + 1));
+	}
+
+	private Gitg.Lane lane(uint color, Gitg.LaneTag tag, int[] from)
+	{
+		var c = new Gitg.Color();
+		c.idx = color;
+
+		var ret = new Gitg.Lane.with_color(c);
+		ret.tag = tag;
+
+		foreach (var f in from)
+		{
+			ret.from.append(f);
+		}
+
+		return ret;
+	}
+
+	// The lanes of row @i, the first row starts a lane and the next ones
+	// merge into it
+	private SList<Gitg.Lane> row_lanes(int i)
+	{
+		var ret = new SList<Gitg.Lane>();
+
+		ret.append(lane(0, i == 0 ? Gitg.LaneTag.START : Gitg.LaneTag.NONE, new int[] { 0 }));
+
+		for (var j = 0; j < i; j++)
+		{
+			ret.append(lane(j + 1, Gitg.LaneTag.NONE, new int[] { 0, j + 1 }));
+		}
+
+		return ret;
+	}
+
+	private Gitg.CommitGraphCacheWalk create_walk()
+	{
+		var walk = new Gitg.CommitGraphCacheWalk();
+
+		walk.include = new Ggit.OId[] { oid(0), oid(100) };
+		walk.exclude = new Ggit.OId[] { oid(101) };
+		walk.permanent = new Ggit.OId[0];
+		walk.length = NUM_ROWS;
+		walk.prefix = 0x123456789abcdef0;
+
+		walk.checkpoints = new Gitg.CommitGraphCacheCheckpoint[] {
+			new Gitg.CommitGraphCacheCheckpoint(oid(0),
+			                                    Checksum.compute_for_string(ChecksumType.SHA1, "state"),
+			                                    0,
+			                                    0)
+		};
+
+		return walk;
+	}
+
+	private Gitg.CommitGraphCache save(string name)
+	{
+		d_store = new Gitg.LaneStore();
+
+		d_chunks = new uint[NUM_ROWS];
+		d_firsts = new uint[NUM_ROWS];
+		d_nlanes = new uint[NUM_ROWS];
+
+		for (var i = 0; i < NUM_ROWS; i++)
+		{
+			var lanes = row_lanes(i);
+			uint chunk;
+			uint first;
+
+			d_store.append(lanes, out chunk, out first);
+
+			d_chunks[i] = chunk;
+			d_firsts[i] = first;
+			d_nlanes[i] = lanes.length();
+		}
+
+		var file = d_repository.get_location().get_child("gitg").get_child(name);
+		var cache = new Gitg.CommitGraphCache(file);
+
+		cache.save(create_walk(), NUM_ROWS, (idx, out id, out mylane, out lanes, out from) => {
+			id = oid((int)idx);
+			mylane = idx;
+			lanes = d_store.get_lanes(d_chunks[idx], d_firsts[idx], d_nlanes[idx], out from);
+		});
+
+		return new Gitg.CommitGraphCache(file);
+	}
+
+	private void assert_ids_equal(Ggit.OId[] a, Ggit.OId[] b)
+	{
+		assert_inteq(a.length, b.length);
+
+		for (var i = 0; i < a.length; i++)
+		{
+			assert_streq(a[i].to_string(), b[i].to_string());
+		}
+	}
+
+	private void write_contents(File file, uint8[] contents)
+	{
+		try
+		{
+			FileUtils.set_data(file.get_path(), contents);
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+		}
+	}
+
+	private uint8[] read_contents(File file)
+	{
+		uint8[] ret;
+
+		try
+		{
+			FileUtils.get_data(file.get_path(), out ret);
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+			ret = new uint8[0];
+		}
+
+		return ret;
+	}
+
+	protected virtual signal void test_round_trip()
+	{
+		var cache = save("round-trip.lanes");
+
+		var walk = cache.read_walk();
+		var expected = create_walk();
+
+		assert_nonnull(walk);
+
+		assert_ids_equal(walk.include, expected.include);
+		assert_ids_equal(walk.exclude, expected.exclude);
+		assert_ids_equal(walk.permanent, expected.permanent);
+
+		assert_uinteq(walk.length, expected.length);
+		assert(walk.prefix == expected.prefix);
+
+		assert_inteq(walk.checkpoints.length, 1);
+		assert_streq(walk.checkpoints[0].id.to_string(), expected.checkpoints[0].id.to_string());
+		assert_streq(walk.checkpoints[0].digest, expected.checkpoints[0].digest);
+
+		var n = 0;
+
+		var loaded = cache.load((id, lanes, mylane) => {
+			var expected_lanes = row_lanes(n);
+
+			assert_streq(id.to_string(), oid(n).to_string());
+			assert_inteq(mylane, n);
+			assert_uinteq(lanes.length(), expected_lanes.length());
+
+			for (uint i = 0; i < lanes.length(); i++)
+			{
+				var l = lanes.nth_data(i);
+				var e = expected_lanes.nth_data(i);
+
+				assert_uinteq(l.color.idx, e.color.idx);
+				assert_inteq((int)l.tag, (int)e.tag);
+				assert_uinteq(l.from.length(), e.from.length());
+
+				for (uint j = 0; j < l.from.length(); j++)
+				{
+					assert_inteq(l.from.nth_data(j), e.from.nth_data(j));
+				}
+			}
+
+			n++;
+			return true;
+		});
+
+		assert(loaded);
+		assert_inteq(n, NUM_ROWS);
+	}
+
+	protected virtual signal void test_reject_invalid()
+	{
+		var cache = save("invalid.lanes");
+		var contents = read_contents(cache.file);
+
+		// Another version, stored right after the magic
+		var other = contents[0:contents.length];
+		other[4] = 2;
+
+		write_contents(cache.file, other);
+		assert(cache.read_walk() == null);
+
+		// Not a cache at all
+		other = contents[0:contents.length];
+		other[0] = 0;
+
+		write_contents(cache.file, other);
+		assert(cache.read_walk() == null);
+
+		// Truncated in the walk
+		write_contents(cache.file, contents[0:10]);
+		assert(cache.read_walk() == null);
+
+		// Truncated in the rows
+		write_contents(cache.file, contents[0:contents.length - 3]);
+		assert_nonnull(cache.read_walk());
+		assert(!cache.load(() => { return true; }));
+
+		// Load without reading the walk first
+		write_contents(cache.file, contents);
+		assert(!cache.load(() => { return true; }));
+	}
+
+	protected virtual signal void test_prune()
+	{
+		for (var i = 0; i < 10; i++)
+		{
+			save("%d.lanes".printf(i));
+		}
+
+		var dir = d_repository.get_location().get_child("gitg");
+		var n = 0;
+
+		try
+		{
+			var e = dir.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NONE);
+			FileInfo? info;
+
+			while ((info = e.next_file()) != null)
+			{
+				// No temporary files are left behind either
+				assert(info.get_name().has_suffix(".lanes"));
+				n++;
+			}
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+		}
+
+		assert_inteq(n, 8);
+	}
+}
+
+// ex:set ts=4 noet
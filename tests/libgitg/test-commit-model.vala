@@ -0,0 +1,235 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.CommitModel : Gitg.Test.Repository
+{
+	// Long enough for the walk to record several checkpoints
+	private const int HISTORY_LENGTH = 600;
+
+	private Ggit.Tree d_tree;
+	private Ggit.OId[] d_history;
+
+	protected override void set_up()
+	{
+		base.set_up();
+
+		try
+		{
+			var treeoid = d_repository.get_index().write_tree();
+			d_tree = d_repository.lookup<Ggit.Tree>(treeoid);
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+		}
+
+		d_history = new Ggit.OId[0];
+
+		Ggit.OId? parent = null;
+
+		for (var i = 0; i < HISTORY_LENGTH; i++)
+		{
+			parent = create_commit("commit %d".printf(i),
+			                       1000 + i * 10,
+			                       parent != null ? new Ggit.OId[] { parent } : new Ggit.OId[0]);
+
+			d_history += parent;
+		}
+	}
+
+	private Ggit.OId? create_commit(string message, int64 time, Ggit.OId[] parents)
+	{
+		try
+		{
+			var sig = new Ggit.Signature("gitg tester", "gitg-tester@gnome.org", new DateTime.from_unix_utc(time));
+			var commits = new Ggit.Commit[parents.length];
+
+			for (var i = 0; i < parents.length; i++)
+			{
+				commits[i] = d_repository.lookup<Ggit.Commit>(parents[i]);
+			}
+
+			return d_repository.create_commit(null, sig, sig, null, message, d_tree, commits);
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+			return null;
+		}
+	}
+
+	private Gitg.CommitModel create_model(Ggit.OId[] include)
+	{
+		var model = new Gitg.CommitModel(d_repository);
+
+		model.use_graph_cache = false;
+		model.set_include(include);
+
+		return model;
+	}
+
+	private void run(Gitg.CommitModel model, bool incremental)
+	{
+		var loop = new MainLoop();
+		var finished = false;
+
+		var id = model.finished.connect(() => {
+			finished = true;
+			loop.quit();
+		});
+
+		if (incremental)
+		{
+			model.reload_incremental();
+		}
+		else
+		{
+			model.reload();
+		}
+
+		if (!finished)
+		{
+			loop.run();
+		}
+
+		model.disconnect(id);
+	}
+
+	private void assert_lanes_equal(SList<Gitg.Lane> a, SList<Gitg.Lane> b)
+	{
+		assert_uinteq(a.length(), b.length());
+
+		for (uint i = 0; i < a.length(); i++)
+		{
+			var la = a.nth_data(i);
+			var lb = b.nth_data(i);
+
+			assert_uinteq(la.color.idx, lb.color.idx);
+			assert_inteq((int)la.tag, (int)lb.tag);
+			assert_uinteq(la.from.length(), lb.from.length());
+
+			for (uint j = 0; j < la.from.length(); j++)
+			{
+				assert_inteq(la.from.nth_data(j), lb.from.nth_data(j));
+			}
+		}
+	}
+
+	/**
+	 * The rows of @model are the same as after a full reload.
+	 */
+	private void assert_same_as_reload(Gitg.CommitModel model, Ggit.OId[] include)
+	{
+		var fresh = create_model(include);
+		run(fresh, false);
+
+		assert_uinteq(model.size(), fresh.size());
+
+		for (uint i = 0; i < fresh.size(); i++)
+		{
+			var a = model.get(i);
+			var b = fresh.get(i);
+
+			assert_streq(a.get_id().to_string(), b.get_id().to_string());
+			assert_uinteq(a.mylane, b.mylane);
+			assert_lanes_equal(a.get_lanes(), b.get_lanes());
+		}
+	}
+
+	protected virtual signal void test_reload_incremental_new_commit()
+	{
+		var tip = d_history[d_history.length - 1];
+		var model = create_model(new Ggit.OId[] { tip });
+
+		run(model, false);
+		assert_uinteq(model.size(), HISTORY_LENGTH);
+
+		var started = 0;
+		model.started.connect(() => { started++; });
+
+		var include = new Ggit.OId[] {
+			create_commit("new", 1000 + HISTORY_LENGTH * 10, new Ggit.OId[] { tip })
+		};
+
+		model.set_include(include);
+		run(model, true);
+
+		// Only the new commit is walked again, the other rows are reused
+		assert_inteq(started, 0);
+		assert_uinteq(model.size(), HISTORY_LENGTH + 1);
+
+		assert_same_as_reload(model, include);
+	}
+
+	protected virtual signal void test_reload_incremental_force_push()
+	{
+		// A branch off an old commit, dated such that the walk only gets to
+		// it near the end of the history
+		var tip = d_history[d_history.length - 1];
+		var base_id = d_history[50];
+
+		var topic = create_commit("topic", 1000 + 50 * 10 + 5, new Ggit.OId[] { base_id });
+		var model = create_model(new Ggit.OId[] { tip, topic });
+
+		run(model, false);
+		assert_uinteq(model.size(), HISTORY_LENGTH + 1);
+
+		var started = 0;
+		model.started.connect(() => { started++; });
+
+		// Rewrite the branch, which changes the part of the walk after
+		// where the lanes converge
+		var include = new Ggit.OId[] {
+			tip,
+			create_commit("topic rewritten", 1000 + 50 * 10 + 5, new Ggit.OId[] { base_id })
+		};
+
+		model.set_include(include);
+		run(model, true);
+
+		assert_inteq(started, 1);
+		assert_uinteq(model.size(), HISTORY_LENGTH + 1);
+
+		assert_same_as_reload(model, include);
+	}
+
+	protected virtual signal void test_reload_incremental_new_branch()
+	{
+		var tip = d_history[d_history.length - 1];
+		var model = create_model(new Ggit.OId[] { tip });
+
+		run(model, false);
+
+		var include = new Ggit.OId[] {
+			tip,
+			create_commit("branch", 1000 + HISTORY_LENGTH * 10, new Ggit.OId[] { d_history[300] })
+		};
+
+		model.set_include(include);
+		run(model, true);
+
+		assert_uinteq(model.size(), HISTORY_LENGTH + 1);
+
+		assert_same_as_reload(model, include);
+	}
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,152 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.CommitSearchIndex : Gitg.Test.Repository
+{
+	private Gitg.Commit[] create_commits(string[] messages)
+	{
+		var ret = new Gitg.Commit[0];
+
+		try
+		{
+			var treeoid = d_repository.get_index().write_tree();
+			var tree = d_repository.lookup<Ggit.Tree>(treeoid);
+
+			var parents = new Ggit.Commit[0];
+
+			foreach (var message in messages)
+			{
+				var sig = get_verified_committer();
+
+				var id = d_repository.create_commit(null,
+				                                    sig,
+				                                    sig,
+				                                    null,
+				                                    message,
+				                                    tree,
+				                                    parents);
+
+				var commit = d_repository.lookup<Gitg.Commit>(id);
+
+				ret += commit;
+				parents = new Ggit.Commit[] { commit };
+			}
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+		}
+
+		return ret;
+	}
+
+	private string search(Gitg.CommitSearchIndex index, string key)
+	{
+		var loop = new MainLoop();
+		var ret = new StringBuilder();
+
+		index.search.begin(key, null, (obj, res) => {
+			foreach (var row in index.search.end(res))
+			{
+				if (ret.len != 0)
+				{
+					ret.append(",");
+				}
+
+				ret.append_printf("%u", row);
+			}
+
+			loop.quit();
+		});
+
+		loop.run();
+		return ret.str;
+	}
+
+	protected virtual signal void test_search()
+	{
+		var commits = create_commits({"Fix the lanes renderer",
+		                              "Add a search index",
+		                              "Speed up the LANES layout",
+		                              "Ünïcode subject"});
+
+		var index = new Gitg.CommitSearchIndex(d_repository);
+
+		for (var i = 0; i < commits.length; i++)
+		{
+			index.add(i, commits[i]);
+		}
+
+		assert_streq(search(index, "lanes"), "0,2");
+		assert_streq(search(index, "search"), "1");
+		assert_streq(search(index, "ünï"), "3");
+		assert_streq(search(index, "e"), "0,1,2,3");
+		assert_streq(search(index, "nothing"), "");
+
+		var prefix = commits[1].get_id().to_string().substring(0, 7);
+		assert_streq(search(index, prefix), "1");
+	}
+
+	protected virtual signal void test_search_long_message()
+	{
+		var body = string.nfill(10000, 'x');
+		var commits = create_commits({"Long message\n\n%s needle\n".printf(body),
+		                              "Short message"});
+
+		var index = new Gitg.CommitSearchIndex(d_repository);
+
+		for (var i = 0; i < commits.length; i++)
+		{
+			index.add(i, commits[i]);
+		}
+
+		// Matches at the end of long messages are found too
+		assert_streq(search(index, "needle"), "0");
+	}
+
+	protected virtual signal void test_splice()
+	{
+		var commits = create_commits({"first old", "second old", "third old"});
+		var index = new Gitg.CommitSearchIndex(d_repository);
+
+		for (var i = 0; i < commits.length; i++)
+		{
+			index.add(i, commits[i]);
+		}
+
+		// Replace the first row by two new ones
+		var added = create_commits({"new one", "new two"});
+		var head = new Gitg.CommitSearchIndex(d_repository);
+
+		for (var i = 0; i < added.length; i++)
+		{
+			head.add(i, added[i]);
+		}
+
+		index.splice(1, 2, commits.length, head);
+
+		assert_streq(search(index, "old"), "2,3");
+		assert_streq(search(index, "new"), "0,1");
+		assert_streq(search(index, "first"), "");
+	}
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,100 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.DiffImageCache : Gitg.Test.Test
+{
+	private Cairo.ImageSurface make_surface(int width, int height, uint32[] pixels)
+	{
+		var surface = new Cairo.ImageSurface(Cairo.Format.ARGB32, width, height);
+		surface.flush();
+
+		unowned uchar[] data = surface.get_data();
+
+		for (var y = 0; y < height; y++)
+		{
+			uint32 *row = (uint32 *)(&data[y * surface.get_stride()]);
+
+			for (var x = 0; x < width; x++)
+			{
+				row[x] = pixels[y * width + x];
+			}
+		}
+
+		surface.mark_dirty();
+		return surface;
+	}
+
+	private uint32 pixel(Cairo.ImageSurface surface, int x, int y)
+	{
+		surface.flush();
+
+		unowned uchar[] data = surface.get_data();
+		uint32 *row = (uint32 *)(&data[y * surface.get_stride()]);
+
+		return row[x];
+	}
+
+	protected virtual signal void test_levels()
+	{
+		assert_inteq(Gitg.DiffImageCache.level_size(1000, 0), 1000);
+		assert_inteq(Gitg.DiffImageCache.level_size(1000, 1), 500);
+		assert_inteq(Gitg.DiffImageCache.level_size(1001, 1), 501);
+		assert_inteq(Gitg.DiffImageCache.level_size(3, 4), 1);
+
+		// The smallest level at least as large as shown
+		assert_inteq(Gitg.DiffImageCache.level_for(1000, 1000), 0);
+		assert_inteq(Gitg.DiffImageCache.level_for(1000, 2000), 0);
+		assert_inteq(Gitg.DiffImageCache.level_for(1000, 500), 1);
+		assert_inteq(Gitg.DiffImageCache.level_for(1000, 499), 1);
+		assert_inteq(Gitg.DiffImageCache.level_for(8000, 900), 3);
+	}
+
+	protected virtual signal void test_difference()
+	{
+		var a = make_surface(2, 1, new uint32[] {0xff808080, 0xff000000});
+		var b = make_surface(1, 2, new uint32[] {0xff8040ff, 0xff102030});
+
+		var diff = Gitg.DiffImageCache.difference(a, b);
+
+		assert_inteq(diff.get_width(), 2);
+		assert_inteq(diff.get_height(), 2);
+
+		assert_uinteq(pixel(diff, 0, 0), 0xff00407f);
+
+		// Covered by only one of the images
+		assert_uinteq(pixel(diff, 1, 0), 0xff000000);
+		assert_uinteq(pixel(diff, 0, 1), 0xff102030);
+
+		// Covered by none
+		assert_uinteq(pixel(diff, 1, 1), 0);
+	}
+
+	protected virtual signal void test_difference_transparent()
+	{
+		var a = make_surface(1, 1, new uint32[] {0x00000000});
+		var b = make_surface(1, 1, new uint32[] {0x80402010});
+
+		// Nothing to subtract from, the other image is kept
+		assert_uinteq(pixel(Gitg.DiffImageCache.difference(a, b), 0, 0), 0x80402010);
+	}
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,104 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.DiffInline : Gitg.Test.Test
+{
+	private int diff_all(Gitg.DiffInline.Pair[] pairs, int64 budget, Cancellable? cancellable = null)
+	{
+		var loop = new MainLoop();
+		var done = 0;
+
+		Gitg.DiffInline.diff_all.begin(pairs, budget, cancellable, (obj, res) => {
+			done = Gitg.DiffInline.diff_all.end(res);
+			loop.quit();
+		});
+
+		loop.run();
+		return done;
+	}
+
+	private void assert_ranges(int[] ranges, int[] expected)
+	{
+		assert_inteq(ranges.length, expected.length);
+
+		for (var i = 0; i < ranges.length; i++)
+		{
+			assert_inteq(ranges[i], expected[i]);
+		}
+	}
+
+	protected virtual signal void test_ranges()
+	{
+		var pair = new Gitg.DiffInline.Pair("int foo = 1;", 0, "int bar = 10;", 1);
+
+		assert_inteq(diff_all(new Gitg.DiffInline.Pair[] { pair }, int64.MAX), 1);
+
+		assert_ranges(pair.old_ranges, new int[] { 4, 7, 10, 11 });
+		assert_ranges(pair.new_ranges, new int[] { 4, 7, 10, 12 });
+	}
+
+	protected virtual signal void test_ranges_multibyte()
+	{
+		// Offsets are in characters, not bytes
+		var pair = new Gitg.DiffInline.Pair("héllo wörld", 0, "héllo wörld ünd", 1);
+
+		assert_inteq(diff_all(new Gitg.DiffInline.Pair[] { pair }, int64.MAX), 1);
+
+		assert_ranges(pair.old_ranges, new int[0]);
+		assert_ranges(pair.new_ranges, new int[] { 11, 15 });
+
+		pair = new Gitg.DiffInline.Pair("ééé x", 0, "ééé y", 1);
+
+		assert_inteq(diff_all(new Gitg.DiffInline.Pair[] { pair }, int64.MAX), 1);
+
+		assert_ranges(pair.old_ranges, new int[] { 4, 5 });
+		assert_ranges(pair.new_ranges, new int[] { 4, 5 });
+	}
+
+	protected virtual signal void test_budget()
+	{
+		var pairs = new Gitg.DiffInline.Pair[] {
+			new Gitg.DiffInline.Pair("a b", 0, "a c", 1),
+			new Gitg.DiffInline.Pair("d e", 2, "d f", 3)
+		};
+
+		// Stops before the first pair once the budget is spent
+		assert_inteq(diff_all(pairs, -1), 0);
+
+		foreach (var pair in pairs)
+		{
+			assert_ranges(pair.old_ranges, new int[0]);
+			assert_ranges(pair.new_ranges, new int[0]);
+		}
+
+		var cancellable = new Cancellable();
+		cancellable.cancel();
+
+		assert_inteq(diff_all(pairs, int64.MAX, cancellable), 0);
+
+		assert_inteq(diff_all(pairs, int64.MAX), 2);
+
+		assert_ranges(pairs[0].old_ranges, new int[] { 2, 3 });
+		assert_ranges(pairs[1].new_ranges, new int[] { 2, 3 });
+	}
+}
+
+// ex:set ts=4 noet
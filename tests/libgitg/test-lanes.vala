@@ -0,0 +1,192 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.Lanes : Gitg.Test.Repository
+{
+	/**
+	 * Create a chain of commits, oldest first, without a branch.
+	 */
+	private Gitg.Commit[] create_chain(int n)
+	{
+		var ret = new Gitg.Commit[0];
+
+		try
+		{
+			var treeoid = d_repository.get_index().write_tree();
+			var tree = d_repository.lookup<Ggit.Tree>(treeoid);
+
+			var parents = new Ggit.Commit[0];
+
+			for (var i = 0; i < n; i++)
+			{
+				var sig = get_verified_committer();
+
+				var id = d_repository.create_commit(null,
+				                                    sig,
+				                                    sig,
+				                                    null,
+				                                    "commit %d".printf(i),
+				                                    tree,
+				                                    parents);
+
+				var commit = d_repository.lookup<Gitg.Commit>(id);
+
+				ret += commit;
+				parents = new Ggit.Commit[] { commit };
+			}
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * Lay out commits in the given order like the commit model does,
+	 * returning the commits in the order they were laid out.
+	 */
+	private Gee.ArrayList<Gitg.Commit> layout(Gitg.Lanes lanes, Gitg.Commit[] commits)
+	{
+		var ret = new Gee.ArrayList<Gitg.Commit>();
+
+		foreach (var commit in commits)
+		{
+			SList<Gitg.Lane> l;
+			int pos;
+
+			if (lanes.next(commit, out l, out pos, true))
+			{
+				ret.add(commit);
+			}
+
+			Gitg.Commit? miss;
+
+			while ((miss = lanes.next_unmissed()) != null)
+			{
+				if (lanes.next(miss, out l, out pos))
+				{
+					ret.add(miss);
+				}
+			}
+		}
+
+		return ret;
+	}
+
+	private Gee.HashSet<Ggit.OId> roots(Gitg.Commit commit)
+	{
+		var ret = new Gee.HashSet<Ggit.OId>((Gee.HashDataFunc<Ggit.OId>)Ggit.OId.hash,
+		                                    (Gee.EqualDataFunc<Ggit.OId>)Ggit.OId.equal);
+
+		ret.add(commit.get_id());
+		return ret;
+	}
+
+	/**
+	 * Commits seen before their children are laid out once the children
+	 * are, each one exactly once.
+	 */
+	protected virtual signal void test_missed_chain()
+	{
+		var commits = create_chain(2000);
+		var tip = commits[commits.length - 1];
+
+		var lanes = new Gitg.Lanes();
+		lanes.reset(null, roots(tip));
+
+		// Oldest first, so every commit but the tip is missed at first
+		var laid = layout(lanes, commits);
+
+		assert_inteq(laid.size, commits.length);
+		assert_uinteq(lanes.num_missed, 0);
+
+		for (var i = 0; i < laid.size; i++)
+		{
+			assert_streq(laid[i].get_id().to_string(),
+			             commits[commits.length - 1 - i].get_id().to_string());
+		}
+	}
+
+	/**
+	 * Commits which are not reachable from the roots stay missed.
+	 */
+	protected virtual signal void test_unreachable_missed()
+	{
+		var unreachable = create_chain(10);
+		var commits = create_chain(10);
+		var tip = commits[commits.length - 1];
+
+		var lanes = new Gitg.Lanes();
+		lanes.reset(null, roots(tip));
+
+		var order = new Gitg.Commit[0];
+
+		foreach (var commit in unreachable)
+		{
+			order += commit;
+		}
+
+		for (var i = commits.length - 1; i >= 0; i--)
+		{
+			order += commits[i];
+		}
+
+		var laid = layout(lanes, order);
+
+		assert_inteq(laid.size, commits.length);
+		assert_uinteq(lanes.num_missed, unreachable.length);
+	}
+
+	/**
+	 * Laying out the same commits gives the same state digest, and a
+	 * different layout state gives a different one.
+	 */
+	protected virtual signal void test_state_digest()
+	{
+		var commits = create_chain(10);
+		var tip = commits[commits.length - 1];
+
+		var order = new Gitg.Commit[0];
+
+		for (var i = commits.length - 1; i >= 5; i--)
+		{
+			order += commits[i];
+		}
+
+		var a = new Gitg.Lanes();
+		a.reset(null, roots(tip));
+		layout(a, order);
+
+		var b = new Gitg.Lanes();
+		b.reset(null, roots(tip));
+		layout(b, order);
+
+		assert_streq(a.state_digest(), b.state_digest());
+
+		layout(b, new Gitg.Commit[] { commits[4] });
+
+		assert(a.state_digest() != b.state_digest());
+	}
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,89 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.OIdTable : Gitg.Test.Test
+{
+	private Ggit.OId make_id(uint i)
+	{
+		var hex = Checksum.compute_for_string(ChecksumType.SHA1, "%u".printf(i));
+		return new Ggit.OId.from_string(hex);
+	}
+
+	protected virtual signal void test_set_lookup()
+	{
+		var table = new Gitg.OIdTable();
+		uint n = 10000;
+
+		// Enough entries to grow the table a few times
+		for (uint i = 0; i < n; i++)
+		{
+			table.set(make_id(i), i);
+		}
+
+		assert_uinteq(table.size, n);
+
+		for (uint i = 0; i < n; i++)
+		{
+			uint val;
+
+			assert(table.lookup(make_id(i), out val));
+			assert_uinteq(val, i);
+		}
+
+		assert(!table.contains(make_id(n)));
+	}
+
+	protected virtual signal void test_get_raw()
+	{
+		for (uint i = 0; i < 10; i++)
+		{
+			var id = make_id(i);
+			uint8 raw[Gitg.OIdTable.RAW_SIZE];
+
+			Gitg.OIdTable.get_raw(id, raw);
+
+			var hex = new StringBuilder();
+
+			foreach (var b in raw)
+			{
+				hex.append_printf("%02x", b);
+			}
+
+			assert_streq(hex.str, id.to_string());
+		}
+	}
+
+	protected virtual signal void test_replace()
+	{
+		var table = new Gitg.OIdTable();
+		var id = make_id(1);
+		uint val;
+
+		table.set(id, 1);
+		table.set(id, 2);
+
+		assert_uinteq(table.size, 1);
+		assert(table.lookup(id, out val));
+		assert_uinteq(val, 2);
+	}
+}
+
+// ex:set ts=4 noet
@@ -0,0 +1,114 @@
+/*
+ * This file is part of gitg
+ *
+ * Copyright (C) 2026 - gitg contributors
+ *
+ * gitg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gitg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gitg. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using Gitg.Test.Assert;
+
+class LibGitg.Test.Repository : Gitg.Test.Repository
+{
+	protected override void set_up()
+	{
+		base.set_up();
+
+		commit("a", "a\n");
+
+		create_branch("topic/one");
+		create_branch("topic/two");
+		create_branch("other");
+	}
+
+	protected virtual signal void test_refs_with_prefix()
+	{
+		var refs = d_repository.refs_with_prefix("refs/heads/topic/");
+
+		assert_inteq(refs.size, 2);
+		assert_streq(refs[0].get_name(), "refs/heads/topic/one");
+		assert_streq(refs[1].get_name(), "refs/heads/topic/two");
+	}
+
+	protected virtual signal void test_invalidate_refs()
+	{
+		var head = d_repository.get_head().get_target();
+
+		// Builds the cache
+		assert_inteq((int)d_repository.refs_for_id(head).length(), 4);
+
+		string[]? invalidated = null;
+
+		d_repository.refs_invalidated.connect((names) => {
+			invalidated = names;
+		});
+
+		commit("b", "b\n");
+
+		var newhead = d_repository.get_head().get_target();
+
+		try
+		{
+			lookup_branch("other").delete();
+		}
+		catch (Error e)
+		{
+			assert_no_error(e);
+		}
+
+		// topic/two did not change and is not reported
+		d_repository.invalidate_refs(new string[] {"refs/heads/master",
+		                                           "refs/heads/other",
+		                                           "refs/heads/topic/two"});
+
+		assert_inteq(invalidated.length, 2);
+		assert_streq(invalidated[0], "refs/heads/master");
+		assert_streq(invalidated[1], "refs/heads/other");
+
+		assert_inteq((int)d_repository.refs_for_id(head).length(), 2);
+		assert_inteq((int)d_repository.refs_for_id(newhead).length(), 1);
+
+		// Finds the change by comparing all refs
+		create_branch("new");
+		d_repository.invalidate_refs(null);
+
+		assert_inteq(invalidated.length, 1);
+		assert_streq(invalidated[0], "refs/heads/new");
+	}
+
+	protected virtual signal void test_invalidate_refs_new_directory()
+	{
+		var head = d_repository.get_head().get_target();
+
+		// Builds the cache
+		assert_inteq((int)d_repository.refs_for_id(head).length(), 4);
+
+		string[]? invalidated = null;
+
+		d_repository.refs_invalidated.connect((names) => {
+			invalidated = names;
+		});
+
+		// Only the new directory is reported, not the ref it contains
+		create_branch("a/b");
+		d_repository.invalidate_refs(new string[] {"refs/heads/a"});
+
+		assert_inteq(invalidated.length, 1);
+		assert_streq(invalidated[0], "refs/heads/a/b");
+
+		assert_inteq((int)d_repository.refs_for_id(head).length(), 5);
+	}
+}
+
+// ex:set ts=4 noet
@@ -91,6 +91,63 @@ class LibGitg.Test.Stage : Gitg.Test.Repository
 		loop.run();
 	}
 
+	private void check_items(Gitg.StageStatusItem[] items, Gee.HashMap<string, Ggit.StatusFlags> cfiles)
+	{
+		assert(items.length == cfiles.size);
+
+		foreach (var item in items)
+		{
+			var f = item as Gitg.StageStatusFile;
+
+			assert(cfiles.has_key(f.path));
+			assert_inteq(cfiles[f.path], f.flags);
+		}
+	}
+
+	/**
+	 * test updating the status cache for invalidated paths only.
+	 */
+	protected virtual signal void test_status_cache()
+	{
+		var cache = new Gitg.StageStatusCache(d_repository,
+		                                      Ggit.StatusOption.INCLUDE_UNTRACKED,
+		                                      Ggit.StatusShow.INDEX_AND_WORKDIR);
+
+		var loop = new MainLoop();
+
+		cache.update.begin((obj, res) => {
+			var m = new Gee.HashMap<string, Ggit.StatusFlags>();
+
+			m["a"] = Ggit.StatusFlags.WORKING_TREE_MODIFIED;
+			m["b"] = Ggit.StatusFlags.WORKING_TREE_MODIFIED | Ggit.StatusFlags.INDEX_MODIFIED;
+			m["c"] = Ggit.StatusFlags.WORKING_TREE_DELETED;
+
+			check_items(cache.update.end(res), m);
+
+			// Only a is updated, the change of b is not seen yet
+			workdir_modify("a", "hello world\n");
+			workdir_modify("b", "staged changes\n");
+
+			cache.invalidate_paths(new string[] {"a"});
+
+			cache.update.begin((obj, res) => {
+				m.unset("a");
+				check_items(cache.update.end(res), m);
+
+				cache.invalidate();
+
+				cache.update.begin((obj, res) => {
+					m["b"] = Ggit.StatusFlags.INDEX_MODIFIED;
+					check_items(cache.update.end(res), m);
+
+					loop.quit();
+				});
+			});
+		});
+
+		loop.run();
+	}
+
 	/**
 	 * test staging a complete file in the index.
 	 */
@@ -118,6 +175,77 @@ class LibGitg.Test.Stage : Gitg.Test.Repository
 		loop.run();
 	}
 
+	private Gitg.PatchSet patch_set(string filename, Gitg.PatchSet.Patch[] patches)
+	{
+		var ret = new Gitg.PatchSet();
+
+		ret.filename = filename;
+		ret.patches = patches;
+
+		return ret;
+	}
+
+	/**
+	 * test staging patches of several files in the index at once.
+	 */
+	protected virtual signal void test_stage_patches()
+	{
+		var stage = d_repository.stage;
+
+		var loop = new MainLoop();
+
+		// Stage all of a, and only the addition of the working directory
+		// content of b after its staged content
+		var patches = new Gitg.PatchSet[] {
+			patch_set("a", new Gitg.PatchSet.Patch[] {
+				Gitg.PatchSet.Patch() {
+					type = Gitg.PatchSet.Type.REMOVE,
+					old_offset = 0,
+					new_offset = 0,
+					length = 12
+				},
+				Gitg.PatchSet.Patch() {
+					type = Gitg.PatchSet.Type.ADD,
+					old_offset = 12,
+					new_offset = 0,
+					length = 14
+				}
+			}),
+			patch_set("b", new Gitg.PatchSet.Patch[] {
+				Gitg.PatchSet.Patch() {
+					type = Gitg.PatchSet.Type.ADD,
+					old_offset = 15,
+					new_offset = 0,
+					length = 13
+				}
+			})
+		};
+
+		stage.stage_patches.begin(patches, (obj, res) => {
+			try
+			{
+				stage.stage_patches.end(res);
+
+				var file = d_repository.get_workdir().get_child("b");
+				var entry = d_repository.get_index().get_entries().get_by_path(file, 0);
+				var blob = d_repository.lookup<Ggit.Blob>(entry.get_id());
+				unowned uint8[] content = blob.get_raw_content();
+
+				assert_streq(((string)content).ndup(content.length), "staged changes\nchanged test\n");
+			} catch (Error e) { Assert.assert_no_error(e); }
+
+			var m = new Gee.HashMap<string, Ggit.StatusFlags>();
+
+			m["a"] = Ggit.StatusFlags.INDEX_MODIFIED;
+			m["b"] = Ggit.StatusFlags.WORKING_TREE_MODIFIED | Ggit.StatusFlags.INDEX_MODIFIED;
+			m["c"] = Ggit.StatusFlags.WORKING_TREE_DELETED;
+
+			check_file_status(loop, m);
+		});
+
+		loop.run();
+	}
+
 	/**
 	 * test staging a complete file in the index.
 	 */
@@ -171,6 +299,53 @@ class LibGitg.Test.Stage : Gitg.Test.Repository
 		loop.run();
 	}
 
+	/**
+	 * test reverting patches of a file in the working directory which has
+	 * another hard link, and so is written in place.
+	 */
+	protected virtual signal void test_revert_patches_hard_link()
+	{
+		var stage = d_repository.stage;
+		var wd = d_repository.get_workdir();
+
+		var link = wd.get_child("a-link");
+		assert(Posix.link(wd.get_child("a").get_path(), link.get_path()) == 0);
+
+		var loop = new MainLoop();
+
+		// Revert all of a, back to its content in the index
+		var patches = new Gitg.PatchSet[] {
+			patch_set("a", new Gitg.PatchSet.Patch[] {
+				Gitg.PatchSet.Patch() {
+					type = Gitg.PatchSet.Type.REMOVE,
+					old_offset = 0,
+					new_offset = 0,
+					length = 12
+				},
+				Gitg.PatchSet.Patch() {
+					type = Gitg.PatchSet.Type.ADD,
+					old_offset = 12,
+					new_offset = 0,
+					length = 14
+				}
+			})
+		};
+
+		stage.revert_patches.begin(patches, (obj, res) => {
+			try
+			{
+				stage.revert_patches.end(res);
+			} catch (Error e) { Assert.assert_no_error(e); }
+
+			assert_file_contents("a", "hello world\n");
+			assert_file_contents("a-link", "hello world\n");
+
+			loop.quit();
+		});
+
+		loop.run();
+	}
+
 	/**
 	 * test deleting a file in the index.
 	 */